@@ -36,6 +36,7 @@
 
 #include "kis_selection.h"
 #include <kis_iterator_ng.h>
+#include <kis_gaussian_kernel.h>
 
 void KisBlurBenchmark::initTestCase()
 {
@@ -87,6 +88,30 @@ void KisBlurBenchmark::benchmarkFilter()
     }
 }
 
+void KisBlurBenchmark::benchmarkGaussianRadii_data()
+{
+    QTest::addColumn<qreal>("radius");
+
+    QTest::newRow("1") << 1.0;
+    QTest::newRow("5") << 5.0;
+    QTest::newRow("20") << 20.0;
+    QTest::newRow("50") << 50.0;
+    QTest::newRow("100") << 100.0;
+    QTest::newRow("200") << 200.0;
+    QTest::newRow("500") << 500.0;
+}
+
+void KisBlurBenchmark::benchmarkGaussianRadii()
+{
+    QFETCH(qreal, radius);
+
+    const QRect rect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+    const QBitArray channelFlags = m_colorSpace->channelFlags(true, true);
+
+    QBENCHMARK{
+        KisGaussianKernel::applyGaussian(m_device, rect, radius, radius, channelFlags, 0);
+    }
+}
 
 
 QTEST_MAIN(KisBlurBenchmark)
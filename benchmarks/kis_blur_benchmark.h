@@ -39,6 +39,9 @@ private Q_SLOTS:
     void cleanupTestCase();
     
     void benchmarkFilter();
+
+    void benchmarkGaussianRadii_data();
+    void benchmarkGaussianRadii();
     
 };
 
@@ -33,8 +33,12 @@
 #endif
 
 #include <KoOptimizedCompositeOpOver32.h>
+#include <KoOptimizedCompositeOpOver64.h>
 #include <KoOptimizedCompositeOpOver128.h>
 #include <KoOptimizedCompositeOpAlphaDarken32.h>
+#include <KoOptimizedCompositeOpAlphaDarken64.h>
+#include <KoOptimizedCompositeOpBlend32.h>
+#include <KoOptimizedCompositeOpBlend128.h>
 #endif
 
 #include "kis_composition_benchmark.h"
@@ -47,7 +51,12 @@
 #include <KoColorSpaceTraits.h>
 #include <KoCompositeOpAlphaDarken.h>
 #include <KoCompositeOpOver.h>
+#include <KoCompositeOpGeneric.h>
+#include <KoCompositeOpErase.h>
+#include <KoCompositeOpCopy2.h>
+#include <KoCompositeOpRegistry.h>
 #include "KoOptimizedCompositeOpFactory.h"
+#include "KoGenericBlendOpFactory.h"
 
 // for posix_memalign()
 #include <stdlib.h>
@@ -127,6 +136,27 @@ struct RandomGenerator<quint8>
     boost::mt11213b m_rnd;
 };
 
+template <>
+struct RandomGenerator<quint16>
+{
+    RandomGenerator(int seed)
+        : m_smallint(0,65535),
+          m_rnd(seed)
+    {
+    }
+
+    quint16 operator() () {
+        return m_smallint(m_rnd);
+    }
+
+    quint16 unit() {
+        return KoColorSpaceMathsTraits<quint16>::unitValue;
+    }
+
+    boost::uniform_smallint<int> m_smallint;
+    boost::mt11213b m_rnd;
+};
+
 template <>
 struct RandomGenerator<float>
 {
@@ -255,6 +285,8 @@ QVector<Tile> generateTiles(int size,
 
         if (pixelSize == 4) {
             generateDataLine<quint8>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
+        } else if (pixelSize == 8) {
+            generateDataLine<quint16>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else if (pixelSize == 16) {
             generateDataLine<float>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else {
@@ -322,7 +354,7 @@ bool compareTwoOpsPixels(QVector<Tile> &tiles, channel_type prec) {
     return true;
 }
 
-bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2)
+bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2, float floatPrecision = 2e-7)
 {
     Q_ASSERT(op1->colorSpace()->pixelSize() == op2->colorSpace()->pixelSize());
     const quint32 pixelSize = op1->colorSpace()->pixelSize();
@@ -354,8 +386,12 @@ bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp
     if (pixelSize == 4) {
         compareResult = compareTwoOpsPixels<quint8>(tiles, 10);
     }
+    else if (pixelSize == 8) {
+        // the same relative precision as for 8-bit pixels
+        compareResult = compareTwoOpsPixels<quint16>(tiles, 10 * 257);
+    }
     else if (pixelSize == 16) {
-        compareResult = compareTwoOpsPixels<float>(tiles, 2e-7);
+        compareResult = compareTwoOpsPixels<float>(tiles, floatPrecision);
     }
     else {
         qFatal("Pixel size %i is not implemented", pixelSize);
@@ -521,6 +557,19 @@ void checkRounding(qreal opacity, qreal flow, qreal averageOpacity = -1, quint32
                     }
                 }
             }
+            else if (pixelSize == 8) {
+                quint16 *d1 = reinterpret_cast<quint16*>(dst1);
+                quint16 *d2 = reinterpret_cast<quint16*>(dst2);
+
+                compareResult = comparePixels<quint16>(d1, d2, 0);
+                if (!compareResult) {
+                    ++errorcount;
+                    compareResult = comparePixels<quint16>(d1, d2, 1);
+                    if (!compareResult) {
+                        ++errorcount;
+                    }
+                }
+            }
             else if (pixelSize == 16) {
                 compareResult = comparePixels<float>(reinterpret_cast<float*>(dst1), reinterpret_cast<float*>(dst2), 0);
             }
@@ -638,6 +687,88 @@ void KisCompositionBenchmark::checkRoundingOverRgbaF32()
 #endif
 }
 
+void KisCompositionBenchmark::checkRoundingAlphaDarkenU16_05_03()
+{
+#ifdef HAVE_VC
+    checkRounding<AlphaDarkenCompositor64<quint16, quint64> >(0.5, 0.3, -1, 8);
+#endif
+}
+
+void KisCompositionBenchmark::checkRoundingAlphaDarkenU16_05_10_08()
+{
+#ifdef HAVE_VC
+    checkRounding<AlphaDarkenCompositor64<quint16, quint64> >(0.5, 1.0, 0.8, 8);
+#endif
+}
+
+void KisCompositionBenchmark::checkRoundingOverRgbaU16()
+{
+#ifdef HAVE_VC
+    checkRounding<OverCompositor64<quint16, quint64, false, true> >(0.5, 0.3, -1, 8);
+#endif
+}
+
+void KisCompositionBenchmark::checkRoundingBlendOps()
+{
+#ifdef HAVE_VC
+    using namespace KoStreamedMathFunctions;
+
+    checkRounding<GenericSCCompositor32<BlendMultiply<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendScreen<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendOverlay<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendHardLight<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendAddition<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendDarken<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendLighten<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendColorDodge<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<GenericSCCompositor32<BlendColorBurn<true> >::Compositor<false, true> >(0.5, 0.3);
+    checkRounding<EraseCompositor32<false, true> >(0.5, 0.3);
+    checkRounding<CopyCompositor32<false, true> >(0.5, 0.3);
+#endif
+}
+
+void KisCompositionBenchmark::checkRoundingBlendOpsRgbaF32()
+{
+#ifdef HAVE_VC
+    using namespace KoStreamedMathFunctions;
+
+    checkRounding<GenericSCCompositor128<BlendMultiply<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendScreen<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendOverlay<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendHardLight<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendAddition<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendDarken<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendLighten<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendColorDodge<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<GenericSCCompositor128<BlendColorBurn<false> >::Compositor<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<EraseCompositor128<false, true> >(0.5, 0.3, -1, 16);
+    checkRounding<CopyCompositor128<false, true> >(0.5, 0.3, -1, 16);
+#endif
+}
+
+void fillBlendOpsData(bool addMaskColumn)
+{
+    QTest::addColumn<QString>("id");
+    if (addMaskColumn) {
+        QTest::addColumn<bool>("haveMask");
+    }
+
+    QStringList ids;
+    ids << COMPOSITE_MULT << COMPOSITE_SCREEN << COMPOSITE_OVERLAY
+        << COMPOSITE_HARD_LIGHT << COMPOSITE_ADD << COMPOSITE_DARKEN
+        << COMPOSITE_LIGHTEN << COMPOSITE_DODGE << COMPOSITE_BURN
+        << COMPOSITE_ERASE << COMPOSITE_COPY;
+
+    Q_FOREACH (const QString &id, ids) {
+        if (addMaskColumn) {
+            QTest::newRow(QString("%1-mask").arg(id).toLatin1()) << id << true;
+            QTest::newRow(QString("%1-nomask").arg(id).toLatin1()) << id << false;
+        } else {
+            QTest::newRow(id.toLatin1()) << id;
+        }
+    }
+}
+
 void KisCompositionBenchmark::compareAlphaDarkenOps()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -710,6 +841,72 @@ void KisCompositionBenchmark::compareRgbF32OverOps()
     delete opAct;
 }
 
+void KisCompositionBenchmark::compareRgbU16AlphaDarkenOps()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(cs);
+    KoCompositeOp *opExp = new KoCompositeOpAlphaDarken<KoBgrU16Traits>(cs);
+
+    QVERIFY(compareTwoOps(true, opAct, opExp));
+
+    delete opExp;
+    delete opAct;
+}
+
+void KisCompositionBenchmark::compareRgbU16OverOps()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    KoCompositeOp *opExp = new KoCompositeOpOver<KoBgrU16Traits>(cs);
+
+    QVERIFY(compareTwoOps(true, opAct, opExp));
+    QVERIFY(compareTwoOps(false, opAct, opExp));
+
+    delete opExp;
+    delete opAct;
+}
+
+void KisCompositionBenchmark::compareBlendOps_data()
+{
+    fillBlendOpsData(true);
+}
+
+void KisCompositionBenchmark::compareBlendOps()
+{
+    QFETCH(QString, id);
+    QFETCH(bool, haveMask);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createBlendOp32(cs, id, id, KoCompositeOp::categoryMisc());
+    KoCompositeOp *opExp = createGenericBlendOp<KoBgrU8Traits>(cs, id, id, KoCompositeOp::categoryMisc());
+
+    QVERIFY(compareTwoOps(haveMask, opAct, opExp));
+
+    delete opExp;
+    delete opAct;
+}
+
+void KisCompositionBenchmark::compareRgbF32BlendOps_data()
+{
+    fillBlendOpsData(true);
+}
+
+void KisCompositionBenchmark::compareRgbF32BlendOps()
+{
+    QFETCH(QString, id);
+    QFETCH(bool, haveMask);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+    KoCompositeOp *opAct = KoOptimizedCompositeOpFactory::createBlendOp128(cs, id, id, KoCompositeOp::categoryMisc());
+    KoCompositeOp *opExp = createGenericBlendOp<KoRgbF32Traits>(cs, id, id, KoCompositeOp::categoryMisc());
+
+    // the legacy ops calculate in doubles, so the error is a bit higher
+    QVERIFY(compareTwoOps(haveMask, opAct, opExp, 1e-6));
+
+    delete opExp;
+    delete opAct;
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenLegacy()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -774,6 +971,98 @@ void KisCompositionBenchmark::testRgbF32CompositeOverOptimized()
     delete op;
 }
 
+void KisCompositionBenchmark::testRgbU16CompositeAlphaDarkenLegacy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *op = new KoCompositeOpAlphaDarken<KoBgrU16Traits>(cs);
+    benchmarkCompositeOp(op, "RGBU16 Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbU16CompositeAlphaDarkenOptimized()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(cs);
+    benchmarkCompositeOp(op, "RGBU16 Optimized");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbU16CompositeOverLegacy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *op = new KoCompositeOpOver<KoBgrU16Traits>(cs);
+    benchmarkCompositeOp(op, "RGBU16 Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbU16CompositeOverOptimized()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    benchmarkCompositeOp(op, "RGBU16 Optimized");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb8CompositeBlendLegacy_data()
+{
+    fillBlendOpsData(false);
+}
+
+void KisCompositionBenchmark::testRgb8CompositeBlendLegacy()
+{
+    QFETCH(QString, id);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *op = createGenericBlendOp<KoBgrU8Traits>(cs, id, id, KoCompositeOp::categoryMisc());
+    benchmarkCompositeOp(op, "Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb8CompositeBlendOptimized_data()
+{
+    fillBlendOpsData(false);
+}
+
+void KisCompositionBenchmark::testRgb8CompositeBlendOptimized()
+{
+    QFETCH(QString, id);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createBlendOp32(cs, id, id, KoCompositeOp::categoryMisc());
+    benchmarkCompositeOp(op, "Optimized");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeBlendLegacy_data()
+{
+    fillBlendOpsData(false);
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeBlendLegacy()
+{
+    QFETCH(QString, id);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+    KoCompositeOp *op = createGenericBlendOp<KoRgbF32Traits>(cs, id, id, KoCompositeOp::categoryMisc());
+    benchmarkCompositeOp(op, "RGBF32 Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeBlendOptimized_data()
+{
+    fillBlendOpsData(false);
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeBlendOptimized()
+{
+    QFETCH(QString, id);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createBlendOp128(cs, id, id, KoCompositeOp::categoryMisc());
+    benchmarkCompositeOp(op, "RGBF32 Optimized");
+    delete op;
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenReal_Aligned()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
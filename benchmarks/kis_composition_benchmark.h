@@ -39,12 +39,26 @@ private Q_SLOTS:
     void checkRoundingOver();
     void checkRoundingOverRgbaF32();
 
+    void checkRoundingAlphaDarkenU16_05_03();
+    void checkRoundingAlphaDarkenU16_05_10_08();
+    void checkRoundingOverRgbaU16();
+
+    void checkRoundingBlendOps();
+    void checkRoundingBlendOpsRgbaF32();
+
     void compareAlphaDarkenOps();
     void compareAlphaDarkenOpsNoMask();
     void compareRgbF32AlphaDarkenOps();
     void compareOverOps();
     void compareOverOpsNoMask();
     void compareRgbF32OverOps();
+    void compareRgbU16AlphaDarkenOps();
+    void compareRgbU16OverOps();
+
+    void compareBlendOps_data();
+    void compareBlendOps();
+    void compareRgbF32BlendOps_data();
+    void compareRgbF32BlendOps();
 
     void testRgb8CompositeAlphaDarkenLegacy();
     void testRgb8CompositeAlphaDarkenOptimized();
@@ -58,6 +72,22 @@ private Q_SLOTS:
     void testRgbF32CompositeOverLegacy();
     void testRgbF32CompositeOverOptimized();
 
+    void testRgbU16CompositeAlphaDarkenLegacy();
+    void testRgbU16CompositeAlphaDarkenOptimized();
+
+    void testRgbU16CompositeOverLegacy();
+    void testRgbU16CompositeOverOptimized();
+
+    void testRgb8CompositeBlendLegacy_data();
+    void testRgb8CompositeBlendLegacy();
+    void testRgb8CompositeBlendOptimized_data();
+    void testRgb8CompositeBlendOptimized();
+
+    void testRgbF32CompositeBlendLegacy_data();
+    void testRgbF32CompositeBlendLegacy();
+    void testRgbF32CompositeBlendOptimized_data();
+    void testRgbF32CompositeBlendOptimized();
+
     void testRgb8CompositeAlphaDarkenReal_Aligned();
     void testRgb8CompositeOverReal_Aligned();
 
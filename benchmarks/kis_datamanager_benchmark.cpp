@@ -20,7 +20,12 @@
 #include "kis_benchmark_values.h"
 
 #include <QTest>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QRadialGradient>
 #include <kis_datamanager.h>
+#include "tiles3/kis_tile.h"
+#include "tiles3/swap/kis_tile_compressor_2.h"
 
 // RGBA
 #define PIXEL_SIZE 4
@@ -198,5 +203,116 @@ void KisDatamanagerBenchmark::benchmarkMemCpy()
     delete[] dst;
 }
 
+void KisDatamanagerBenchmark::benchmarkTileCodecs_data()
+{
+    QTest::addColumn<int>("codec");
+
+    QTest::newRow("lzf") << int(KisTileCompressor2::LZF);
+    QTest::newRow("lz4") << int(KisTileCompressor2::LZ4);
+    QTest::newRow("zlib") << int(KisTileCompressor2::ZLIB);
+}
+
+/**
+ * Generates something resembling a real painting layer: smooth
+ * gradients, hard edged shapes, transparent areas and a bit of noise
+ */
+static void fillWithLayerLikeData(KisDataManager &dm, int width, int height)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+
+    QPainter gc(&image);
+    gc.setRenderHint(QPainter::Antialiasing);
+
+    QRadialGradient gradient(QPointF(0.4 * width, 0.4 * height), 0.5 * qMax(width, height));
+    gradient.setColorAt(0.0, QColor(250, 220, 180));
+    gradient.setColorAt(0.7, QColor(40, 90, 160, 200));
+    gradient.setColorAt(1.0, Qt::transparent);
+    gc.fillRect(QRect(0, 0, width, height / 2), gradient);
+
+    qsrand(0);
+    for (int i = 0; i < 200; i++) {
+        gc.setPen(QPen(QColor(qrand() % 256, qrand() % 256, qrand() % 256, 128 + qrand() % 128),
+                       1 + qrand() % 30, Qt::SolidLine, Qt::RoundCap));
+        gc.drawLine(qrand() % width, qrand() % height, qrand() % width, qrand() % height);
+    }
+    gc.end();
+
+    for (int y = height / 2; y < height * 5 / 8; y++) {
+        quint8 *line = image.scanLine(y);
+        for (int x = 0; x < width * 4; x++) {
+            line[x] = qBound(0, line[x] + qrand() % 9 - 4, 255);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        dm.writeBytes(image.constScanLine(y), 0, y, width, 1);
+    }
+}
+
+void KisDatamanagerBenchmark::benchmarkTileCodecs()
+{
+    QFETCH(int, codec);
+
+    quint8 defaultPixel[PIXEL_SIZE];
+    memset(defaultPixel, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, defaultPixel);
+    fillWithLayerLikeData(dm, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+
+    QVector<KisTileSP> tiles;
+    for (qint32 row = 0; row * KisTileData::HEIGHT < TEST_IMAGE_HEIGHT; row++) {
+        for (qint32 col = 0; col * KisTileData::WIDTH < TEST_IMAGE_WIDTH; col++) {
+            KisTileSP tile = dm.getTile(col, row, true);
+            tile->lockForWrite();
+            tiles << tile;
+        }
+    }
+
+    KisTileCompressor2 compressor((KisTileCompressor2::Codec)codec);
+    const qint32 bufferSize = compressor.tileDataBufferSize(tiles.first()->tileData());
+    QVector<QByteArray> buffers(tiles.size());
+    QVector<qint32> compressedSizes(tiles.size());
+
+    qint64 rawBytes = 0;
+    qint64 compressedBytes = 0;
+    qint64 compressionTime = 0;
+    qint64 decompressionTime = 0;
+    QElapsedTimer timer;
+
+    QBENCHMARK {
+        rawBytes = 0;
+        compressedBytes = 0;
+
+        timer.start();
+        for (int i = 0; i < tiles.size(); i++) {
+            buffers[i].resize(bufferSize);
+            compressor.compressTileData(tiles[i]->tileData(),
+                                        (quint8*)buffers[i].data(), bufferSize,
+                                        compressedSizes[i]);
+            rawBytes += tiles[i]->tileData()->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
+            compressedBytes += compressedSizes[i];
+        }
+        compressionTime = timer.nsecsElapsed();
+
+        timer.start();
+        for (int i = 0; i < tiles.size(); i++) {
+            compressor.decompressTileData((quint8*)buffers[i].data(),
+                                          compressedSizes[i],
+                                          tiles[i]->tileData());
+        }
+        decompressionTime = timer.nsecsElapsed();
+    }
+
+    const qreal mib = qreal(rawBytes) / (1024 * 1024);
+    qDebug() << KisTileCompressor2::codecName((KisTileCompressor2::Codec)codec)
+             << "ratio:" << qreal(rawBytes) / qMax(compressedBytes, qint64(1))
+             << "compress MiB/s:" << mib / qMax(qreal(compressionTime) / 1e9, 1e-9)
+             << "decompress MiB/s:" << mib / qMax(qreal(decompressionTime) / 1e9, 1e-9);
+
+    Q_FOREACH (KisTileSP tile, tiles) {
+        tile->unlock();
+    }
+}
+
 
 QTEST_MAIN(KisDatamanagerBenchmark)
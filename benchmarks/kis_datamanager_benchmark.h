@@ -36,6 +36,9 @@ private Q_SLOTS:
     void benchmarkExtent();
     void benchmarkClear();
     void benchmarkMemCpy();
+
+    void benchmarkTileCodecs_data();
+    void benchmarkTileCodecs();
 };
 
 #endif
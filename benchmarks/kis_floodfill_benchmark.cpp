@@ -32,6 +32,8 @@
 #include "kis_floodfill_benchmark.h"
 
 #include <kis_fill_painter.h>
+#include <kis_pixel_selection.h>
+#include <floodfill/kis_scanline_fill.h>
 
 #include <KoCompositeOps.h>
 
@@ -104,6 +106,30 @@ void KisFloodFillBenchmark::benchmarkFlood()
     //out.save("fill_output.png");
 }
 
+void KisFloodFillBenchmark::benchmarkFloodSelection_data()
+{
+    QTest::addColumn<bool>("useMultithreading");
+
+    QTest::newRow("single-threaded") << false;
+    QTest::newRow("multithreaded") << true;
+}
+
+void KisFloodFillBenchmark::benchmarkFloodSelection()
+{
+    QFETCH(bool, useMultithreading);
+
+    const QRect fillRect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+
+    QBENCHMARK
+    {
+        KisPixelSelectionSP pixelSelection = new KisPixelSelection();
+
+        KisScanlineFill gc(m_device, QPoint(1, 1), fillRect);
+        gc.setThreshold(15);
+        gc.setUseMultithreading(useMultithreading);
+        gc.fillSelection(pixelSelection);
+    }
+}
 
 void KisFloodFillBenchmark::cleanupTestCase()
 {
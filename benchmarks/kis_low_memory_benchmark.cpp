@@ -39,6 +39,9 @@
 #include "tiles3/kis_tile_data_store.h"
 #include "kis_surrogate_undo_adapter.h"
 #include "kis_image_config.h"
+
+#include <QElapsedTimer>
+#include <QThread>
 #define LOAD_PRESET_OR_RETURN(preset, fileName)                         \
     if(!preset->load()) { dbgKrita << "Preset" << fileName << "was NOT loaded properly. Done."; return; } \
     else dbgKrita << "Loaded preset:" << fileName
@@ -228,4 +231,118 @@ void KisLowMemoryBenchmark::memory2000History100Pool500HugeBrush()
                       2000, 600, 500, 0);
 }
 
+class SwapInThread : public QThread
+{
+public:
+    SwapInThread(const QList<KisPaintDeviceSP> &devices, const QRect &rc)
+        : m_devices(devices),
+          m_rect(rc)
+    {
+    }
+
+protected:
+    void run() override {
+        QVector<quint8> buffer(m_rect.width() * m_rect.height() * 4);
+
+        Q_FOREACH (KisPaintDeviceSP dev, m_devices) {
+            dev->readBytes(buffer.data(), m_rect);
+        }
+    }
+
+private:
+    QList<KisPaintDeviceSP> m_devices;
+    QRect m_rect;
+};
+
+/**
+ * Fills a set of devices with semi-random data, swaps all the tiles
+ * out and then reads the devices back from \p numThreads threads,
+ * so the tiles are swapped in concurrently. Swap-out is done by a
+ * single thread, like the swapper does it.
+ */
+void KisLowMemoryBenchmark::benchmarkSwapThroughput(int numThreads)
+{
+    const int numDevices = 16;
+    const QRect rc(0, 0, 1024, 2048);
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+
+    QVector<quint8> buffer(rc.width() * rc.height() * colorSpace->pixelSize());
+
+    /**
+     * Smooth gradients with some noise on top of them, so the
+     * compression ratio is close to the one of the real paintings
+     */
+    quint32 seed = 1;
+    for (int i = 0; i < buffer.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        buffer[i] = quint8((i / 4) % rc.width() / 8 + ((seed >> 16) & 0x7));
+    }
+
+    QList<KisPaintDeviceSP> devices;
+    for (int i = 0; i < numDevices; i++) {
+        KisPaintDeviceSP dev = new KisPaintDevice(colorSpace);
+        dev->writeBytes(buffer.data(), rc);
+        devices << dev;
+    }
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    const KisSwappedDataStore::Statistics statsBefore = store->swapStatistics();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    store->debugSwapAll();
+
+    const qint64 swapOutTime = qMax(qint64(1), timer.elapsed());
+
+    QList<SwapInThread*> threads;
+    for (int i = 0; i < numThreads; i++) {
+        QList<KisPaintDeviceSP> threadDevices;
+        for (int j = i; j < numDevices; j += numThreads) {
+            threadDevices << devices[j];
+        }
+        threads << new SwapInThread(threadDevices, rc);
+    }
+
+    timer.restart();
+
+    Q_FOREACH (SwapInThread *thread, threads) {
+        thread->start();
+    }
+
+    Q_FOREACH (SwapInThread *thread, threads) {
+        thread->wait();
+    }
+
+    const qint64 swapInTime = qMax(qint64(1), timer.elapsed());
+
+    qDeleteAll(threads);
+
+    const KisSwappedDataStore::Statistics statsAfter = store->swapStatistics();
+
+    const qreal swappedOutMiB = qreal(statsAfter.bytesSwappedOut - statsBefore.bytesSwappedOut) / MiB;
+    const qreal swappedInMiB = qreal(statsAfter.bytesSwappedIn - statsBefore.bytesSwappedIn) / MiB;
+
+    qDebug() << "Swap throughput:" << ppVar(numThreads) << ppVar(statsAfter.numShards);
+    qDebug() << "    swap out:" << swappedOutMiB << "MiB in" << swapOutTime << "ms"
+             << "(" << swappedOutMiB * 1000.0 / swapOutTime << "MiB/s )";
+    qDebug() << "    swap in: " << swappedInMiB << "MiB in" << swapInTime << "ms"
+             << "(" << swappedInMiB * 1000.0 / swapInTime << "MiB/s )";
+}
+
+void KisLowMemoryBenchmark::swapThroughput1Thread()
+{
+    benchmarkSwapThroughput(1);
+}
+
+void KisLowMemoryBenchmark::swapThroughput4Threads()
+{
+    benchmarkSwapThroughput(4);
+}
+
+void KisLowMemoryBenchmark::swapThroughput16Threads()
+{
+    benchmarkSwapThroughput(16);
+}
+
 QTEST_MAIN(KisLowMemoryBenchmark)
@@ -31,6 +31,10 @@ private Q_SLOTS:
 
     void memory2000History100Pool500HugeBrush();
 
+    void swapThroughput1Thread();
+    void swapThroughput4Threads();
+    void swapThroughput16Threads();
+
 private:
     void benchmarkWideArea(const QString presetFileName,
                            const QRectF &rect, qreal vstep,
@@ -40,6 +44,8 @@ private:
                            int softLimitMiB,
                            int poolLimitMiB,
                            int index);
+
+    void benchmarkSwapThroughput(int numThreads);
 };
 
 #endif /* __KIS_LOW_MEMORY_BENCHMARK_H */
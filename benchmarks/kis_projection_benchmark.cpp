@@ -27,6 +27,7 @@
 #include <KisDocument.h>
 #include <kis_image.h>
 #include <KisPart.h>
+#include <kis_image_config.h>
 
 void KisProjectionBenchmark::initTestCase()
 {
@@ -38,8 +39,22 @@ void KisProjectionBenchmark::cleanupTestCase()
 }
 
 
+void KisProjectionBenchmark::benchmarkProjection_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("8 threads") << 8;
+    QTest::newRow("32 threads") << 32;
+}
+
 void KisProjectionBenchmark::benchmarkProjection()
 {
+    QFETCH(int, numThreads);
+
+    const int oldNumThreads = KisImageConfig(true).maxNumberOfThreads();
+    KisImageConfig().setMaxNumberOfThreads(numThreads);
+
     KisDocument *doc = KisPart::instance()->createDocument();
     doc->loadNativeFormat(QString(FILES_DATA_DIR) + QDir::separator() + "load_test.kra");
 
@@ -52,6 +67,8 @@ void KisProjectionBenchmark::benchmarkProjection()
     }
 
     delete doc;
+
+    KisImageConfig().setMaxNumberOfThreads(oldNumThreads);
 }
 
 void KisProjectionBenchmark::benchmarkLoading()
@@ -30,6 +30,7 @@ private Q_SLOTS:
     void initTestCase();
     void cleanupTestCase();
 
+    void benchmarkProjection_data();
     void benchmarkProjection();
     void benchmarkLoading();
 };
@@ -48,12 +48,33 @@ inline double drand48()
 #define GMP_IMAGE_HEIGHT 2067
 #include <kis_painter.h>
 #include <brushengine/kis_paintop_registry.h>
+#include <brushengine/kis_paintop.h>
+#include <kis_simple_stroke_strategy.h>
+#include <kis_image_config.h>
+#include <kis_global.h>
+#include <kis_distance_information.h>
+
+#include <QThreadPool>
+#include <QElapsedTimer>
 
 //#define SAVE_OUTPUT
 
 static const int LINES = 20;
 const QString OUTPUT_FORMAT = ".png";
 
+/**
+ * Prints how well the dab cache of the current paintop performed
+ * during the benchmark
+ */
+static void printDabCacheStatistics(KisPainter *painter)
+{
+    KisPaintOp *paintOp = painter->paintOp();
+    if (!paintOp || paintOp->dabCacheHitRate() < 0) return;
+
+    qDebug() << "dab cache hit rate:" << paintOp->dabCacheHitRate()
+             << "dab generation time (ms):" << 1e-6 * paintOp->dabGenerationTime();
+}
+
 void KisStrokeBenchmark::initTestCase()
 {
     m_dataPath = QString(FILES_DATA_DIR) + QDir::separator();
@@ -376,6 +397,8 @@ inline void KisStrokeBenchmark::benchmarkLine(QString presetFileName)
         m_painter->paintLine(pi1, pi2, &currentDistance);
     }
 
+    printDabCacheStatistics(m_painter);
+
 #ifdef SAVE_OUTPUT
     m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + presetFileName + "_line" + OUTPUT_FORMAT);
 #endif
@@ -427,6 +450,8 @@ QBENCHMARK{
     }
 }
 
+    printDabCacheStatistics(m_painter);
+
 #ifdef SAVE_OUTPUT
     m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + presetFileName + "_circle" + OUTPUT_FORMAT);
 #endif
@@ -457,6 +482,8 @@ void KisStrokeBenchmark::benchmarkRandomLines(QString presetFileName)
         }
     }
 
+    printDabCacheStatistics(m_painter);
+
 #ifdef SAVE_OUTPUT
     m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + presetFileName + "_randomLines" + OUTPUT_FORMAT);
 #endif
@@ -481,6 +508,8 @@ void KisStrokeBenchmark::benchmarkStroke(QString presetFileName)
         m_painter->paintBezierCurve(m_pi2, m_c2, m_c2, m_pi3, &currentDistance);
     }
 
+    printDabCacheStatistics(m_painter);
+
 #ifdef SAVE_OUTPUT
     dbgKrita << "Saving output " << m_outputPath + presetFileName + ".png";
     m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + presetFileName + OUTPUT_FORMAT);
@@ -523,5 +552,147 @@ void KisStrokeBenchmark::becnhmarkPresetCloning()
     }
 }
 
+class ConcurrentFillStrokeStrategy : public KisSimpleStrokeStrategy
+{
+public:
+    class Data : public KisStrokeJobData {
+    public:
+        Data(const QRect &_rect)
+            : KisStrokeJobData(KisStrokeJobData::CONCURRENT),
+              rect(_rect)
+        {
+        }
+
+        QRect rect;
+    };
+
+public:
+    ConcurrentFillStrokeStrategy(KisPaintDeviceSP device, const KoColor &color)
+        : KisSimpleStrokeStrategy("concurrent_fill_stroke"),
+          m_device(device),
+          m_color(color)
+    {
+        enableJob(JOB_DOSTROKE, true, KisStrokeJobData::CONCURRENT);
+    }
+
+    void doStrokeCallback(KisStrokeJobData *data) override {
+        Data *d = dynamic_cast<Data*>(data);
+        KIS_ASSERT_RECOVER_RETURN(d);
+
+        m_device->fill(d->rect, m_color);
+    }
+
+private:
+    KisPaintDeviceSP m_device;
+    KoColor m_color;
+};
+
+void KisStrokeBenchmark::benchmarkConcurrentStrokeJobs_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("8 threads") << 8;
+    QTest::newRow("32 threads") << 32;
+}
+
+/**
+ * Measures the overhead of the scheduler and the updater context
+ * on a lot of small concurrent jobs, like the ones generated by
+ * a brush stroke
+ */
+void KisStrokeBenchmark::benchmarkConcurrentStrokeJobs()
+{
+    QFETCH(int, numThreads);
+
+    const int oldNumThreads = KisImageConfig(true).maxNumberOfThreads();
+    KisImageConfig().setMaxNumberOfThreads(numThreads);
+
+    KisImageSP image = new KisImage(0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT,
+                                    m_colorSpace, "concurrent jobs image");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8, m_colorSpace);
+    image->addNode(layer);
+
+    const int patchSize = 64;
+
+    QBENCHMARK {
+        KisStrokeId id = image->startStroke(
+            new ConcurrentFillStrokeStrategy(layer->paintDevice(),
+                                             KoColor(Qt::red, m_colorSpace)));
+
+        for (int y = 0; y < TEST_IMAGE_HEIGHT; y += patchSize) {
+            for (int x = 0; x < TEST_IMAGE_WIDTH; x += patchSize) {
+                image->addJob(id, new ConcurrentFillStrokeStrategy::Data(
+                                  QRect(x, y, patchSize, patchSize)));
+            }
+        }
+
+        image->endStroke(id);
+        image->waitForDone();
+    }
+
+    KisImageConfig().setMaxNumberOfThreads(oldNumThreads);
+}
+
+void KisStrokeBenchmark::benchmarkParallelDabs_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("16 threads") << 16;
+}
+
+/**
+ * Measures the throughput of the brush op when the masks of the dabs
+ * are generated concurrently. The dabs are generated in the global
+ * thread pool, so its size defines the number of the dabs generated
+ * at once.
+ */
+void KisStrokeBenchmark::benchmarkParallelDabs()
+{
+    QFETCH(int, numThreads);
+
+    const int oldNumThreads = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(m_dataPath + "autobrush_300px.kpp");
+    preset->load();
+    m_painter->setPaintOpPreset(preset, m_layer, m_image);
+
+    QPointF startPoint(0.10 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+    QPointF endPoint(0.90 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+
+    KisPaintInformation pi1(startPoint, 1.0);
+    KisPaintInformation pi2(endPoint, 1.0);
+
+    int numDabs = 0;
+    qint64 totalTime = 0;
+
+    QBENCHMARK {
+        KisDistanceInformation currentDistance;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        m_painter->paintLine(pi1, pi2, &currentDistance);
+
+        totalTime += timer.nsecsElapsed();
+
+        // the pressure is constant, so is the spacing
+        numDabs += qRound(kisDistance(startPoint, endPoint) /
+                          currentDistance.currentSpacing().scalarApprox());
+    }
+
+    if (totalTime > 0) {
+        qDebug() << numThreads << "threads:"
+                 << qRound(numDabs * 1e9 / totalTime) << "dabs/s";
+    }
+
+    printDabCacheStatistics(m_painter);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(oldNumThreads);
+}
+
 
 QTEST_MAIN(KisStrokeBenchmark)
@@ -128,6 +128,12 @@ private Q_SLOTS:
     void benchmarkRand48();
 
     void becnhmarkPresetCloning();
+
+    void benchmarkConcurrentStrokeJobs_data();
+    void benchmarkConcurrentStrokeJobs();
+
+    void benchmarkParallelDabs_data();
+    void benchmarkParallelDabs();
 };
 
 #endif
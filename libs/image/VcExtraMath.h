@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VCEXTRAMATH_H
+#define VCEXTRAMATH_H
+
+#include <config-vc.h>
+
+#if defined HAVE_VC
+
+#include <Vc/Vc>
+
+/**
+ * Math functions that Vc doesn't provide, but the vectorized
+ * mask generators need
+ */
+class VcExtraMath
+{
+public:
+    /**
+     * Vectorized version of the error function, the polynomial
+     * approximation 7.1.26 from Abramowitz and Stegun. Its maximum
+     * absolute error is 1.5e-7, which is below the precision of
+     * the float arithmetic we use for the masks.
+     */
+    static inline Vc::float_v erf(const Vc::float_v &x) {
+        const Vc::float_v p(0.3275911f);
+        const Vc::float_v a1(0.254829592f);
+        const Vc::float_v a2(-0.284496736f);
+        const Vc::float_v a3(1.421413741f);
+        const Vc::float_v a4(-1.453152027f);
+        const Vc::float_v a5(1.061405429f);
+        const Vc::float_v vOne(Vc::One);
+
+        // erf(x) is 1.0 in float precision for |x| > 4, clamping
+        // protects exp() from underflowing into denormals
+        Vc::float_v xa = Vc::min(Vc::abs(x), Vc::float_v(9.0f));
+        Vc::float_v t = vOne / (vOne + p * xa);
+        Vc::float_v poly = ((((a5 * t + a4) * t + a3) * t + a2) * t + a1) * t;
+        Vc::float_v y = vOne - poly * Vc::exp(-xa * xa);
+
+        // erf() is an odd function
+        y(x < Vc::float_v(Vc::Zero)) = -y;
+
+        return y;
+    }
+};
+
+#endif /* defined HAVE_VC */
+
+#endif // VCEXTRAMATH_H
@@ -92,6 +92,23 @@ public:
         return true;
     }
 
+    /**
+     * The share of the dabs taken from the dab cache of the paintop
+     * without generating a new mask, or -1 if the paintop has no
+     * cache. Used for benchmarking.
+     */
+    virtual qreal dabCacheHitRate() const {
+        return -1.0;
+    }
+
+    /**
+     * Total time spent by the paintop on generating the masks of
+     * the dabs, in nanoseconds. Used for benchmarking.
+     */
+    virtual qint64 dabGenerationTime() const {
+        return 0;
+    }
+
     /**
      * Split the coordinate into whole + fraction, where fraction is always >= 0.
      */
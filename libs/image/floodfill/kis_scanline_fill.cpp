@@ -20,7 +20,17 @@
 
 #include <KoAlwaysInline.h>
 
+#include <functional>
+
 #include <QStack>
+#include <QQueue>
+#include <QHash>
+#include <QBitArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <qmath.h>
 #include <KoColor.h>
 #include <KoColorSpace.h>
 #include <KoCompositeOpRegistry.h>
@@ -262,6 +272,249 @@ public:
     }
 };
 
+/**
+ * Fills the contiguous area using several threads. The bounding rect
+ * is split into the tiles of the source device and every tile is
+ * processed by a single thread at a time, reading the pixels through
+ * plain row pointers. The intervals leaving a tile are passed to the
+ * neighbouring tile through the shared queue of pending tiles.
+ *
+ * The source device must not be changed by the policy, then the
+ * result is the same 4-connected area the sequential fill produces.
+ */
+template <class Policy>
+class TiledFillRunner
+{
+    struct TileState {
+        TileState() : isQueued(false), isBusy(false) {}
+
+        QVector<KisFillInterval> pendingIntervals;
+        QBitArray filledPixels;
+        bool isQueued;
+        bool isBusy;
+    };
+
+    struct WorkerWrapper {
+        WorkerWrapper(TiledFillRunner *runner) : m_runner(runner) {}
+
+        inline void operator() (int) {
+            m_runner->workerLoop();
+        }
+
+        TiledFillRunner *m_runner;
+    };
+
+public:
+    typedef std::function<Policy*()> PolicyFactory;
+
+    TiledFillRunner(KisPaintDeviceSP device, const QRect &boundingRect, PolicyFactory policyFactory)
+        : m_device(device),
+          m_boundingRect(boundingRect),
+          m_policyFactory(policyFactory),
+          m_numBusyTiles(0)
+    {
+    }
+
+    ~TiledFillRunner() {
+        qDeleteAll(m_tiles);
+    }
+
+    void run(const QPoint &startPoint) {
+        addInterval(KisFillInterval(startPoint.x(), startPoint.x(), startPoint.y()));
+
+        QVector<int> workers(qMax(1, QThreadPool::globalInstance()->maxThreadCount()));
+        QtConcurrent::blockingMap(workers, WorkerWrapper(this));
+    }
+
+private:
+    static const int tileSize = 64;
+
+    inline QPoint tileIndex(int x, int y) const {
+        return QPoint(qFloor(qreal(x - m_device->x()) / tileSize),
+                      qFloor(qreal(y - m_device->y()) / tileSize));
+    }
+
+    inline QRect tileRect(const QPoint &index) const {
+        return QRect(m_device->x() + index.x() * tileSize,
+                     m_device->y() + index.y() * tileSize,
+                     tileSize, tileSize) & m_boundingRect;
+    }
+
+    static inline quint64 tileKey(const QPoint &index) {
+        return (quint64(quint32(index.x())) << 32) | quint32(index.y());
+    }
+
+    /**
+     * Should be called with m_mutex held. The interval must lie
+     * inside a single tile.
+     */
+    void addInterval(const KisFillInterval &interval) {
+        const QPoint index = tileIndex(interval.start, interval.row);
+        const quint64 key = tileKey(index);
+
+        TileState *tile = m_tiles.value(key, 0);
+        if (!tile) {
+            tile = new TileState();
+            m_tiles.insert(key, tile);
+        }
+
+        tile->pendingIntervals.append(interval);
+
+        if (!tile->isQueued && !tile->isBusy) {
+            tile->isQueued = true;
+            m_readyTiles.enqueue(index);
+            m_condition.wakeOne();
+        }
+    }
+
+    void workerLoop() {
+        QScopedPointer<Policy> policy(m_policyFactory());
+        QVector<quint8> pixels;
+        QVector<KisFillInterval> outgoingIntervals;
+
+        QMutexLocker l(&m_mutex);
+
+        forever {
+            while (m_readyTiles.isEmpty() && m_numBusyTiles > 0) {
+                m_condition.wait(&m_mutex);
+            }
+
+            if (m_readyTiles.isEmpty()) {
+                m_condition.wakeAll();
+                return;
+            }
+
+            const QPoint index = m_readyTiles.dequeue();
+            TileState *tile = m_tiles.value(tileKey(index));
+
+            tile->isQueued = false;
+            tile->isBusy = true;
+            m_numBusyTiles++;
+
+            QVector<KisFillInterval> intervals;
+            std::swap(intervals, tile->pendingIntervals);
+
+            const QRect rect = tileRect(index);
+            if (tile->filledPixels.isEmpty()) {
+                tile->filledPixels.resize(rect.width() * rect.height());
+            }
+
+            l.unlock();
+
+            outgoingIntervals.clear();
+            processTile(rect, intervals, &tile->filledPixels, &pixels, &outgoingIntervals, *policy);
+
+            l.relock();
+
+            Q_FOREACH (const KisFillInterval &interval, outgoingIntervals) {
+                addInterval(interval);
+            }
+
+            tile->isBusy = false;
+            m_numBusyTiles--;
+
+            if (!tile->pendingIntervals.isEmpty()) {
+                tile->isQueued = true;
+                m_readyTiles.enqueue(index);
+            }
+
+            m_condition.wakeAll();
+        }
+    }
+
+    void processTile(const QRect &rect,
+                     const QVector<KisFillInterval> &intervals,
+                     QBitArray *filledPixels,
+                     QVector<quint8> *pixels,
+                     QVector<KisFillInterval> *outgoingIntervals,
+                     Policy &policy) {
+
+        const int pixelSize = m_device->pixelSize();
+        const int rowStride = rect.width() * pixelSize;
+
+        pixels->resize(rect.height() * rowStride);
+        m_device->readBytes(pixels->data(), rect);
+
+        QStack<KisFillInterval> stack;
+        Q_FOREACH (const KisFillInterval &interval, intervals) {
+            stack.push(interval);
+        }
+
+        while (!stack.isEmpty()) {
+            const KisFillInterval interval = stack.pop();
+            const int y = interval.row;
+            const int localY = y - rect.y();
+
+            quint8 *rowPtr = pixels->data() + localY * rowStride - rect.x() * pixelSize;
+            const int filledRowOffset = localY * rect.width() - rect.x();
+
+            auto tryFill = [&] (int x) {
+                if (filledPixels->testBit(filledRowOffset + x)) return false;
+
+                quint8 *pixelPtr = rowPtr + x * pixelSize;
+                const quint8 opacity = policy.calculateOpacity(pixelPtr);
+                if (!opacity) return false;
+
+                filledPixels->setBit(filledRowOffset + x);
+                policy.fillPixel(pixelPtr, opacity, x, y);
+                return true;
+            };
+
+            int x = interval.start;
+
+            while (x <= interval.end) {
+                if (!tryFill(x)) {
+                    x++;
+                    continue;
+                }
+
+                int left = x;
+                while (left > rect.left() && tryFill(left - 1)) {
+                    left--;
+                }
+
+                int right = x;
+                while (right < rect.right() && tryFill(right + 1)) {
+                    right++;
+                }
+
+                if (left == rect.left() && left > m_boundingRect.left()) {
+                    outgoingIntervals->append(KisFillInterval(left - 1, left - 1, y));
+                }
+
+                if (right == rect.right() && right < m_boundingRect.right()) {
+                    outgoingIntervals->append(KisFillInterval(right + 1, right + 1, y));
+                }
+
+                for (int nextRow = y - 1; nextRow <= y + 1; nextRow += 2) {
+                    if (nextRow < m_boundingRect.top() || nextRow > m_boundingRect.bottom()) continue;
+
+                    const KisFillInterval nextInterval(left, right, nextRow);
+
+                    if (nextRow >= rect.top() && nextRow <= rect.bottom()) {
+                        stack.push(nextInterval);
+                    } else {
+                        outgoingIntervals->append(nextInterval);
+                    }
+                }
+
+                x = right + 1;
+            }
+        }
+    }
+
+private:
+    KisPaintDeviceSP m_device;
+    QRect m_boundingRect;
+    PolicyFactory m_policyFactory;
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QHash<quint64, TileState*> m_tiles;
+    QQueue<QPoint> m_readyTiles;
+    int m_numBusyTiles;
+};
+
 struct Q_DECL_HIDDEN KisScanlineFill::Private
 {
     KisPaintDeviceSP device;
@@ -269,6 +522,7 @@ struct Q_DECL_HIDDEN KisScanlineFill::Private
     QPoint startPoint;
     QRect boundingRect;
     int threshold;
+    bool useMultithreading;
 
     int rowIncrement;
     KisFillIntervalMap backwardMap;
@@ -298,6 +552,7 @@ KisScanlineFill::KisScanlineFill(KisPaintDeviceSP device, const QPoint &startPoi
     m_d->rowIncrement = 1;
 
     m_d->threshold = 0;
+    m_d->useMultithreading = true;
 }
 
 KisScanlineFill::~KisScanlineFill()
@@ -309,6 +564,11 @@ void KisScanlineFill::setThreshold(int threshold)
     m_d->threshold = threshold;
 }
 
+void KisScanlineFill::setUseMultithreading(bool value)
+{
+    m_d->useMultithreading = value;
+}
+
 template <class T>
 void KisScanlineFill::extendedPass(KisFillInterval *currentInterval, int srcRow, bool extendRight, T &pixelPolicy)
 {
@@ -541,6 +801,39 @@ void KisScanlineFill::fillColor(const KoColor &fillColor, KisPaintDeviceSP exter
     }
 }
 
+template <class DifferencePolicy>
+void KisScanlineFill::fillSelectionImpl(const KoColor &srcColor, KisPixelSelectionSP pixelSelection)
+{
+    typedef SelectionPolicy<true, DifferencePolicy, CopyToSelection> Policy;
+
+    /**
+     * Splitting small areas into tiles costs more than it gains
+     */
+    const int minMultithreadedArea = 256 * 256;
+
+    if (m_d->useMultithreading &&
+        m_d->boundingRect.contains(m_d->startPoint) &&
+        m_d->boundingRect.width() * m_d->boundingRect.height() >= minMultithreadedArea) {
+
+        KisPaintDeviceSP device = m_d->device;
+        const int threshold = m_d->threshold;
+
+        TiledFillRunner<Policy> runner(device, m_d->boundingRect,
+            [device, srcColor, threshold, pixelSelection] () {
+                Policy *policy = new Policy(device, srcColor, threshold);
+                policy->setDestinationSelection(pixelSelection);
+                return policy;
+            });
+
+        runner.run(m_d->startPoint);
+
+    } else {
+        Policy policy(m_d->device, srcColor, m_d->threshold);
+        policy.setDestinationSelection(pixelSelection);
+        runImpl(policy);
+    }
+}
+
 void KisScanlineFill::fillSelection(KisPixelSelectionSP pixelSelection)
 {
     KisRandomConstAccessorSP it = m_d->device->createRandomConstAccessorNG(m_d->startPoint.x(), m_d->startPoint.y());
@@ -549,30 +842,15 @@ void KisScanlineFill::fillSelection(KisPixelSelectionSP pixelSelection)
     const int pixelSize = m_d->device->pixelSize();
 
     if (pixelSize == 1) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint8>, CopyToSelection>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        fillSelectionImpl<DifferencePolicyOptimized<quint8>>(srcColor, pixelSelection);
     } else if (pixelSize == 2) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint16>, CopyToSelection>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        fillSelectionImpl<DifferencePolicyOptimized<quint16>>(srcColor, pixelSelection);
     } else if (pixelSize == 4) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint32>, CopyToSelection>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        fillSelectionImpl<DifferencePolicyOptimized<quint32>>(srcColor, pixelSelection);
     } else if (pixelSize == 8) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint64>, CopyToSelection>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        fillSelectionImpl<DifferencePolicyOptimized<quint64>>(srcColor, pixelSelection);
     } else {
-        SelectionPolicy<true, DifferencePolicySlow, CopyToSelection>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        fillSelectionImpl<DifferencePolicySlow>(srcColor, pixelSelection);
     }
 }
 
@@ -64,6 +64,12 @@ public:
      */
     void setThreshold(int threshold);
 
+    /**
+     * When enabled (default), fillSelection() processes big areas
+     * in several threads. The result is the same in both modes.
+     */
+    void setUseMultithreading(bool value);
+
 private:
     friend class KisScanlineFillTest;
     Q_DISABLE_COPY(KisScanlineFill)
@@ -78,6 +84,9 @@ private:
     template <class T>
     void runImpl(T &pixelPolicy);
 
+    template <class DifferencePolicy>
+    void fillSelectionImpl(const KoColor &srcColor, KisPixelSelectionSP pixelSelection);
+
 private:
     void testingProcessLine(const KisFillInterval &processInterval);
     QVector<KisFillInterval> testingGetForwardIntervals() const;
@@ -21,6 +21,8 @@
 
 #include "kis_global.h"
 
+#include <compositeops/KoVcMultiArchBuildSupport.h>
+
 template <class BaseFade>
 class KisAntialiasingFadeMaker1D
 {
@@ -83,6 +85,36 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of needFade(). Returns the mask of the
+     * lanes that need fading and writes their normalized fade
+     * value (0.0 is opaque, 1.0 is transparent) into \p value
+     */
+    inline Vc::float_m needFade(const Vc::float_v &dist, Vc::float_v &value) const {
+        const Vc::float_v vOne(Vc::One);
+        const Vc::float_v vRadius(m_radius);
+
+        Vc::float_m outsideMask = dist > vRadius;
+        Vc::float_m fadeMask = outsideMask;
+
+        if (m_enableAntialiasing) {
+            const Vc::float_v vFadeStart(m_antialiasingFadeStart);
+            const Vc::float_v vFadeStartValue(m_fadeStartValue);
+            const Vc::float_v vFadeCoeff(m_antialiasingFadeCoeff);
+            const Vc::float_v vValMaxRec(1.0f / 255.0f);
+
+            Vc::float_m antialiasingMask = dist > vFadeStart;
+            value(antialiasingMask) = (vFadeStartValue + (dist - vFadeStart) * vFadeCoeff) * vValMaxRec;
+            fadeMask |= antialiasingMask;
+        }
+
+        value(outsideMask) = vOne;
+
+        return fadeMask;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_radius;
     quint8 m_fadeStartValue;
@@ -174,6 +206,51 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of needFade(). On entry \p value should
+     * contain the normalized base fade of the lanes (0.0 is opaque,
+     * 1.0 is transparent). The lanes that need antialiasing get it
+     * faded further, the lanes outside the limits get 1.0. Returns
+     * the mask of the modified lanes.
+     */
+    inline Vc::float_m needFade(const Vc::float_v &xr, const Vc::float_v &yr, Vc::float_v &value) const {
+        const Vc::float_v vOne(Vc::One);
+
+        Vc::float_v x = Vc::abs(xr);
+        Vc::float_v y = Vc::abs(yr);
+
+        Vc::float_m outsideMask = (x > Vc::float_v(m_xLimit)) || (y > Vc::float_v(m_yLimit));
+        Vc::float_m fadeMask = outsideMask;
+
+        if (m_enableAntialiasing) {
+            const Vc::float_v vXFadeLimitStart(m_xFadeLimitStart);
+            const Vc::float_v vYFadeLimitStart(m_yFadeLimitStart);
+
+            Vc::float_m xFadeMask = x > vXFadeLimitStart;
+            Vc::float_m yFadeMask = y > vYFadeLimitStart;
+
+            Vc::float_v xWeight = (x - vXFadeLimitStart) * Vc::float_v(m_xFadeCoeff);
+            Vc::float_v yWeight = (y - vYFadeLimitStart) * Vc::float_v(m_yFadeCoeff);
+            xWeight.setZero(!xFadeMask);
+            yWeight.setZero(!yFadeMask);
+
+            /**
+             * Applying the two fades one after another is equivalent
+             * to multiplying their opacities, so the order used by
+             * the scalar version doesn't matter
+             */
+            Vc::float_m antialiasingMask = xFadeMask || yFadeMask;
+            value(antialiasingMask) = vOne - (vOne - value) * (vOne - xWeight) * (vOne - yWeight);
+            fadeMask |= antialiasingMask;
+        }
+
+        value(outsideMask) = vOne;
+
+        return fadeMask;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_xLimit;
     qreal m_yLimit;
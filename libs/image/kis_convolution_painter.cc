@@ -60,6 +60,8 @@
 
 template<class factory>
 KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConvolutionKernelSP kernel,
+                                                                   const KisPaintDeviceSP src,
+                                                                   const QSize &areaSize,
                                                                    KisPainter *painter,
                                                                    KoUpdater *progress)
 {
@@ -68,6 +70,14 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
 #ifdef HAVE_FFTW3
     #define THRESHOLD_SIZE 5
 
+    /**
+     * Areas bigger than that are convolved in parallel blocks, which
+     * also keeps the memory consumption bounded. The blocks read their
+     * neighbourhood while the others already write their results, so
+     * the source device must not be the destination one.
+     */
+    #define TILED_THRESHOLD_AREA (1024 * 1024)
+
     if(m_enginePreference == SPATIAL ||
        (m_enginePreference != FFTW &&
         kernel->width() <= THRESHOLD_SIZE &&
@@ -76,10 +86,18 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
         worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
     }
     else {
-        worker = new KisConvolutionWorkerFFT<factory>(painter, progress);
+        const bool tiled =
+            m_enginePreference == FFTW_TILED ||
+            (m_enginePreference == NONE &&
+             src != painter->device() &&
+             areaSize.width() * areaSize.height() > TILED_THRESHOLD_AREA);
+
+        worker = new KisConvolutionWorkerFFT<factory>(painter, progress, tiled);
     }
 #else
     Q_UNUSED(kernel);
+    Q_UNUSED(src);
+    Q_UNUSED(areaSize);
     worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
 #endif
 
@@ -141,7 +159,7 @@ void KisConvolutionPainter::applyMatrix(const KisConvolutionKernelSP kernel, con
 
         if(dataRect.isValid()) {
             KisConvolutionWorker<RepeatIteratorFactory> *worker;
-            worker = createWorker<RepeatIteratorFactory>(kernel, this, progressUpdater());
+            worker = createWorker<RepeatIteratorFactory>(kernel, src, areaSize, this, progressUpdater());
             worker->execute(kernel, src, srcPos, dstPos, areaSize, dataRect);
             delete worker;
         }
@@ -150,7 +168,7 @@ void KisConvolutionPainter::applyMatrix(const KisConvolutionKernelSP kernel, con
     case BORDER_IGNORE:
     default: {
         KisConvolutionWorker<StandardIteratorFactory> *worker;
-        worker = createWorker<StandardIteratorFactory>(kernel, this, progressUpdater());
+        worker = createWorker<StandardIteratorFactory>(kernel, src, areaSize, this, progressUpdater());
         worker->execute(kernel, src, srcPos, dstPos, areaSize, QRect());
         delete worker;
     }
@@ -72,7 +72,8 @@ protected:
     enum TestingEnginePreference {
         NONE,
         SPATIAL,
-        FFTW
+        FFTW,
+        FFTW_TILED
     };
 
 
@@ -82,6 +83,8 @@ protected:
 private:
     template<class factory>
         KisConvolutionWorker<factory>* createWorker(const KisConvolutionKernelSP kernel,
+                                                    const KisPaintDeviceSP src,
+                                                    const QSize &areaSize,
                                                     KisPainter *painter,
                                                     KoUpdater *progress);
 
@@ -29,9 +29,12 @@
 
 #include <QMutex>
 #include <QVector>
+#include <QHash>
+#include <QAtomicInt>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrent>
 
 #include <fftw3.h>
 
@@ -41,6 +44,44 @@ class KisConvolutionWorkerFFTLock
 private:
     static QMutex fftwMutex;
     template<class _IteratorFactory_> friend class KisConvolutionWorkerFFT;
+
+    struct Plans {
+        fftw_plan forward;
+        fftw_plan backward;
+    };
+
+    /**
+     * The plans of the tiled mode are created once per FFT size and
+     * are never destroyed. FFTW allows executing one plan on different
+     * arrays from several threads at once, so the mutex is held only
+     * for a lookup. The wisdom gathered by FFTW_MEASURE is kept by
+     * FFTW itself, so it is reused by all the calls.
+     */
+    static Plans squarePlans(int size) {
+        static QHash<int, Plans> plans;
+
+        QMutexLocker l(&fftwMutex);
+
+        auto it = plans.constFind(size);
+        if (it != plans.constEnd()) {
+            return *it;
+        }
+
+        fftw_complex *scratch =
+            (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * size * (size / 2 + 1));
+
+        // measuring big transforms takes too long for a single filter run
+        const unsigned flags = size <= 1024 ? FFTW_MEASURE : FFTW_ESTIMATE;
+
+        Plans newPlans;
+        newPlans.forward = fftw_plan_dft_r2c_2d(size, size, (double*)scratch, scratch, flags);
+        newPlans.backward = fftw_plan_dft_c2r_2d(size, size, scratch, (double*)scratch, flags);
+
+        fftw_free(scratch);
+
+        plans.insert(size, newPlans);
+        return newPlans;
+    }
 };
 
 QMutex KisConvolutionWorkerFFTLock::fftwMutex;
@@ -50,10 +91,17 @@ template<class _IteratorFactory_>
 class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
 {
 public:
-    KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress)
+    /**
+     * In \p tiled mode the area is split into blocks of a fixed size,
+     * which are convolved in parallel (overlap-save). The memory used
+     * depends only on the size of the kernel and the number of
+     * threads, not on the size of the area.
+     */
+    KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress, bool tiled = false)
         : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
           m_currentProgress(0),
-          m_kernelFFT(0)
+          m_kernelFFT(0),
+          m_tiled(tiled)
     {
     }
 
@@ -76,6 +124,11 @@ public:
         if (areaSize.width() == 0 || areaSize.height() == 0)
             return;
 
+        if (m_tiled) {
+            executeTiled(kernel, src, srcPos, dstPos, areaSize, dataRect);
+            return;
+        }
+
         addToProgress(0);
         if (isInterrupted()) return;
 
@@ -120,7 +173,7 @@ public:
                                   m_fftWidth,
                                   m_fftHeight),
                             cacheRowStride,
-                            info, dataRect);
+                            info, dataRect, m_channelFFT);
 
         addToProgress(10);
         if (isInterrupted()) return;
@@ -161,12 +214,66 @@ public:
 
         writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
                             cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
+                            info, dataRect, m_channelFFT);
 
         addToProgress(20);
         cleanUp();
     }
 
+    void executeTiled(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect)
+    {
+        if (this->m_progress) {
+            this->m_progress->setProgress(0);
+        }
+
+        const int halfKernelWidth = (kernel->width() - 1) / 2;
+        const int halfKernelHeight = (kernel->height() - 1) / 2;
+
+        const int fftSize = tiledFFTSize(kernel);
+
+        m_fftWidth = fftSize;
+        m_fftHeight = fftSize;
+        m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
+        m_extraMem = 2;
+
+        const KisConvolutionWorkerFFTLock::Plans plans =
+            KisConvolutionWorkerFFTLock::squarePlans(fftSize);
+
+        // the transformed kernel is shared by all the tiles
+        m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+        memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
+        fftFillKernelMatrix(kernel, m_kernelFFT);
+        fftw_execute_dft_r2c(plans.forward, (double*)m_kernelFFT, m_kernelFFT);
+
+        QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
+
+        const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
+        const double fftScale = 1.0 / (m_fftHeight * m_fftWidth) / kernelFactor;
+
+        FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
+
+        const int tileWidth = fftSize - 2 * halfKernelWidth;
+        const int tileHeight = fftSize - 2 * halfKernelHeight;
+
+        QVector<QRect> tiles;
+        for (int y = 0; y < areaSize.height(); y += tileHeight) {
+            for (int x = 0; x < areaSize.width(); x += tileWidth) {
+                tiles << QRect(x, y,
+                               qMin(tileWidth, areaSize.width() - x),
+                               qMin(tileHeight, areaSize.height() - y));
+            }
+        }
+
+        TileContext context(plans, info, src, srcPos, dstPos, dataRect,
+                            halfKernelWidth, halfKernelHeight, tiles.size());
+
+        TileWrapper wrapper(this, &context);
+        QtConcurrent::blockingMap(tiles, wrapper);
+
+        fftw_free(m_kernelFFT);
+        m_kernelFFT = 0;
+    }
+
     struct FFTInfo {
         FFTInfo(qreal _fftScale,
                 const QList<KoChannelInfo*> &_convChannelList,
@@ -218,11 +325,107 @@ public:
         int alphaRealPos;
     };
 
+    struct TileContext {
+        TileContext(const KisConvolutionWorkerFFTLock::Plans &_plans,
+                    const FFTInfo &_info,
+                    KisPaintDeviceSP _src,
+                    const QPoint &_srcPos,
+                    const QPoint &_dstPos,
+                    const QRect &_dataRect,
+                    int _halfKernelWidth,
+                    int _halfKernelHeight,
+                    int _numTiles)
+            : plans(_plans),
+              info(_info),
+              src(_src),
+              srcPos(_srcPos),
+              dstPos(_dstPos),
+              dataRect(_dataRect),
+              halfKernelWidth(_halfKernelWidth),
+              halfKernelHeight(_halfKernelHeight),
+              numTiles(_numTiles)
+        {
+        }
+
+        const KisConvolutionWorkerFFTLock::Plans plans;
+        const FFTInfo &info;
+        KisPaintDeviceSP src;
+        const QPoint srcPos;
+        const QPoint dstPos;
+        const QRect dataRect;
+        const int halfKernelWidth;
+        const int halfKernelHeight;
+        const int numTiles;
+        QAtomicInt tilesDone;
+    };
+
+    struct TileWrapper {
+        TileWrapper(KisConvolutionWorkerFFT *worker, TileContext *context)
+            : m_worker(worker), m_context(context) {}
+
+        inline void operator() (const QRect &tile) {
+            m_worker->processTile(tile, m_context);
+        }
+
+        KisConvolutionWorkerFFT *m_worker;
+        TileContext *m_context;
+    };
+
+    /**
+     * Convolves one block of the area, \p tile is relative to the
+     * top-left corner of the area. Is called from several threads
+     * at once, so it may access only the members that are not
+     * changed after executeTiled() has started the jobs.
+     */
+    void processTile(const QRect &tile, TileContext *context)
+    {
+        if (this->m_progress && this->m_progress->interrupted()) return;
+
+        const TileContext &c = *context;
+
+        QVector<fftw_complex*> channelFFT(c.info.numChannels());
+        for (auto i = channelFFT.begin(); i != channelFFT.end(); ++i) {
+            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+
+            // the tiles at the border are smaller than the transform
+            memset(*i, 0, sizeof(fftw_complex) * m_fftLength);
+        }
+
+        const int cacheRowStride = m_fftWidth + m_extraMem;
+
+        fillCacheFromDevice(c.src,
+                            QRect(c.srcPos + tile.topLeft() - QPoint(c.halfKernelWidth, c.halfKernelHeight),
+                                  tile.size() + QSize(2 * c.halfKernelWidth, 2 * c.halfKernelHeight)),
+                            cacheRowStride,
+                            c.info, c.dataRect, channelFFT);
+
+        for (auto k = channelFFT.begin(); k != channelFFT.end(); ++k) {
+            fftw_execute_dft_r2c(c.plans.forward, (double*)(*k), *k);
+            fftMultiply(*k, m_kernelFFT);
+            fftw_execute_dft_c2r(c.plans.backward, *k, (double*)*k);
+        }
+
+        writeResultToDevice(QRect(c.dstPos + tile.topLeft(), tile.size()),
+                            cacheRowStride, c.halfKernelWidth, c.halfKernelHeight,
+                            c.info, c.dataRect, channelFFT);
+
+        Q_FOREACH (fftw_complex *channel, channelFFT) {
+            fftw_free(channel);
+        }
+
+        const int tilesDone = context->tilesDone.fetchAndAddOrdered(1) + 1;
+
+        if (this->m_progress) {
+            this->m_progress->setProgress(100 * tilesDone / c.numTiles);
+        }
+    }
+
     void fillCacheFromDevice(KisPaintDeviceSP src,
                              const QRect &rect,
                              const int cacheRowStride,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineConstIterator hitSrc =
             _IteratorFactory_::createHLineConstIterator(src,
@@ -234,7 +437,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt;
         }
@@ -313,7 +516,8 @@ public:
                              const int halfKernelWidth,
                              const int halfKernelHeight,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineIterator hitDst =
             _IteratorFactory_::createHLineIterator(this->m_painter->device(),
@@ -327,7 +531,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt + initialOffset;
         }
@@ -400,6 +604,24 @@ public:
     }
 
 private:
+    /**
+     * The side of the square transform used by the tiled mode. It is
+     * a power of two, so that FFTW is fast and only a few plans are
+     * ever created, and at least four times bigger than the kernel,
+     * so that most of every transform produces useful pixels.
+     */
+    static int tiledFFTSize(const KisConvolutionKernelSP kernel)
+    {
+        const int kernelSize = qMax(kernel->width(), kernel->height());
+
+        int fftSize = 512;
+        while (fftSize < 4 * (kernelSize - 1)) {
+            fftSize *= 2;
+        }
+
+        return fftSize;
+    }
+
     void fftFillKernelMatrix(const KisConvolutionKernelSP kernel, fftw_complex *m_kernelFFT)
     {
         // find central item
@@ -536,6 +758,8 @@ private:
 
     fftw_complex* m_kernelFFT;
     QVector<fftw_complex*> m_channelFFT;
+
+    bool m_tiled;
 };
 
 #endif
@@ -29,7 +29,8 @@
  */
 class KRITAIMAGE_EXPORT KisGaussRectangleMaskGenerator : public KisMaskGenerator
 {
-
+public:
+    struct FastRowProcessor;
 public:
 
     KisGaussRectangleMaskGenerator(qreal diameter, qreal ratio, qreal fh, qreal fv, int spikes, bool antialiasEdges);
@@ -38,6 +39,11 @@ public:
     KisMaskGenerator* clone() const override;
 
     quint8 valueAt(qreal x, qreal y) const override;
+
+    bool shouldVectorize() const override;
+
+    KisBrushMaskApplicatorBase* applicator() override;
+
     void setScale(qreal scaleX, qreal scaleY) override;
 
 private:
@@ -21,6 +21,8 @@
 #include "kis_global.h"
 #include "kis_convolution_kernel.h"
 #include <kis_convolution_painter.h>
+#include "kis_stacked_box_blur.h"
+#include "kis_default_bounds_base.h"
 #include <QRect>
 
 
@@ -105,6 +107,26 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
                                       const QBitArray &channelFlags,
                                       KoUpdater *progressUpdater)
 {
+    /**
+     * The cost of the convolution grows linearly with the size of the
+     * kernel, so for big radii we use the box blur approximation,
+     * whose cost doesn't depend on the radius. It reads the same
+     * (or smaller) area around the rect, so neededRect()/changeRect()
+     * of the callers stay valid. The wraparound mode is not supported
+     * by it, so we fall back to the convolution in that case.
+     */
+    const int boxBlurThreshold = 41;
+
+    if (qMax(kernelSizeFromRadius(xRadius), kernelSizeFromRadius(yRadius)) >= boxBlurThreshold &&
+        !device->defaultBounds()->wrapAroundMode()) {
+
+        KisStackedBoxBlur::applyGaussian(device, rect,
+                                         xRadius > 0.0 ? sigmaFromRadius(xRadius) : 0.0,
+                                         yRadius > 0.0 ? sigmaFromRadius(yRadius) : 0.0,
+                                         channelFlags, progressUpdater);
+        return;
+    }
+
     QPoint srcTopLeft = rect.topLeft();
 
     if (xRadius > 0.0 && yRadius > 0.0) {
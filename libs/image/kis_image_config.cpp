@@ -132,6 +132,19 @@ void KisImageConfig::setSchedulerBalancingRatio(qreal value)
     m_config.writeEntry("schedulerBalancingRatio", value);
 }
 
+int KisImageConfig::maxNumberOfThreads(bool requestDefault) const
+{
+    const int defaultValue = qMax(1, QThread::idealThreadCount());
+
+    return !requestDefault ?
+        m_config.readEntry("maxNumberOfThreads", defaultValue) : defaultValue;
+}
+
+void KisImageConfig::setMaxNumberOfThreads(int value)
+{
+    m_config.writeEntry("maxNumberOfThreads", value);
+}
+
 int KisImageConfig::maxSwapSize(bool requestDefault) const
 {
     return !requestDefault ?
@@ -163,6 +176,61 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+int KisImageConfig::swapShardsCount(bool requestDefault) const
+{
+    /**
+     * Every shard has its own swap file and compressor, so there is
+     * no point in having more shards than the number of threads
+     * that can access the swap simultaneously.
+     */
+    const int defaultValue = qBound(1, QThread::idealThreadCount(), 16);
+
+    return !requestDefault ?
+        m_config.readEntry("swapShardsCount", defaultValue) : defaultValue;
+}
+
+void KisImageConfig::setSwapShardsCount(int value)
+{
+    m_config.writeEntry("swapShardsCount", value);
+}
+
+QString KisImageConfig::swapCompressionCodec(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("swapCompressionCodec", "LZ4") : "LZ4";
+}
+
+void KisImageConfig::setSwapCompressionCodec(const QString &value)
+{
+    m_config.writeEntry("swapCompressionCodec", value);
+}
+
+QString KisImageConfig::tilesCompressionCodec(bool requestDefault) const
+{
+    /**
+     * LZF is the only codec older versions of Krita can read,
+     * so keep it as a default one
+     */
+    return !requestDefault ?
+        m_config.readEntry("tilesCompressionCodec", "LZF") : "LZF";
+}
+
+void KisImageConfig::setTilesCompressionCodec(const QString &value)
+{
+    m_config.writeEntry("tilesCompressionCodec", value);
+}
+
+bool KisImageConfig::lazyTilesLoading(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("lazyTilesLoading", true) : true;
+}
+
+void KisImageConfig::setLazyTilesLoading(bool value)
+{
+    m_config.writeEntry("lazyTilesLoading", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
@@ -186,6 +254,13 @@ int KisImageConfig::poolLimit() const
     return totalRAM() * hp * pp;
 }
 
+int KisImageConfig::historyLimit() const
+{
+    qreal hp = qreal(memoryHistoryLimitPercent()) / 100.0;
+
+    return tilesHardLimit() * hp;
+}
+
 qreal KisImageConfig::memoryHardLimitPercent(bool requestDefault) const
 {
     return !requestDefault ?
@@ -219,6 +294,39 @@ void KisImageConfig::setMemoryPoolLimitPercent(qreal value)
     m_config.writeEntry("memoryPoolLimitPercent", value);
 }
 
+bool KisImageConfig::enableTileDataDeduplication(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("enableTileDataDeduplication", true) : true;
+}
+
+void KisImageConfig::setEnableTileDataDeduplication(bool value)
+{
+    m_config.writeEntry("enableTileDataDeduplication", value);
+}
+
+qreal KisImageConfig::memoryHistoryLimitPercent(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("memoryHistoryLimitPercent", 25.) : 25.;
+}
+
+void KisImageConfig::setMemoryHistoryLimitPercent(qreal value)
+{
+    m_config.writeEntry("memoryHistoryLimitPercent", value);
+}
+
+int KisImageConfig::historyRevisionsInMemory(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("historyRevisionsInMemory", 3) : 3;
+}
+
+void KisImageConfig::setHistoryRevisionsInMemory(int value)
+{
+    m_config.writeEntry("historyRevisionsInMemory", value);
+}
+
 QString KisImageConfig::swapDir(bool requestDefault)
 {
     QString swap = QDir::tempPath();
@@ -453,3 +561,14 @@ void KisImageConfig::setUseLodForColorizeMask(bool value)
 {
     m_config.writeEntry("useLodForColorizeMask", value);
 }
+
+bool KisImageConfig::useIncrementalColorizeMask(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useIncrementalColorizeMask", true) : true;
+}
+
+void KisImageConfig::setUseIncrementalColorizeMask(bool value)
+{
+    m_config.writeEntry("useIncrementalColorizeMask", value);
+}
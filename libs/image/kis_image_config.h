@@ -49,6 +49,9 @@ public:
     qreal schedulerBalancingRatio() const;
     void setSchedulerBalancingRatio(qreal value);
 
+    int maxNumberOfThreads(bool requestDefault = false) const;
+    void setMaxNumberOfThreads(int value);
+
     int maxSwapSize(bool requestDefault = false) const;
     void setMaxSwapSize(int value);
 
@@ -58,19 +61,53 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    int swapShardsCount(bool requestDefault = false) const;
+    void setSwapShardsCount(int value);
+
+    /**
+     * Names of the codecs used for compressing tiles in the swap
+     * and in the saved files, see KisTileCompressor2::codecName()
+     */
+    QString swapCompressionCodec(bool requestDefault = false) const;
+    void setSwapCompressionCodec(const QString &value);
+
+    QString tilesCompressionCodec(bool requestDefault = false) const;
+    void setTilesCompressionCodec(const QString &value);
+
+    bool lazyTilesLoading(bool requestDefault = false) const;
+    void setLazyTilesLoading(bool value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
+    int historyLimit() const; // MiB
 
     qreal memoryHardLimitPercent(bool requestDefault = false) const; // % of total RAM
     qreal memorySoftLimitPercent(bool requestDefault = false) const; // % of memoryHardLimitPercent() * (1 - 0.01 * memoryPoolLimitPercent())
     qreal memoryPoolLimitPercent(bool requestDefault = false) const; // % of memoryHardLimitPercent()
+    qreal memoryHistoryLimitPercent(bool requestDefault = false) const; // % of tilesHardLimit()
     void setMemoryHardLimitPercent(qreal value);
     void setMemorySoftLimitPercent(qreal value);
     void setMemoryPoolLimitPercent(qreal value);
+    void setMemoryHistoryLimitPercent(qreal value);
+
+    /**
+     * The number of the most recent undo revisions of a paint device,
+     * that are kept in memory as long as possible. The tiles of the
+     * older revisions are swapped out (and compressed) first.
+     */
+    int historyRevisionsInMemory(bool requestDefault = false) const;
+    void setHistoryRevisionsInMemory(int value);
 
     static int totalRAM(); // MiB
 
+    /**
+     * Share the memory of the tiles with identical content
+     * (e.g. in different layers or in the undo history)
+     */
+    bool enableTileDataDeduplication(bool requestDefault = false) const;
+    void setEnableTileDataDeduplication(bool value);
+
     /**
      * @return a specific directory for the swapfile, if set. If not set, return an
      * empty QString and use the default KDE directory.
@@ -111,6 +148,9 @@ public:
     bool useLodForColorizeMask(bool requestDefault = false) const;
     void setUseLodForColorizeMask(bool value);
 
+    bool useIncrementalColorizeMask(bool requestDefault = false) const;
+    void setUseIncrementalColorizeMask(bool value);
+
 
 private:
     Q_DISABLE_COPY(KisImageConfig)
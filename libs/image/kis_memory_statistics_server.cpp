@@ -24,6 +24,8 @@
 #include "kis_image.h"
 #include "kis_image_config.h"
 #include "kis_signal_compressor.h"
+#include "kis_paint_device.h"
+#include "kis_datamanager.h"
 
 #include "tiles3/kis_tile_data_store.h"
 
@@ -98,6 +100,29 @@ qint64 calculateNodeMemoryHiBound(KisNodeSP node)
     return calculateNodeMemoryHiBoundStep(node, devices);
 }
 
+void collectLayersHistory(KisNodeSP node,
+                          QVector<KisMemoryStatisticsServer::LayerHistoryStatistics> &layersHistory)
+{
+    KisPaintDeviceSP dev = node->paintDevice();
+
+    if (dev) {
+        KisMemoryStatisticsServer::LayerHistoryStatistics layerStats;
+        dev->dataManager()->calculateHistorySize(layerStats.memorySize,
+                                                 layerStats.swappedSize);
+
+        if (layerStats.memorySize || layerStats.swappedSize) {
+            layerStats.name = node->name();
+            layersHistory.append(layerStats);
+        }
+    }
+
+    node = node->firstChild();
+    while (node) {
+        collectLayersHistory(node, layersHistory);
+        node = node->nextSibling();
+    }
+}
+
 
 KisMemoryStatisticsServer::Statistics
 KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
@@ -108,6 +133,7 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
     Statistics stats;
     if (image) {
         stats.imageSize = calculateNodeMemoryHiBound(image->root());
+        collectLayersHistory(image->root(), stats.layersHistory);
     }
     stats.totalMemorySize = tileStats.totalMemorySize;
     stats.realMemorySize = tileStats.realMemorySize;
@@ -115,12 +141,17 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
     stats.poolSize = tileStats.poolSize;
 
     stats.swapSize = tileStats.swapSize;
+    stats.deduplicatedSize = tileStats.deduplicatedSize;
+
+    stats.prefetchHits = tileStats.prefetchHits;
+    stats.prefetchMisses = tileStats.prefetchMisses;
 
     KisImageConfig cfg;
 
     stats.tilesHardLimit = cfg.tilesHardLimit() * MiB;
     stats.tilesSoftLimit = cfg.tilesSoftLimit() * MiB;
     stats.tilesPoolLimit = cfg.poolLimit() * MiB;
+    stats.historyLimit = cfg.historyLimit() * MiB;
     stats.totalMemoryLimit = stats.tilesHardLimit + stats.tilesPoolLimit;
 
     return stats;
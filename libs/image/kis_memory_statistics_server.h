@@ -22,6 +22,8 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QScopedPointer>
+#include <QVector>
+#include <QString>
 
 #include "kritaimage_export.h"
 #include "kis_types.h"
@@ -31,6 +33,22 @@ class KRITAIMAGE_EXPORT KisMemoryStatisticsServer : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * The size of the undo history of a single layer
+     */
+    struct LayerHistoryStatistics
+    {
+        LayerHistoryStatistics()
+            : memorySize(0),
+              swappedSize(0)
+        {
+        }
+
+        QString name;
+        qint64 memorySize;
+        qint64 swappedSize;
+    };
+
     struct Statistics
     {
         Statistics()
@@ -42,11 +60,16 @@ public:
               poolSize(0),
 
               swapSize(0),
+              deduplicatedSize(0),
+
+              prefetchHits(0),
+              prefetchMisses(0),
 
               totalMemoryLimit(0),
               tilesHardLimit(0),
               tilesSoftLimit(0),
-              tilesPoolLimit(0)
+              tilesPoolLimit(0),
+              historyLimit(0)
         {
         }
 
@@ -59,10 +82,29 @@ public:
 
         qint64 swapSize;
 
+        /**
+         * Memory saved by sharing identical tiles
+         */
+        qint64 deduplicatedSize;
+
+        /**
+         * Number of accesses to the tiles the prefetcher has loaded
+         * in advance (hits) and number of tiles loaded synchronously
+         * by the accessing thread (misses)
+         */
+        qint64 prefetchHits;
+        qint64 prefetchMisses;
+
         qint64 totalMemoryLimit;
         qint64 tilesHardLimit;
         qint64 tilesSoftLimit;
         qint64 tilesPoolLimit;
+        qint64 historyLimit;
+
+        /**
+         * The history size of the layers that have any history
+         */
+        QVector<LayerHistoryStatistics> layersHistory;
     };
 
 
@@ -366,8 +366,12 @@ public:
 
     bool readFrame(QIODevice *stream, int frameId)
     {
+        /**
+         * Different frames may be read concurrently while loading
+         * the document, so don't use non-const access to the hash
+         */
         bool retval = false;
-        DataSP data = m_frames[frameId];
+        DataSP data = m_frames.value(frameId);
         retval = data->dataManager()->read(stream);
         data->cache()->invalidate();
         return retval;
@@ -381,7 +385,7 @@ public:
 
     void setFrameDefaultPixel(const KoColor &defPixel, int frameId)
     {
-        DataSP data = m_frames[frameId];
+        DataSP data = m_frames.value(frameId);
         KoColor color(defPixel);
         color.convertTo(data->colorSpace());
         data->dataManager()->setDefaultPixel(color.data());
@@ -20,11 +20,21 @@
 
 #include <kritaimage_export.h>
 
+class KisCompressedTilesCache;
+
 class KRITAIMAGE_EXPORT KisPaintDeviceWriter {
 public:
     virtual ~KisPaintDeviceWriter() {}
     virtual bool write(const QByteArray &data) = 0;
     virtual bool write(const char* data, qint64 length) = 0;
+
+    /**
+     * The cache the data managers can take the compressed tiles
+     * from, if they have not been changed since the previous save
+     */
+    virtual KisCompressedTilesCache* compressedTilesCache() const {
+        return 0;
+    }
 };
 
 
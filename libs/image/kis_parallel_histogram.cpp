@@ -0,0 +1,317 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_parallel_histogram.h"
+
+#include <qmath.h>
+#include <QRect>
+#include <QtConcurrent>
+
+#include <KoColorSpace.h>
+#include <KoChannelInfo.h>
+#include <KoColorSpaceMaths.h>
+
+#include "kis_paint_device.h"
+#include "kis_iterator_ng.h"
+
+namespace {
+
+/**
+ * The size of the blocks the area is split into. It is a multiple of
+ * the tile size, so usually the threads don't share the tiles.
+ */
+const int blockSize = 256;
+
+typedef void (*CountFunc)(const quint8 *pixels, int numPixels, const KoColorSpace *cs, quint32 *bins);
+
+/**
+ * Adds \p numPixels pixels to the bins. The values are converted into
+ * the bin indexes first in a separate loop: its iterations don't
+ * depend on each other, so the compiler can vectorize it. The second
+ * loop increments the bins. The adjacent increments hit the bins of
+ * different channels, so they don't stall on each other.
+ */
+template <typename channel_type>
+void countPixels(const quint8 *pixels, int numPixels, const KoColorSpace *cs, quint32 *bins)
+{
+    const int channelCount = cs->channelCount();
+    const channel_type *src = reinterpret_cast<const channel_type*>(pixels);
+
+    const int maxBatchSize = 1024;
+    const int batchSize = (maxBatchSize / channelCount) * channelCount;
+    quint8 indexes[maxBatchSize];
+
+    int numValues = numPixels * channelCount;
+
+    while (numValues > 0) {
+        const int batch = qMin(numValues, batchSize);
+
+        for (int i = 0; i < batch; i++) {
+            indexes[i] = KoColorSpaceMaths<channel_type, quint8>::scaleToA(src[i]);
+        }
+
+        for (int i = 0; i < batch; i += channelCount) {
+            for (int c = 0; c < channelCount; c++) {
+                bins[c * KisParallelHistogram::numBins + indexes[i + c]]++;
+            }
+        }
+
+        src += batch;
+        numValues -= batch;
+    }
+}
+
+template <>
+void countPixels<quint8>(const quint8 *pixels, int numPixels, const KoColorSpace *cs, quint32 *bins)
+{
+    const int channelCount = cs->channelCount();
+
+    for (int i = 0; i < numPixels; i++) {
+        for (int c = 0; c < channelCount; c++) {
+            bins[c * KisParallelHistogram::numBins + pixels[c]]++;
+        }
+        pixels += channelCount;
+    }
+}
+
+void countPixelsGeneric(const quint8 *pixels, int numPixels, const KoColorSpace *cs, quint32 *bins)
+{
+    const int channelCount = cs->channelCount();
+    const int pixelSize = cs->pixelSize();
+
+    for (int i = 0; i < numPixels; i++) {
+        for (int c = 0; c < channelCount; c++) {
+            bins[c * KisParallelHistogram::numBins + cs->scaleToU8(pixels, c)]++;
+        }
+        pixels += pixelSize;
+    }
+}
+
+CountFunc chooseCountFunc(const KoColorSpace *cs)
+{
+    const QList<KoChannelInfo*> channels = cs->channels();
+    const KoChannelInfo::enumChannelValueType type = channels.first()->channelValueType();
+
+    Q_FOREACH (KoChannelInfo *channel, channels) {
+        if (channel->channelValueType() != type) {
+            return countPixelsGeneric;
+        }
+    }
+
+    const int channelCount = channels.size();
+    const int pixelSize = cs->pixelSize();
+
+    if (type == KoChannelInfo::UINT8 && pixelSize == channelCount) {
+        return countPixels<quint8>;
+    } else if (type == KoChannelInfo::UINT16 && pixelSize == 2 * channelCount) {
+        return countPixels<quint16>;
+    } else if (type == KoChannelInfo::FLOAT32 && pixelSize == 4 * channelCount) {
+        return countPixels<float>;
+    }
+
+    return countPixelsGeneric;
+}
+
+struct Block {
+    QRect rect;
+    QVector<quint32> bins;
+};
+
+struct CountBlockJob {
+    CountBlockJob(KisPaintDeviceSP device, const QRect &countedRect, CountFunc countFunc)
+        : m_device(device),
+          m_colorSpace(device->colorSpace()),
+          m_countedRect(countedRect),
+          m_countFunc(countFunc)
+    {
+    }
+
+    inline void operator() (Block *block) {
+        block->bins.fill(0, m_colorSpace->channelCount() * KisParallelHistogram::numBins);
+
+        const QRect rect = block->rect & m_countedRect;
+        if (rect.isEmpty()) return;
+
+        KisSequentialConstIterator it(m_device, rect);
+        int numPixels;
+
+        do {
+            numPixels = it.nConseqPixels();
+            m_countFunc(it.rawDataConst(), numPixels, m_colorSpace, block->bins.data());
+        } while (it.nextPixels(numPixels));
+    }
+
+    KisPaintDeviceSP m_device;
+    const KoColorSpace *m_colorSpace;
+    QRect m_countedRect;
+    CountFunc m_countFunc;
+};
+
+}
+
+struct KisParallelHistogram::Private
+{
+    Private() : colorSpace(0), gridWidth(0) {}
+
+    QRect bounds;
+    QRect countedRect;
+    const KoColorSpace *colorSpace;
+
+    QPoint gridOrigin;
+    int gridWidth;
+    QVector<Block> blocks;
+
+    QVector<QVector<quint32>> bins;
+
+    QRect blocksRange(const QRect &rc) const;
+    void countBlocks(KisPaintDeviceSP device, QVector<Block*> dirtyBlocks);
+};
+
+QRect KisParallelHistogram::Private::blocksRange(const QRect &rc) const
+{
+    const int left = qFloor(qreal(rc.left()) / blockSize);
+    const int top = qFloor(qreal(rc.top()) / blockSize);
+    const int right = qFloor(qreal(rc.right()) / blockSize);
+    const int bottom = qFloor(qreal(rc.bottom()) / blockSize);
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void KisParallelHistogram::Private::countBlocks(KisPaintDeviceSP device, QVector<Block*> dirtyBlocks)
+{
+    CountBlockJob job(device, countedRect, chooseCountFunc(colorSpace));
+    QtConcurrent::blockingMap(dirtyBlocks, job);
+
+    const int channelCount = colorSpace->channelCount();
+
+    bins.resize(channelCount);
+    for (int c = 0; c < channelCount; c++) {
+        bins[c].fill(0, numBins);
+    }
+
+    Q_FOREACH (const Block &block, blocks) {
+        const quint32 *blockBins = block.bins.constData();
+
+        for (int c = 0; c < channelCount; c++) {
+            quint32 *channelBins = bins[c].data();
+
+            for (int i = 0; i < numBins; i++) {
+                channelBins[i] += *blockBins++;
+            }
+        }
+    }
+}
+
+KisParallelHistogram::KisParallelHistogram(const QRect &bounds)
+    : m_d(new Private)
+{
+    m_d->bounds = bounds;
+
+    if (bounds.isEmpty()) return;
+
+    const QRect range = m_d->blocksRange(bounds);
+    m_d->gridOrigin = range.topLeft();
+    m_d->gridWidth = range.width();
+
+    for (int y = range.top(); y <= range.bottom(); y++) {
+        for (int x = range.left(); x <= range.right(); x++) {
+            Block block;
+            block.rect = QRect(x * blockSize, y * blockSize, blockSize, blockSize) & bounds;
+            m_d->blocks << block;
+        }
+    }
+}
+
+KisParallelHistogram::~KisParallelHistogram()
+{
+}
+
+QRect KisParallelHistogram::bounds() const
+{
+    return m_d->bounds;
+}
+
+void KisParallelHistogram::update(KisPaintDeviceSP device)
+{
+    update(device, QVector<QRect>() << m_d->bounds);
+}
+
+void KisParallelHistogram::update(KisPaintDeviceSP device, const QVector<QRect> &dirtyRects)
+{
+    if (m_d->blocks.isEmpty()) return;
+
+    QVector<Block*> dirtyBlocks;
+
+    /**
+     * The transparent area around the image is not a part of the
+     * histogram, so only the exact bounds of the device are counted.
+     * When they change, the blocks they cross should be recounted.
+     */
+    const QRect oldCountedRect = m_d->countedRect;
+    m_d->countedRect = device->exactBounds() & m_d->bounds;
+
+    if (!m_d->colorSpace || !(*m_d->colorSpace == *device->colorSpace())) {
+        m_d->colorSpace = device->colorSpace();
+
+        for (auto it = m_d->blocks.begin(); it != m_d->blocks.end(); ++it) {
+            dirtyBlocks << &(*it);
+        }
+    } else {
+        QVector<bool> dirtyFlags(m_d->blocks.size(), false);
+
+        if (m_d->countedRect != oldCountedRect) {
+            for (int i = 0; i < m_d->blocks.size(); i++) {
+                const QRect &rc = m_d->blocks[i].rect;
+                dirtyFlags[i] = (rc & m_d->countedRect) != (rc & oldCountedRect);
+            }
+        }
+
+        Q_FOREACH (const QRect &rc, dirtyRects) {
+            const QRect dirtyRect = rc & m_d->bounds;
+            if (dirtyRect.isEmpty()) continue;
+
+            const QRect range = m_d->blocksRange(dirtyRect).translated(-m_d->gridOrigin);
+
+            for (int y = range.top(); y <= range.bottom(); y++) {
+                for (int x = range.left(); x <= range.right(); x++) {
+                    dirtyFlags[y * m_d->gridWidth + x] = true;
+                }
+            }
+        }
+
+        for (int i = 0; i < m_d->blocks.size(); i++) {
+            if (dirtyFlags[i]) {
+                dirtyBlocks << &m_d->blocks[i];
+            }
+        }
+
+        if (dirtyBlocks.isEmpty()) return;
+    }
+
+    m_d->countBlocks(device, dirtyBlocks);
+}
+
+int KisParallelHistogram::channelCount() const
+{
+    return m_d->bins.size();
+}
+
+const QVector<quint32>& KisParallelHistogram::bins(int channel) const
+{
+    return m_d->bins[channel];
+}
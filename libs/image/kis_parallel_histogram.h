@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_PARALLEL_HISTOGRAM_H
+#define __KIS_PARALLEL_HISTOGRAM_H
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+#include <QScopedPointer>
+#include <QVector>
+
+class QRect;
+class KoColorSpace;
+
+/**
+ * Calculates the histograms of all the channels of a paint device.
+ * Every channel gets 256 bins, the values are scaled the same way
+ * KoColorSpace::scaleToU8() does it. The channels are indexed in the
+ * order they are stored in the pixel. Only the pixels inside the
+ * exact bounds of the device are counted.
+ *
+ * The area is split into blocks, which are processed in the global
+ * thread pool, each block counted into its own bins. The bins of the
+ * blocks are kept, so when only a part of the device changes,
+ * update() with the dirty rects recalculates only the blocks touched
+ * by them.
+ *
+ * The object is not thread-safe: only one update() may run at a time.
+ */
+class KRITAIMAGE_EXPORT KisParallelHistogram
+{
+public:
+    static const int numBins = 256;
+
+    /**
+     * Creates a histogram covering \p bounds. Nothing is
+     * calculated until update() is called.
+     */
+    KisParallelHistogram(const QRect &bounds);
+    ~KisParallelHistogram();
+
+    QRect bounds() const;
+
+    /**
+     * Recalculates the histogram of the whole bounds of \p device
+     */
+    void update(KisPaintDeviceSP device);
+
+    /**
+     * Recalculates the parts of the histogram touched by \p
+     * dirtyRects. If the color space of \p device differs from the
+     * one used in the previous update, the whole histogram is
+     * recalculated.
+     */
+    void update(KisPaintDeviceSP device, const QVector<QRect> &dirtyRects);
+
+    /**
+     * \return the number of channels in the calculated histogram,
+     *         zero if nothing was calculated yet
+     */
+    int channelCount() const;
+
+    /**
+     * \return the bins of channel \p channel
+     */
+    const QVector<quint32>& bins(int channel) const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_PARALLEL_HISTOGRAM_H */
@@ -30,7 +30,8 @@
  */
 class KRITAIMAGE_EXPORT KisRectangleMaskGenerator : public KisMaskGenerator
 {
-
+public:
+    struct FastRowProcessor;
 public:
 
     KisRectangleMaskGenerator(qreal radius, qreal ratio, qreal fh, qreal fv, int spikes, bool antialiasEdges);
@@ -40,7 +41,9 @@ public:
     KisMaskGenerator* clone() const override;
 
     bool shouldSupersample() const override;
+    bool shouldVectorize() const override;
     quint8 valueAt(qreal x, qreal y) const override;
+    KisBrushMaskApplicatorBase* applicator() override;
     void setScale(qreal scaleX, qreal scaleY) override;
     void setSoftness(qreal softness) override;
 
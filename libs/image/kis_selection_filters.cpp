@@ -25,6 +25,8 @@
 #include "kis_convolution_painter.h"
 #include "kis_convolution_kernel.h"
 #include "kis_pixel_selection.h"
+#include "kis_stacked_box_blur.h"
+#include "kis_default_bounds_base.h"
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -481,6 +483,26 @@ QRect KisFeatherSelectionFilter::changeRect(const QRect& rect)
 
 void KisFeatherSelectionFilter::process(KisPixelSelectionSP pixelSelection, const QRect& rect)
 {
+    /**
+     * The kernel below is a gaussian cut at one sigma, which is close
+     * to a box with rounded shoulders. For big radii we apply exactly
+     * that: a wide box and a narrow one with the same total support
+     * and about the same variance, which costs the same for any radius.
+     */
+    const qint32 boxBlurThreshold = 20;
+
+    if (m_radius >= boxBlurThreshold &&
+        !pixelSelection->defaultBounds()->wrapAroundMode()) {
+
+        QVector<int> radii;
+        radii << m_radius - m_radius / 16 << m_radius / 16;
+
+        KisStackedBoxBlur::applyBoxes(pixelSelection, rect, radii, radii,
+                                      pixelSelection->colorSpace()->channelFlags(false, true),
+                                      0);
+        return;
+    }
+
     // compute horizontal kernel
     const uint kernelSize = m_radius * 2 + 1;
     Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> gaussianMatrix(1, kernelSize);
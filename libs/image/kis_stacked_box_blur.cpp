@@ -0,0 +1,431 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stacked_box_blur.h"
+
+#include <cmath>
+
+#include <QRect>
+#include <QBitArray>
+
+#include <KoColorSpace.h>
+#include <KoChannelInfo.h>
+#include <KoUpdater.h>
+
+#include "kis_paint_device.h"
+#include "kis_math_toolbox.h"
+
+
+namespace {
+
+/**
+ * The number of rows (or columns) read from the device at once
+ */
+const int linesPerChunk = 64;
+
+/**
+ * Converts the pixels into floating point values with the colors
+ * premultiplied by alpha and back, the same way
+ * KisConvolutionWorkerSpatial does
+ */
+class BlurChannelConverter
+{
+public:
+    BlurChannelConverter(const KoColorSpace *cs, const QBitArray &channelFlags)
+        : m_alphaIndex(-1),
+          m_alphaPos(-1),
+          m_isValid(false)
+    {
+        const QBitArray flags = channelFlags.isEmpty() ?
+            QBitArray(cs->channelCount(), true) : channelFlags;
+
+        QList<KoChannelInfo *> channels = cs->channels();
+        for (int i = 0; i < channels.size(); i++) {
+            if (!flags.testBit(i)) continue;
+
+            if (channels[i]->channelType() == KoChannelInfo::ALPHA) {
+                m_alphaIndex = m_channels.size();
+                m_alphaPos = channels[i]->pos();
+            }
+
+            m_channels.append(channels[i]);
+            m_positions.append(channels[i]->pos());
+        }
+
+        KisMathToolbox mathToolbox;
+        m_toDouble = QVector<PtrToDouble>(m_channels.size());
+        m_fromDouble = QVector<PtrFromDouble>(m_channels.size());
+
+        m_isValid =
+            !m_channels.isEmpty() &&
+            mathToolbox.getToDoubleChannelPtr(m_channels, m_toDouble) &&
+            mathToolbox.getFromDoubleChannelPtr(m_channels, m_fromDouble);
+
+        Q_FOREACH (KoChannelInfo *channel, m_channels) {
+            m_minClamp.append(mathToolbox.minChannelValue(channel));
+            m_maxClamp.append(mathToolbox.maxChannelValue(channel));
+        }
+    }
+
+    bool isValid() const {
+        return m_isValid;
+    }
+
+    int numChannels() const {
+        return m_channels.size();
+    }
+
+    inline void toFloat(const quint8 *pixel, float *dst) const {
+        const qreal alpha = m_alphaIndex >= 0 ? m_toDouble[m_alphaIndex](pixel, m_alphaPos) : 1.0;
+
+        for (int k = 0; k < m_channels.size(); k++) {
+            dst[k] = k != m_alphaIndex ? m_toDouble[k](pixel, m_positions[k]) * alpha : alpha;
+        }
+    }
+
+    inline void fromFloat(const float *src, quint8 *pixel) const {
+        if (m_alphaIndex >= 0) {
+            const qreal alpha = clamp(src[m_alphaIndex], m_alphaIndex);
+            m_fromDouble[m_alphaIndex](pixel, m_alphaPos, alpha);
+
+            const qreal alphaInv = alpha != 0.0 ? 1.0 / alpha : 0.0;
+
+            for (int k = 0; k < m_channels.size(); k++) {
+                if (k == m_alphaIndex) continue;
+                m_fromDouble[k](pixel, m_positions[k], clamp(src[k] * alphaInv, k));
+            }
+        } else {
+            for (int k = 0; k < m_channels.size(); k++) {
+                m_fromDouble[k](pixel, m_positions[k], clamp(src[k], k));
+            }
+        }
+    }
+
+private:
+    inline qreal clamp(qreal value, int channel) const {
+        // NaN is converted into the lower bound
+        return value > m_maxClamp[channel] ? m_maxClamp[channel] :
+               value >= m_minClamp[channel] ? value : m_minClamp[channel];
+    }
+
+private:
+    QList<KoChannelInfo *> m_channels;
+    QVector<int> m_positions;
+    QVector<PtrToDouble> m_toDouble;
+    QVector<PtrFromDouble> m_fromDouble;
+    QVector<qreal> m_minClamp;
+    QVector<qreal> m_maxClamp;
+    int m_alphaIndex;
+    int m_alphaPos;
+    bool m_isValid;
+};
+
+class BlurProgress
+{
+public:
+    BlurProgress(KoUpdater *updater, int numSteps)
+        : m_updater(updater),
+          m_step(0)
+    {
+        if (m_updater) {
+            m_updater->setRange(0, numSteps);
+            m_updater->setValue(0);
+        }
+    }
+
+    /**
+     * \return false if the operation has been cancelled
+     */
+    bool step() {
+        if (!m_updater) return true;
+
+        m_updater->setValue(++m_step);
+        return !m_updater->interrupted();
+    }
+
+private:
+    KoUpdater *m_updater;
+    int m_step;
+};
+
+/**
+ * Blurs a line of \p numPixels interleaved pixels with a box of size
+ * 2 * \p radius + 1. The running sum is kept in double precision to
+ * avoid accumulating the error on long lines.
+ */
+void boxBlurLine(const float *src, float *dst, int numPixels, int numChannels, int radius)
+{
+    const qreal scale = 1.0 / (2 * radius + 1);
+    const int lastPixel = numPixels - 1;
+
+    for (int c = 0; c < numChannels; c++) {
+        qreal sum = 0.0;
+
+        for (int i = -radius; i <= radius; i++) {
+            sum += src[qBound(0, i, lastPixel) * numChannels + c];
+        }
+
+        for (int x = 0; x < numPixels; x++) {
+            dst[x * numChannels + c] = sum * scale;
+
+            sum += src[qMin(x + radius + 1, lastPixel) * numChannels + c] -
+                   src[qMax(x - radius, 0) * numChannels + c];
+        }
+    }
+}
+
+void blurLine(float *line, float *temp, int numPixels, int numChannels, const QVector<int> &radii)
+{
+    float *src = line;
+    float *dst = temp;
+
+    Q_FOREACH (int radius, radii) {
+        if (radius <= 0) continue;
+
+        boxBlurLine(src, dst, numPixels, numChannels, radius);
+        std::swap(src, dst);
+    }
+
+    if (src != line) {
+        memcpy(line, src, numPixels * numChannels * sizeof(float));
+    }
+}
+
+/**
+ * Reads \p area of the device, the pixels outside \p dataRect are
+ * replaced with the closest pixel inside it
+ */
+void readRepeated(KisPaintDeviceSP device, const QRect &area, const QRect &dataRect, quint8 *dst, int pixelSize)
+{
+    const QRect srcRect(QPoint(qBound(dataRect.left(), area.left(), dataRect.right()),
+                               qBound(dataRect.top(), area.top(), dataRect.bottom())),
+                        QPoint(qBound(dataRect.left(), area.right(), dataRect.right()),
+                               qBound(dataRect.top(), area.bottom(), dataRect.bottom())));
+
+    QVector<quint8> buffer(srcRect.width() * srcRect.height() * pixelSize);
+    device->readBytes(buffer.data(), srcRect);
+
+    const int leftPadding = srcRect.left() - area.left();
+    const int rightPadding = area.right() - srcRect.right();
+    const int srcRowSize = srcRect.width() * pixelSize;
+
+    for (int y = area.top(); y <= area.bottom(); y++) {
+        const int srcRow = qBound(srcRect.top(), y, srcRect.bottom()) - srcRect.top();
+        const quint8 *srcPtr = buffer.constData() + srcRow * srcRowSize;
+
+        for (int i = 0; i < leftPadding; i++) {
+            memcpy(dst, srcPtr, pixelSize);
+            dst += pixelSize;
+        }
+
+        memcpy(dst, srcPtr, srcRowSize);
+        dst += srcRowSize;
+
+        const quint8 *lastPixel = srcPtr + srcRowSize - pixelSize;
+        for (int i = 0; i < rightPadding; i++) {
+            memcpy(dst, lastPixel, pixelSize);
+            dst += pixelSize;
+        }
+    }
+}
+
+int numChunks(int size)
+{
+    return (size + linesPerChunk - 1) / linesPerChunk;
+}
+
+bool blurPass(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+              const QRect &dstRect, const QRect &dataRect,
+              Qt::Orientation orientation,
+              const QVector<int> &radii,
+              const BlurChannelConverter &converter,
+              BlurProgress &progress)
+{
+    const int pixelSize = src->pixelSize();
+    const int numChannels = converter.numChannels();
+
+    int margin = 0;
+    Q_FOREACH (int radius, radii) {
+        margin += radius;
+    }
+
+    const bool horizontal = orientation == Qt::Horizontal;
+    const int chunkStart = horizontal ? dstRect.top() : dstRect.left();
+    const int chunkEnd = horizontal ? dstRect.bottom() : dstRect.right();
+    const int lineLength = (horizontal ? dstRect.width() : dstRect.height()) + 2 * margin;
+    const int dstLineLength = lineLength - 2 * margin;
+
+    QVector<float> line(lineLength * numChannels);
+    QVector<float> temp(lineLength * numChannels);
+
+    for (int start = chunkStart; start <= chunkEnd; start += linesPerChunk) {
+        const int numLines = qMin(linesPerChunk, chunkEnd - start + 1);
+
+        const QRect area = horizontal ?
+            QRect(dstRect.left() - margin, start, lineLength, numLines) :
+            QRect(start, dstRect.top() - margin, numLines, lineLength);
+
+        const QRect dstArea = horizontal ?
+            QRect(dstRect.left(), start, dstLineLength, numLines) :
+            QRect(start, dstRect.top(), numLines, dstLineLength);
+
+        QVector<quint8> srcBytes(area.width() * area.height() * pixelSize);
+        readRepeated(src, area, dataRect, srcBytes.data(), pixelSize);
+
+        QVector<quint8> dstBytes(dstArea.width() * dstArea.height() * pixelSize);
+
+        /**
+         * In the horizontal pass the pixels of a line are adjacent, in
+         * the vertical one they are one row of the chunk apart
+         */
+        const int srcPixelStride = horizontal ? pixelSize : area.width() * pixelSize;
+        const int srcLineStride = horizontal ? area.width() * pixelSize : pixelSize;
+        const int dstPixelStride = horizontal ? pixelSize : dstArea.width() * pixelSize;
+        const int dstLineStride = horizontal ? dstArea.width() * pixelSize : pixelSize;
+
+        for (int l = 0; l < numLines; l++) {
+            const quint8 *srcPtr = srcBytes.constData() + l * srcLineStride;
+
+            for (int i = 0; i < lineLength; i++) {
+                converter.toFloat(srcPtr + i * srcPixelStride, line.data() + i * numChannels);
+            }
+
+            blurLine(line.data(), temp.data(), lineLength, numChannels, radii);
+
+            quint8 *dstPtr = dstBytes.data() + l * dstLineStride;
+            srcPtr += margin * srcPixelStride;
+
+            for (int i = 0; i < dstLineLength; i++) {
+                // keep the values of the channels that are not blurred
+                memcpy(dstPtr + i * dstPixelStride, srcPtr + i * srcPixelStride, pixelSize);
+                converter.fromFloat(line.constData() + (i + margin) * numChannels,
+                                    dstPtr + i * dstPixelStride);
+            }
+        }
+
+        dst->writeBytes(dstBytes.constData(), dstArea);
+
+        if (!progress.step()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+QVector<int> KisStackedBoxBlur::boxRadiiFromSigma(qreal sigma)
+{
+    const int numBoxes = 3;
+
+    /**
+     * The ideal width of the boxes is rounded down to the nearest
+     * odd number, then some of the boxes are made two pixels wider,
+     * so that the total variance is the closest to sigma^2
+     */
+    const qreal variance = sigma * sigma;
+    const qreal idealWidth = std::sqrt(12.0 * variance / numBoxes + 1.0);
+
+    int lowerWidth = qMax(1, int(std::floor(idealWidth)));
+    if (!(lowerWidth & 0x1)) {
+        lowerWidth--;
+    }
+
+    const qreal idealNumLowerBoxes =
+        (12.0 * variance - numBoxes * lowerWidth * lowerWidth - 4.0 * numBoxes * lowerWidth - 3.0 * numBoxes) /
+        (-4.0 * lowerWidth - 4.0);
+
+    const int numLowerBoxes = qBound(0, qRound(idealNumLowerBoxes), numBoxes);
+
+    QVector<int> radii;
+    for (int i = 0; i < numBoxes; i++) {
+        const int width = i < numLowerBoxes ? lowerWidth : lowerWidth + 2;
+        radii.append((width - 1) / 2);
+    }
+
+    return radii;
+}
+
+int KisStackedBoxBlur::marginFromSigma(qreal sigma)
+{
+    int margin = 0;
+
+    Q_FOREACH (int radius, boxRadiiFromSigma(sigma)) {
+        margin += radius;
+    }
+
+    return margin;
+}
+
+void KisStackedBoxBlur::applyGaussian(KisPaintDeviceSP device,
+                                      const QRect& rect,
+                                      qreal xSigma, qreal ySigma,
+                                      const QBitArray &channelFlags,
+                                      KoUpdater *progressUpdater)
+{
+    applyBoxes(device, rect,
+               xSigma > 0.0 ? boxRadiiFromSigma(xSigma) : QVector<int>(),
+               ySigma > 0.0 ? boxRadiiFromSigma(ySigma) : QVector<int>(),
+               channelFlags, progressUpdater);
+}
+
+void KisStackedBoxBlur::applyBoxes(KisPaintDeviceSP device,
+                                   const QRect& rect,
+                                   const QVector<int> &xRadii,
+                                   const QVector<int> &yRadii,
+                                   const QBitArray &channelFlags,
+                                   KoUpdater *progressUpdater)
+{
+    if (rect.isEmpty()) return;
+
+    BlurChannelConverter converter(device->colorSpace(), channelFlags);
+    if (!converter.isValid()) return;
+
+    if (!xRadii.isEmpty() && !yRadii.isEmpty()) {
+        int yMargin = 0;
+        Q_FOREACH (int radius, yRadii) {
+            yMargin += radius;
+        }
+
+        const QRect intermRect = rect.adjusted(0, -yMargin, 0, yMargin);
+
+        BlurProgress progress(progressUpdater,
+                              numChunks(intermRect.height()) + numChunks(rect.width()));
+
+        KisPaintDeviceSP interm = new KisPaintDevice(device->colorSpace());
+
+        if (!blurPass(device, interm, intermRect, intermRect | device->exactBounds(),
+                      Qt::Horizontal, xRadii, converter, progress)) {
+            return;
+        }
+
+        blurPass(interm, device, rect, intermRect,
+                 Qt::Vertical, yRadii, converter, progress);
+
+    } else if (!xRadii.isEmpty()) {
+        BlurProgress progress(progressUpdater, numChunks(rect.height()));
+        blurPass(device, device, rect, rect | device->exactBounds(),
+                 Qt::Horizontal, xRadii, converter, progress);
+
+    } else if (!yRadii.isEmpty()) {
+        BlurProgress progress(progressUpdater, numChunks(rect.width()));
+        blurPass(device, device, rect, rect | device->exactBounds(),
+                 Qt::Vertical, yRadii, converter, progress);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_STACKED_BOX_BLUR_H
+#define __KIS_STACKED_BOX_BLUR_H
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+#include <QVector>
+
+class QRect;
+class QBitArray;
+class KoUpdater;
+
+/**
+ * Approximates a gaussian blur with three consequent box blurs. Every
+ * box blur is calculated with a running sum, so the cost per pixel
+ * doesn't depend on the radius of the blur.
+ *
+ * The box sizes are chosen so that the variance of the result is
+ * equal to the variance of the gaussian, the support of the filter is
+ * about 3 sigma in each direction, that is the same as the support of
+ * the kernels generated by KisGaussianKernel.
+ *
+ * The borders are handled the same way as BORDER_REPEAT mode of
+ * KisConvolutionPainter does.
+ */
+class KRITAIMAGE_EXPORT KisStackedBoxBlur
+{
+public:
+    /**
+     * \return the radii of the boxes approximating the gaussian
+     *         with standard deviation \p sigma
+     */
+    static QVector<int> boxRadiiFromSigma(qreal sigma);
+
+    /**
+     * \return the number of pixels the blur with standard deviation
+     *         \p sigma reads around the processed area
+     */
+    static int marginFromSigma(qreal sigma);
+
+    static void applyGaussian(KisPaintDeviceSP device,
+                              const QRect& rect,
+                              qreal xSigma, qreal ySigma,
+                              const QBitArray &channelFlags,
+                              KoUpdater *progressUpdater);
+
+    /**
+     * Applies the boxes with radii \p xRadii horizontally and then
+     * the boxes with radii \p yRadii vertically. An empty list means
+     * the direction is not blurred.
+     */
+    static void applyBoxes(KisPaintDeviceSP device,
+                           const QRect& rect,
+                           const QVector<int> &xRadii,
+                           const QVector<int> &yRadii,
+                           const QBitArray &channelFlags,
+                           KoUpdater *progressUpdater);
+};
+
+#endif /* __KIS_STACKED_BOX_BLUR_H */
@@ -26,6 +26,9 @@
 #include <klocalizedstring.h>
 
 #include <QTransform>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QtConcurrent>
 
 #include <KoColorSpace.h>
 #include <KoCompositeOpRegistry.h>
@@ -195,6 +198,116 @@ void updateBounds<KisVLineIteratorSP>(QRect &boundRect, const KisFilterWeightsAp
     boundRect.setHeight(newBounds.size());
 }
 
+template <class iter>
+int lineOffset(KisPaintDevice *dev);
+
+template <>
+int lineOffset<KisHLineIteratorSP>(KisPaintDevice *dev)
+{
+    return dev->y();
+}
+
+template <>
+int lineOffset<KisVLineIteratorSP>(KisPaintDevice *dev)
+{
+    return dev->x();
+}
+
+namespace {
+
+/**
+ * Building the weights takes noticeable time, and the previews of
+ * the transform tool request the same scales again and again, so
+ * a few recently used buffers are kept around
+ */
+class FilterWeightsBufferCache
+{
+    typedef QPair<QPair<QString, qint32>, qreal> Key;
+
+public:
+    QSharedPointer<KisFilterWeightsBuffer> buffer(KisFilterStrategy *filterStrategy, qreal realScale) {
+        const Key key(qMakePair(filterStrategy->id(), filterStrategy->intSupport()), realScale);
+
+        {
+            QMutexLocker l(&m_mutex);
+
+            for (int i = 0; i < m_buffers.size(); i++) {
+                if (m_buffers[i].first == key) {
+                    m_buffers.move(i, 0);
+                    return m_buffers.first().second;
+                }
+            }
+        }
+
+        QSharedPointer<KisFilterWeightsBuffer> buffer(new KisFilterWeightsBuffer(filterStrategy, realScale));
+
+        QMutexLocker l(&m_mutex);
+
+        m_buffers.prepend(qMakePair(key, buffer));
+        if (m_buffers.size() > maxBuffers) {
+            m_buffers.removeLast();
+        }
+
+        return buffer;
+    }
+
+private:
+    static const int maxBuffers = 16;
+
+    QMutex m_mutex;
+    QList<QPair<Key, QSharedPointer<KisFilterWeightsBuffer>>> m_buffers;
+};
+
+Q_GLOBAL_STATIC(FilterWeightsBufferCache, s_weightsBufferCache)
+
+struct LineBand {
+    LineBand() : firstLine(0), numLines(0) {}
+    LineBand(int _firstLine, int _numLines) : firstLine(_firstLine), numLines(_numLines) {}
+
+    int firstLine;
+    int numLines;
+    KisFilterWeightsApplicator::LinePos dstBounds;
+};
+
+template <class T>
+struct TransformPassJob {
+    TransformPassJob(KisFilterWeightsApplicator *applicator,
+                     KisFilterWeightsBuffer *buffer,
+                     qreal filterSupport,
+                     int srcStart, int srcLen,
+                     KisProgressUpdateHelper *progressHelper,
+                     QMutex *progressMutex)
+        : m_applicator(applicator),
+          m_buffer(buffer),
+          m_filterSupport(filterSupport),
+          m_srcStart(srcStart),
+          m_srcLen(srcLen),
+          m_progressHelper(progressHelper),
+          m_progressMutex(progressMutex)
+    {
+    }
+
+    inline void operator() (LineBand &band) {
+        for (int i = band.firstLine; i < band.firstLine + band.numLines; i++) {
+            KisFilterWeightsApplicator::LinePos srcPos(m_srcStart, m_srcLen);
+            band.dstBounds.unite(m_applicator->processLine<T>(srcPos, i, m_buffer, m_filterSupport));
+        }
+
+        QMutexLocker l(m_progressMutex);
+        m_progressHelper->step();
+    }
+
+    KisFilterWeightsApplicator *m_applicator;
+    KisFilterWeightsBuffer *m_buffer;
+    qreal m_filterSupport;
+    int m_srcStart;
+    int m_srcLen;
+    KisProgressUpdateHelper *m_progressHelper;
+    QMutex *m_progressMutex;
+};
+
+}
+
 template <class T>
 void KisTransformWorker::transformPass(KisPaintDevice *src, KisPaintDevice *dst,
                                        double floatscale, double shear, double dx,
@@ -206,20 +319,41 @@ void KisTransformWorker::transformPass(KisPaintDevice *src, KisPaintDevice *dst,
     qint32 srcStart, srcLen, firstLine, numLines;
     calcDimensions<T>(m_boundRect, srcStart, srcLen, firstLine, numLines);
 
-    KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, numLines);
-    KisFilterWeightsBuffer buf(filterStrategy, qAbs(floatscale));
-    KisFilterWeightsApplicator applicator(src, dst, floatscale, shear, dx, clampToEdge);
+    /**
+     * Every line is read and written independently of the others, so
+     * the bands of lines are processed in parallel. The bands are
+     * aligned to the tiles of the destination, so that two threads
+     * never write into the same tile.
+     */
+    const int bandSize = 64;
+    const int offset = lineOffset<T>(dst);
 
-    KisFilterWeightsApplicator::LinePos dstBounds;
+    QVector<LineBand> bands;
+    int bandStart = firstLine;
+    while (bandStart < firstLine + numLines) {
+        const int bandIndex = qFloor(qreal(bandStart - offset) / bandSize);
+        const int bandEnd = qMin(firstLine + numLines, offset + (bandIndex + 1) * bandSize);
 
-    for (int i = firstLine; i < firstLine + numLines; i++) {
-        KisFilterWeightsApplicator::LinePos dstPos;
-        KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
+        bands << LineBand(bandStart, bandEnd - bandStart);
+        bandStart = bandEnd;
+    }
 
-        dstPos = applicator.processLine<T>(srcPos, i, &buf, filterStrategy->support());
-        dstBounds.unite(dstPos);
+    KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, bands.size());
+    QMutex progressMutex;
 
-        progressHelper.step();
+    QSharedPointer<KisFilterWeightsBuffer> buf =
+        s_weightsBufferCache->buffer(filterStrategy, qAbs(floatscale));
+
+    KisFilterWeightsApplicator applicator(src, dst, floatscale, shear, dx, clampToEdge);
+
+    TransformPassJob<T> job(&applicator, buf.data(), filterStrategy->support(),
+                            srcStart, srcLen, &progressHelper, &progressMutex);
+    QtConcurrent::blockingMap(bands, job);
+
+    KisFilterWeightsApplicator::LinePos dstBounds;
+
+    Q_FOREACH (const LineBand &band, bands) {
+        dstBounds.unite(band.dstBounds);
     }
 
     updateBounds<T>(m_boundRect, dstBounds);
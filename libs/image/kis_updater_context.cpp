@@ -19,20 +19,26 @@
 #include "kis_updater_context.h"
 
 #include <QThread>
-#include <QThreadPool>
 
 #include "kis_update_job_item.h"
 #include "kis_stroke_job.h"
 
 const int KisUpdaterContext::useIdealThreadCountTag = -1;
 
-KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
-    : QObject(parent)
+static qint32 realThreadCount(qint32 threadCount)
 {
     if(threadCount <= 0) {
         threadCount = QThread::idealThreadCount();
         threadCount = threadCount > 0 ? threadCount : 1;
     }
+    return threadCount;
+}
+
+KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
+    : QObject(parent),
+      m_executor(realThreadCount(threadCount))
+{
+    threadCount = realThreadCount(threadCount);
 
     m_jobs.resize(threadCount);
     for(qint32 i = 0; i < m_jobs.size(); i++) {
@@ -51,7 +57,7 @@ KisUpdaterContext::KisUpdaterContext(qint32 threadCount, QObject *parent)
 
 KisUpdaterContext::~KisUpdaterContext()
 {
-    m_threadPool.waitForDone();
+    m_executor.waitForDone();
     for(qint32 i = 0; i < m_jobs.size(); i++)
         delete m_jobs[i];
 }
@@ -123,7 +129,7 @@ void KisUpdaterContext::addMergeJob(KisBaseRectsWalkerSP walker)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setWalker(walker);
-    m_threadPool.start(m_jobs[jobIndex]);
+    m_executor.start(m_jobs[jobIndex]);
 }
 
 /**
@@ -146,7 +152,7 @@ void KisUpdaterContext::addStrokeJob(KisStrokeJob *strokeJob)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setStrokeJob(strokeJob);
-    m_threadPool.start(m_jobs[jobIndex]);
+    m_executor.start(m_jobs[jobIndex]);
 }
 
 /**
@@ -169,7 +175,7 @@ void KisUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneousJob)
     Q_ASSERT(jobIndex >= 0);
 
     m_jobs[jobIndex]->setSpontaneousJob(spontaneousJob);
-    m_threadPool.start(m_jobs[jobIndex]);
+    m_executor.start(m_jobs[jobIndex]);
 }
 
 /**
@@ -187,7 +193,7 @@ void KisTestableUpdaterContext::addSpontaneousJob(KisSpontaneousJob *spontaneous
 
 void KisUpdaterContext::waitForDone()
 {
-    m_threadPool.waitForDone();
+    m_executor.waitForDone();
 }
 
 bool KisUpdaterContext::walkerIntersectsJob(KisBaseRectsWalkerSP walker,
@@ -0,0 +1,213 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_work_stealing_executor.h"
+
+#include <QThread>
+#include <QRunnable>
+#include <QList>
+
+#include "kis_assert.h"
+
+
+struct KisWorkStealingExecutor::Worker : public QThread
+{
+    Worker(KisWorkStealingExecutor *_q, int _index)
+        : q(_q), index(_index)
+    {
+    }
+
+    void run() override {
+        q->workerLoop(index);
+    }
+
+    KisWorkStealingExecutor *q;
+    const int index;
+
+    /**
+     * The owner takes the jobs from the front of the deque,
+     * the thieves --- from the back
+     */
+    QMutex lock;
+    QList<QRunnable*> jobs;
+};
+
+
+KisWorkStealingExecutor::KisWorkStealingExecutor(int numWorkers)
+    : m_numSleepingWorkers(0),
+      m_stopRequested(false)
+{
+    KIS_SAFE_ASSERT_RECOVER(numWorkers > 0) {
+        numWorkers = 1;
+    }
+
+    m_workers.resize(numWorkers);
+    for (int i = 0; i < numWorkers; i++) {
+        m_workers[i] = new Worker(this, i);
+        m_workers[i]->setObjectName(QString("KisUpdaterWorker-%1").arg(i));
+    }
+}
+
+KisWorkStealingExecutor::~KisWorkStealingExecutor()
+{
+    waitForDone();
+
+    {
+        QMutexLocker l(&m_sleepLock);
+        m_stopRequested = true;
+        m_jobsAvailable.wakeAll();
+    }
+
+    Q_FOREACH (Worker *worker, m_workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+int KisWorkStealingExecutor::numWorkers() const
+{
+    return m_workers.size();
+}
+
+void KisWorkStealingExecutor::startWorkers()
+{
+    QMutexLocker l(&m_sleepLock);
+    if (m_workersStarted.load()) return;
+
+    Q_FOREACH (Worker *worker, m_workers) {
+        worker->start();
+    }
+
+    m_workersStarted.store(1);
+}
+
+int KisWorkStealingExecutor::currentWorkerIndex() const
+{
+    QThread *thread = QThread::currentThread();
+
+    for (int i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i] == thread) return i;
+    }
+
+    return -1;
+}
+
+void KisWorkStealingExecutor::start(QRunnable *runnable)
+{
+    if (!m_workersStarted.load()) {
+        startWorkers();
+    }
+
+    m_numPendingJobs.ref();
+
+    const int ownIndex = currentWorkerIndex();
+
+    if (ownIndex >= 0) {
+        /**
+         * The job has been started by one of our own workers, most
+         * probably from the scheduler's "spare thread appeared"
+         * handler. Let the same worker pick it up as soon as it
+         * finishes the current job.
+         */
+        Worker *worker = m_workers[ownIndex];
+        QMutexLocker l(&worker->lock);
+        worker->jobs.prepend(runnable);
+    } else {
+        const int index = (m_nextWorker.fetchAndAddOrdered(1) & 0x7fffffff) % m_workers.size();
+        Worker *worker = m_workers[index];
+        QMutexLocker l(&worker->lock);
+        worker->jobs.append(runnable);
+    }
+
+    m_numQueuedJobs.ref();
+
+    QMutexLocker l(&m_sleepLock);
+    if (m_numSleepingWorkers > 0) {
+        m_jobsAvailable.wakeOne();
+    }
+}
+
+QRunnable* KisWorkStealingExecutor::takeJob(int workerIndex)
+{
+    Worker *self = m_workers[workerIndex];
+
+    {
+        QMutexLocker l(&self->lock);
+        if (!self->jobs.isEmpty()) {
+            m_numQueuedJobs.deref();
+            return self->jobs.takeFirst();
+        }
+    }
+
+    for (int i = 1; i < m_workers.size(); i++) {
+        Worker *victim = m_workers[(workerIndex + i) % m_workers.size()];
+
+        QMutexLocker l(&victim->lock);
+        if (!victim->jobs.isEmpty()) {
+            m_numQueuedJobs.deref();
+            return victim->jobs.takeLast();
+        }
+    }
+
+    return 0;
+}
+
+void KisWorkStealingExecutor::workerLoop(int workerIndex)
+{
+    while (1) {
+        QRunnable *job = takeJob(workerIndex);
+
+        if (job) {
+            const bool autoDelete = job->autoDelete();
+            job->run();
+            if (autoDelete) {
+                delete job;
+            }
+
+            if (!m_numPendingJobs.deref()) {
+                QMutexLocker l(&m_doneLock);
+                m_doneCondition.wakeAll();
+            }
+
+            continue;
+        }
+
+        QMutexLocker l(&m_sleepLock);
+
+        if (m_stopRequested) break;
+
+        /**
+         * A job could have been queued after we checked the
+         * deques, but before we took the lock
+         */
+        if (m_numQueuedJobs.load() > 0) continue;
+
+        m_numSleepingWorkers++;
+        m_jobsAvailable.wait(&m_sleepLock);
+        m_numSleepingWorkers--;
+    }
+}
+
+void KisWorkStealingExecutor::waitForDone()
+{
+    QMutexLocker l(&m_doneLock);
+
+    while (m_numPendingJobs.load()) {
+        m_doneCondition.wait(&m_doneLock);
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_WORK_STEALING_EXECUTOR_H
+#define __KIS_WORK_STEALING_EXECUTOR_H
+
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+#include "kritaimage_export.h"
+
+class QRunnable;
+
+
+/**
+ * A thread pool with a deque of jobs per worker thread.
+ *
+ * When a job is started from inside one of the worker threads (e.g. when
+ * the scheduler fills the slot of a job that has just finished), it is
+ * pushed to the front of the deque of that very worker. The worker will
+ * execute it right after the current job is completed, without waking up
+ * any other thread. The jobs started from outside are distributed between
+ * the workers in a round-robin manner. An idle worker steals jobs from the
+ * back of the deques of the busy ones.
+ *
+ * The interface mimics the part of QThreadPool used by KisUpdaterContext.
+ * The threads are created lazily on the first call to start().
+ */
+class KRITAIMAGE_EXPORT KisWorkStealingExecutor
+{
+public:
+    KisWorkStealingExecutor(int numWorkers);
+    ~KisWorkStealingExecutor();
+
+    /**
+     * Schedules \p runnable for execution. If runnable->autoDelete()
+     * is true, the runnable is deleted after completion.
+     */
+    void start(QRunnable *runnable);
+
+    /**
+     * Blocks the caller until all the started jobs are completed,
+     * including the ones started by the jobs themselves
+     */
+    void waitForDone();
+
+    int numWorkers() const;
+
+private:
+    struct Worker;
+    friend struct Worker;
+
+    void startWorkers();
+    void workerLoop(int workerIndex);
+
+    int currentWorkerIndex() const;
+    QRunnable* takeJob(int workerIndex);
+
+private:
+    QVector<Worker*> m_workers;
+    QAtomicInt m_workersStarted;
+    QAtomicInt m_nextWorker;
+
+    /**
+     * Number of jobs sitting in the deques, not yet taken by a worker
+     */
+    QAtomicInt m_numQueuedJobs;
+
+    /**
+     * Number of jobs that are either queued or being executed
+     */
+    QAtomicInt m_numPendingJobs;
+
+    QMutex m_sleepLock;
+    QWaitCondition m_jobsAvailable;
+    int m_numSleepingWorkers;
+    bool m_stopRequested;
+
+    QMutex m_doneLock;
+    QWaitCondition m_doneCondition;
+};
+
+#endif /* __KIS_WORK_STEALING_EXECUTOR_H */
@@ -45,6 +45,7 @@
 #include "kis_processing_applicator.h"
 #include "krita_utils.h"
 #include "kis_command_utils.h"
+#include "kis_image_config.h"
 
 
 using namespace KisLazyFillTools;
@@ -60,6 +61,8 @@ struct KisColorizeMask::Private
           showColoring(true),
           needsUpdate(true),
           originalSequenceNumber(-1),
+          coloringSequenceNumber(-1),
+          coloringValid(false),
           updateCompressor(1, KisSignalCompressor::POSTPONE, q)
     {
     }
@@ -73,6 +76,8 @@ struct KisColorizeMask::Private
           showColoring(rhs.showColoring),
           needsUpdate(false),
           originalSequenceNumber(-1),
+          coloringSequenceNumber(-1),
+          coloringValid(false),
           updateCompressor(1000, KisSignalCompressor::POSTPONE, q),
           offset(rhs.offset)
     {
@@ -99,6 +104,22 @@ struct KisColorizeMask::Private
     bool needsUpdate;
     int originalSequenceNumber;
 
+    /**
+     * Lazy copies of the key strokes used for generation of the
+     * current coloring, keyed by the original devices. They let us
+     * find out which area of the coloring needs an update.
+     */
+    QHash<KisPaintDevice*, KeyStroke> coloringKeyStrokes;
+
+    /**
+     * The state of the coloring right after the regeneration. If
+     * anything else touches the device (a transformation, undo,
+     * etc.), the coloring is generated from scratch.
+     */
+    int coloringSequenceNumber;
+    QRect coloringExtent;
+    bool coloringValid;
+
     KisSignalCompressor updateCompressor;
     QPoint offset;
 };
@@ -249,6 +270,33 @@ void KisColorizeMask::setNeedsUpdate(bool value)
     }
 }
 
+QRect changedKeyStrokesRect(const QHash<KisPaintDevice*, KeyStroke> &oldStrokes,
+                            const QHash<KisPaintDevice*, KeyStroke> &newStrokes)
+{
+    QRect rect;
+
+    for (auto it = newStrokes.constBegin(); it != newStrokes.constEnd(); ++it) {
+        auto oldIt = oldStrokes.constFind(it.key());
+
+        if (oldIt == oldStrokes.constEnd()) {
+            rect |= it->dev->extent();
+        } else if (!(oldIt->color == it->color)) {
+            rect |= oldIt->dev->extent() | it->dev->extent();
+        } else {
+            rect |= findDifferenceRect(oldIt->dev, it->dev,
+                                       oldIt->dev->extent() | it->dev->extent());
+        }
+    }
+
+    for (auto it = oldStrokes.constBegin(); it != oldStrokes.constEnd(); ++it) {
+        if (!newStrokes.contains(it.key())) {
+            rect |= it->dev->extent();
+        }
+    }
+
+    return rect;
+}
+
 void KisColorizeMask::slotUpdateRegenerateFilling()
 {
     KisPaintDeviceSP src = parent()->original();
@@ -256,12 +304,9 @@ void KisColorizeMask::slotUpdateRegenerateFilling()
 
     bool filteredSourceValid = m_d->originalSequenceNumber == src->sequenceNumber();
     m_d->originalSequenceNumber = src->sequenceNumber();
-    m_d->coloringProjection->clear();
 
     KisLayerSP parentLayer(qobject_cast<KisLayer*>(parent().data()));
-    if (!parentLayer) return;
-
-    KisImageSP image = parentLayer->image();
+    KisImageSP image = parentLayer ? parentLayer->image() : KisImageWSP();
     if (image) {
         KisColorizeStrokeStrategy *strategy =
             new KisColorizeStrokeStrategy(src,
@@ -271,6 +316,8 @@ void KisColorizeMask::slotUpdateRegenerateFilling()
                                           image->bounds(),
                                           KisColorizeMaskSP(this));
 
+        QHash<KisPaintDevice*, KeyStroke> coloringKeyStrokes;
+
         Q_FOREACH (const KeyStroke &stroke, m_d->keyStrokes) {
             const KoColor color =
                 !stroke.isTransparent ?
@@ -278,16 +325,41 @@ void KisColorizeMask::slotUpdateRegenerateFilling()
                 KoColor(Qt::transparent, stroke.color.colorSpace());
 
             strategy->addKeyStroke(stroke.dev, color);
+
+            coloringKeyStrokes.insert(stroke.dev.data(),
+                                      KeyStroke(new KisPaintDevice(*stroke.dev), color));
         }
 
+        KisImageConfig cfg;
+
+        if (cfg.useIncrementalColorizeMask() &&
+            filteredSourceValid &&
+            m_d->coloringValid &&
+            m_d->coloringSequenceNumber == m_d->coloringProjection->sequenceNumber() &&
+            m_d->coloringExtent == m_d->coloringProjection->extent()) {
+
+            strategy->setIncrementalUpdateRect(
+                changedKeyStrokesRect(m_d->coloringKeyStrokes, coloringKeyStrokes));
+        }
+
+        m_d->coloringKeyStrokes = coloringKeyStrokes;
+        m_d->coloringValid = false;
+
         connect(strategy, SIGNAL(sigFinished()), SLOT(slotRegenerationFinished()));
         KisStrokeId id = image->startStroke(strategy);
         image->endStroke(id);
+    } else {
+        m_d->coloringProjection->clear();
+        m_d->coloringValid = false;
     }
 }
 
 void KisColorizeMask::slotRegenerationFinished()
 {
+    m_d->coloringSequenceNumber = m_d->coloringProjection->sequenceNumber();
+    m_d->coloringExtent = m_d->coloringProjection->extent();
+    m_d->coloringValid = true;
+
     setNeedsUpdate(true);
 }
 
@@ -813,6 +885,7 @@ void KisColorizeMask::resetCache()
 {
     m_d->filteredSource->clear();
     m_d->originalSequenceNumber = -1;
+    m_d->coloringValid = false;
 
     rerenderFakePaintDevice();
 }
@@ -29,12 +29,13 @@
 #include "kis_lod_transform.h"
 #include "kis_node.h"
 #include "kis_image_config.h"
+#include "kis_global.h"
 
 using namespace KisLazyFillTools;
 
 struct KisColorizeStrokeStrategy::Private
 {
-    Private() : filteredSourceValid(false) {}
+    Private() : filteredSourceValid(false), useIncrementalUpdate(false) {}
     Private(const Private &rhs)
         : src(rhs.src),
           dst(rhs.dst),
@@ -42,6 +43,8 @@ struct KisColorizeStrokeStrategy::Private
           internalFilteredSource(rhs.internalFilteredSource),
           filteredSourceValid(rhs.filteredSourceValid),
           boundingRect(rhs.boundingRect),
+          useIncrementalUpdate(rhs.useIncrementalUpdate),
+          changedRect(rhs.changedRect),
           keyStrokes(rhs.keyStrokes),
           dirtyNode(rhs.dirtyNode)
     {}
@@ -53,6 +56,9 @@ struct KisColorizeStrokeStrategy::Private
     bool filteredSourceValid;
     QRect boundingRect;
 
+    bool useIncrementalUpdate;
+    QRect changedRect;
+
     QVector<KeyStroke> keyStrokes;
     KisNodeSP dirtyNode;
 };
@@ -81,6 +87,11 @@ KisColorizeStrokeStrategy::KisColorizeStrokeStrategy(const KisColorizeStrokeStra
 {
     KisLodTransform t(levelOfDetail);
     m_d->boundingRect = t.map(rhs.m_d->boundingRect);
+
+    if (!rhs.m_d->changedRect.isEmpty()) {
+        // the scaling may shrink a tiny change into nothing
+        m_d->changedRect = kisGrowRect(t.map(rhs.m_d->changedRect), 1);
+    }
 }
 
 KisColorizeStrokeStrategy::~KisColorizeStrokeStrategy()
@@ -95,6 +106,12 @@ void KisColorizeStrokeStrategy::addKeyStroke(KisPaintDeviceSP dev, const KoColor
     m_d->keyStrokes << KeyStroke(dev, convertedColor);
 }
 
+void KisColorizeStrokeStrategy::setIncrementalUpdateRect(const QRect &changedRect)
+{
+    m_d->useIncrementalUpdate = true;
+    m_d->changedRect = changedRect;
+}
+
 void KisColorizeStrokeStrategy::initStrokeCallback()
 {
     if (!m_d->filteredSourceValid) {
@@ -113,15 +130,50 @@ void KisColorizeStrokeStrategy::initStrokeCallback()
         m_d->filteredSource->setDefaultBounds(oldBounds);
     }
 
-    KisMultiwayCut cut(m_d->filteredSource, m_d->dst, m_d->boundingRect);
+    QRect processRect = m_d->boundingRect;
+    QVector<KeyStroke> borderStrokes;
+
+    if (m_d->filteredSourceValid && m_d->useIncrementalUpdate) {
+        processRect = findAffectedColoringRect(m_d->dst, m_d->changedRect, m_d->boundingRect);
+
+        if (processRect.isEmpty()) {
+            emit sigFinished();
+            return;
+        }
+
+        borderStrokes = keyStrokesFromBorder(m_d->dst, processRect, m_d->boundingRect);
+        m_d->dst->clear(processRect);
+    } else {
+        m_d->dst->clear();
+    }
+
+    KisMultiwayCut cut(m_d->filteredSource, m_d->dst, processRect);
 
     Q_FOREACH (const KeyStroke &stroke, m_d->keyStrokes) {
-        cut.addKeyStroke(new KisPaintDevice(*stroke.dev), stroke.color);
+        // the strokes outside the area are represented by the border
+        if (!stroke.dev->extent().intersects(processRect)) continue;
+
+        KisPaintDeviceSP dev = new KisPaintDevice(*stroke.dev);
+
+        for (auto it = borderStrokes.begin(); it != borderStrokes.end(); ++it) {
+            if (it->color == stroke.color) {
+                KisPainter gc(dev);
+                gc.bitBlt(processRect.topLeft(), it->dev, processRect);
+                borderStrokes.erase(it);
+                break;
+            }
+        }
+
+        cut.addKeyStroke(dev, stroke.color);
+    }
+
+    Q_FOREACH (const KeyStroke &stroke, borderStrokes) {
+        cut.addKeyStroke(stroke.dev, stroke.color);
     }
 
     cut.run();
 
-    m_d->dirtyNode->setDirty(m_d->boundingRect);
+    m_d->dirtyNode->setDirty(processRect);
     emit sigFinished();
 }
 
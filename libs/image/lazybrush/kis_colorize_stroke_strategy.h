@@ -43,6 +43,15 @@ public:
 
     void addKeyStroke(KisPaintDeviceSP dev, const KoColor &color);
 
+    /**
+     * Tells the strategy that \p dst already contains the coloring
+     * for the current source and the key strokes differ from the
+     * ones used for it only inside \p changedRect. The strategy will
+     * recalculate only the patches of the coloring affected by the
+     * change. An empty \p changedRect means nothing has changed.
+     */
+    void setIncrementalUpdateRect(const QRect &changedRect);
+
     void initStrokeCallback() override;
 
     KisStrokeStrategy *createLodClone(int levelOfDetail) override;
@@ -40,9 +40,13 @@
 #include "lazybrush/kis_lazy_fill_capacity_map.h"
 
 #include "kis_sequential_iterator.h"
+#include "kis_random_accessor_ng.h"
+#include "kis_pixel_selection.h"
+#include <KoColorSpaceRegistry.h>
 #include <floodfill/kis_scanline_fill.h>
 
 #include "krita_utils.h"
+#include "kis_global.h"
 
 namespace KisLazyFillTools {
 
@@ -160,6 +164,134 @@ void cutOneWay(const KoColor &color,
 }
 
 
+QRect findDifferenceRect(KisPaintDeviceSP dev1, KisPaintDeviceSP dev2, const QRect &rect)
+{
+    KIS_ASSERT_RECOVER_RETURN_VALUE(dev1->pixelSize() == dev2->pixelSize(), rect);
+
+    QRect result;
+    if (rect.isEmpty()) return result;
+
+    const int pixelSize = dev1->pixelSize();
+    const int lineSize = rect.width() * pixelSize;
+    const int linesPerChunk = 64;
+
+    QVector<quint8> buf1(lineSize * linesPerChunk);
+    QVector<quint8> buf2(lineSize * linesPerChunk);
+
+    for (int y = rect.top(); y <= rect.bottom(); y += linesPerChunk) {
+        const QRect chunkRect(rect.left(), y,
+                              rect.width(), qMin(linesPerChunk, rect.bottom() - y + 1));
+
+        dev1->readBytes(buf1.data(), chunkRect);
+        dev2->readBytes(buf2.data(), chunkRect);
+
+        for (int row = 0; row < chunkRect.height(); row++) {
+            const quint8 *line1 = buf1.constData() + row * lineSize;
+            const quint8 *line2 = buf2.constData() + row * lineSize;
+
+            if (!memcmp(line1, line2, lineSize)) continue;
+
+            int left = 0;
+            while (line1[left] == line2[left]) left++;
+
+            int right = lineSize - 1;
+            while (line1[right] == line2[right]) right--;
+
+            left /= pixelSize;
+            right /= pixelSize;
+
+            result |= QRect(rect.left() + left, chunkRect.top() + row, right - left + 1, 1);
+        }
+    }
+
+    return result;
+}
+
+QRect findAffectedColoringRect(KisPaintDeviceSP coloring, const QRect &changedRect, const QRect &boundingRect)
+{
+    const QRect rect = changedRect & boundingRect;
+    if (rect.isEmpty()) return rect;
+
+    KisPixelSelectionSP affected = new KisPixelSelection();
+
+    /**
+     * Every seed adds the whole patch of its color to the selection,
+     * so the pixels covered by the already found patches are
+     * skipped. Like in splitIntoConnectedComponents() we must use a
+     * writable iterator to see the changes made by the fill.
+     */
+    KisSequentialIterator it(affected, rect);
+
+    do {
+        if (*it.rawData() != MIN_SELECTED) continue;
+
+        KisScanlineFill fill(coloring, QPoint(it.x(), it.y()), boundingRect);
+
+        // threshold 1 selects only the pixels of exactly the same color
+        fill.setThreshold(1);
+        fill.fillSelection(affected);
+    } while (it.nextPixel());
+
+    /**
+     * The patches are separated by the lineart, which belongs to one
+     * of them, so a small margin is enough to reach the neighbours.
+     */
+    const int margin = 2;
+    return kisGrowRect(affected->selectedExactRect() | rect, margin) & boundingRect;
+}
+
+QVector<KeyStroke> keyStrokesFromBorder(KisPaintDeviceSP coloring, const QRect &rect, const QRect &boundingRect)
+{
+    QVector<QRect> edges;
+
+    if (rect.top() > boundingRect.top()) {
+        edges << QRect(rect.left(), rect.top(), rect.width(), 1);
+    }
+    if (rect.bottom() < boundingRect.bottom()) {
+        edges << QRect(rect.left(), rect.bottom(), rect.width(), 1);
+    }
+    if (rect.left() > boundingRect.left()) {
+        edges << QRect(rect.left(), rect.top(), 1, rect.height());
+    }
+    if (rect.right() < boundingRect.right()) {
+        edges << QRect(rect.right(), rect.top(), 1, rect.height());
+    }
+
+    const KoColorSpace *cs = coloring->colorSpace();
+    const KoColorSpace *alpha8 = KoColorSpaceRegistry::instance()->alpha8();
+    const int pixelSize = cs->pixelSize();
+
+    QVector<KeyStroke> strokes;
+    QVector<KisRandomAccessorSP> accessors;
+
+    Q_FOREACH (const QRect &edge, edges) {
+        KisSequentialConstIterator it(coloring, edge);
+
+        do {
+            const quint8 *pixel = it.rawDataConst();
+
+            int index = 0;
+            while (index < strokes.size() &&
+                   memcmp(strokes[index].color.data(), pixel, pixelSize)) {
+                index++;
+            }
+
+            if (index == strokes.size()) {
+                KisPaintDeviceSP dev = new KisPaintDevice(alpha8);
+                const bool isTransparent = cs->opacityU8(pixel) == OPACITY_TRANSPARENT_U8;
+
+                strokes << KeyStroke(dev, KoColor(pixel, cs), isTransparent);
+                accessors << dev->createRandomAccessorNG(it.x(), it.y());
+            }
+
+            accessors[index]->moveTo(it.x(), it.y());
+            *accessors[index]->rawData() = OPACITY_OPAQUE_U8;
+        } while (it.nextPixel());
+    }
+
+    return strokes;
+}
+
 KeyStroke::KeyStroke()
     : isTransparent(false)
 {
@@ -65,6 +65,24 @@ namespace KisLazyFillTools
     KRITAIMAGE_EXPORT
     QVector<QPoint> splitIntoConnectedComponents(KisPaintDeviceSP src, const QRect &boundingRect);
 
+    /**
+     * Returns the bounding rect of the pixels that differ in \p dev1
+     * and \p dev2 inside \p rect. Both devices must have the same
+     * pixel size.
+     */
+    KRITAIMAGE_EXPORT
+    QRect findDifferenceRect(KisPaintDeviceSP dev1, KisPaintDeviceSP dev2, const QRect &rect);
+
+    /**
+     * Returns the area of the existing \p coloring that should be
+     * recalculated when the key strokes change inside \p
+     * changedRect. Every contiguous patch of the coloring touching
+     * the changed area may be recolored completely, so the rect
+     * covers all of them.
+     */
+    KRITAIMAGE_EXPORT
+    QRect findAffectedColoringRect(KisPaintDeviceSP coloring, const QRect &changedRect, const QRect &boundingRect);
+
     struct KRITAIMAGE_EXPORT KeyStroke : public boost::equality_comparable<KeyStroke>
     {
         KeyStroke();
@@ -76,6 +94,16 @@ namespace KisLazyFillTools
         KoColor color;
         bool isTransparent;
     };
+
+    /**
+     * Creates key strokes that freeze the existing \p coloring along
+     * the edges of \p rect. Passing them to the cut makes the
+     * recalculated area consistent with the coloring around it.
+     * Edges lying on \p boundingRect have no neighbours and are not
+     * frozen.
+     */
+    KRITAIMAGE_EXPORT
+    QVector<KeyStroke> keyStrokesFromBorder(KisPaintDeviceSP coloring, const QRect &rect, const QRect &boundingRect);
 };
 
 #endif /* __KIS_LAZY_FILL_TOOLS_H */
@@ -19,6 +19,7 @@
 #include "kis_colorize_mask_test.h"
 
 #include <QTest>
+#include <QElapsedTimer>
 
 #include "testutil.h"
 #include "lazybrush/kis_colorize_mask.h"
@@ -211,4 +212,96 @@ void KisColorizeMaskTest::testCrop()
     QCOMPARE(strokes[2].dev->exactBounds(), QRect(0,0,5,5));
 }
 
+void KisColorizeMaskTest::testIncrementalUpdate()
+{
+    const int cellSize = 150;
+    const int numCells = 3;
+    const QRect refRect(0, 0, cellSize * numCells, cellSize * numCells);
+
+    TestUtil::MaskParent p(refRect);
+    KisPaintDeviceSP src = p.layer->paintDevice();
+
+    const KoColorSpace *alpha8 = KoColorSpaceRegistry::instance()->alpha8();
+    const KoColorSpace *rgb8 = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisColorizeMaskSP mask = new KisColorizeMask();
+    p.image->addNode(mask, p.layer);
+    mask->initializeCompositeOp();
+
+    QVector<KisPaintDeviceSP> keys;
+    QVector<QPoint> samplePoints;
+
+    // a grid of closed cells with a key stroke in each of them
+    for (int row = 0; row < numCells; row++) {
+        for (int col = 0; col < numCells; col++) {
+            const QRect cellRect(col * cellSize, row * cellSize, cellSize, cellSize);
+
+            src->fill(kisGrowRect(cellRect, -5), KoColor(Qt::black, rgb8));
+            src->fill(kisGrowRect(cellRect, -15), KoColor(Qt::transparent, rgb8));
+
+            KisPaintDeviceSP key = new KisPaintDevice(alpha8);
+            key->fill(QRect(cellRect.center() - QPoint(5, 5), QSize(10, 10)), KoColor(Qt::black, alpha8));
+            mask->testingAddKeyStroke(key, KoColor(QColor(50 + 60 * row, 50 + 60 * col, 100), rgb8));
+
+            keys << key;
+            samplePoints << cellRect.center() << cellRect.topLeft() + QPoint(20, 20);
+        }
+    }
+
+    KisPaintDeviceSP background = new KisPaintDevice(alpha8);
+    background->fill(QRect(0, 0, 3, 3), KoColor(Qt::black, alpha8));
+    mask->testingAddKeyStroke(background, KoColor(Qt::white, rgb8), true);
+    samplePoints << QPoint(2, 2) << QPoint(cellSize, cellSize);
+
+    mask->resetCache();
+
+    QElapsedTimer timer;
+
+    timer.start();
+    mask->testingRegenerateMask();
+    p.image->waitForDone();
+    QCoreApplication::processEvents();
+    const qint64 fullTime = timer.elapsed();
+
+    // extend the key stroke of the central cell only
+    const QPoint center = refRect.center();
+    keys[numCells * numCells / 2]->fill(QRect(center + QPoint(20, 20), QSize(10, 10)), KoColor(Qt::black, alpha8));
+
+    timer.restart();
+    mask->testingRegenerateMask();
+    p.image->waitForDone();
+    QCoreApplication::processEvents();
+    const qint64 incrementalTime = timer.elapsed();
+
+    KisPaintDeviceSP incrementalResult = new KisPaintDevice(*mask->coloringProjection());
+
+    // nothing has changed, so the coloring should stay the same
+    timer.restart();
+    mask->testingRegenerateMask();
+    p.image->waitForDone();
+    QCoreApplication::processEvents();
+    const qint64 unchangedTime = timer.elapsed();
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, incrementalResult, mask->coloringProjection()));
+
+    // regenerate from scratch and compare with the incremental result
+    mask->resetCache();
+    mask->testingRegenerateMask();
+    p.image->waitForDone();
+    QCoreApplication::processEvents();
+
+    Q_FOREACH (const QPoint &pt, samplePoints) {
+        KoColor incrementalColor;
+        KoColor fullColor;
+
+        incrementalResult->pixel(pt.x(), pt.y(), &incrementalColor);
+        mask->coloringProjection()->pixel(pt.x(), pt.y(), &fullColor);
+
+        QCOMPARE(incrementalColor, fullColor);
+    }
+
+    qDebug() << ppVar(fullTime) << ppVar(incrementalTime) << ppVar(unchangedTime);
+}
+
 QTEST_MAIN(KisColorizeMaskTest)
@@ -27,6 +27,7 @@ class KisColorizeMaskTest : public QObject
 private Q_SLOTS:
     void test();
     void testCrop();
+    void testIncrementalUpdate();
 };
 
 #endif /* __KIS_COLORIZE_MASK_TEST_H */
@@ -32,6 +32,7 @@
 #include "kis_convolution_painter.h"
 #include "kis_convolution_kernel.h"
 #include <kis_gaussian_kernel.h>
+#include <kis_stacked_box_blur.h>
 #include <kis_mask_generator.h>
 #include "testutil.h"
 
@@ -437,4 +438,142 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testStackedBoxBlur()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect applyRect(0, 0, 200, 200);
+    const qreal radius = 30;
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(applyRect, KoColor(Qt::black, cs));
+    dev->fill(QRect(70, 70, 60, 60), KoColor(Qt::white, cs));
+
+    KisPaintDeviceSP boxDev = new KisPaintDevice(*dev);
+
+    QBitArray channelFlags = cs->channelFlags(true, true);
+
+    KisPaintDeviceSP interm = new KisPaintDevice(cs);
+    KisConvolutionKernelSP kernelHoriz = KisGaussianKernel::createHorizontalKernel(radius);
+    KisConvolutionKernelSP kernelVertical = KisGaussianKernel::createVerticalKernel(radius);
+    const int verticalCenter = kernelVertical->height() / 2;
+
+    KisConvolutionPainter horizPainter(interm, KisConvolutionPainter::SPATIAL);
+    horizPainter.setChannelFlags(channelFlags);
+    horizPainter.applyMatrix(kernelHoriz, dev,
+                             applyRect.topLeft() - QPoint(0, verticalCenter),
+                             applyRect.topLeft() - QPoint(0, verticalCenter),
+                             applyRect.size() + QSize(0, 2 * verticalCenter),
+                             BORDER_REPEAT);
+
+    KisConvolutionPainter verticalPainter(dev, KisConvolutionPainter::SPATIAL);
+    verticalPainter.setChannelFlags(channelFlags);
+    verticalPainter.applyMatrix(kernelVertical, interm,
+                                applyRect.topLeft(), applyRect.topLeft(),
+                                applyRect.size(), BORDER_REPEAT);
+
+    const qreal sigma = KisGaussianKernel::sigmaFromRadius(radius);
+    KisStackedBoxBlur::applyGaussian(boxDev, applyRect, sigma, sigma, channelFlags, 0);
+
+    const int numBytes = applyRect.width() * applyRect.height() * cs->pixelSize();
+    QVector<quint8> expected(numBytes);
+    QVector<quint8> result(numBytes);
+
+    dev->readBytes(expected.data(), applyRect);
+    boxDev->readBytes(result.data(), applyRect);
+
+    // three boxes approximate the gaussian within a couple of percent
+    const int tolerance = 8;
+
+    int maxDifference = 0;
+    for (int i = 0; i < numBytes; i++) {
+        maxDifference = qMax(maxDifference, qAbs(int(expected[i]) - int(result[i])));
+    }
+
+    QVERIFY2(maxDifference <= tolerance,
+             QString("Max difference: %1").arg(maxDifference).toLatin1());
+}
+
+void KisConvolutionPainterTest::testTiledFFTW()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // bigger than a single tile in both directions
+    const QRect applyRect(0, 0, 1100, 700);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(applyRect, KoColor(Qt::black, cs));
+    dev->fill(QRect(100, 100, 800, 40), KoColor(Qt::white, cs));
+    dev->fill(QRect(450, 0, 60, 700), KoColor(Qt::red, cs));
+
+    KisConvolutionKernelSP kernel = KisGaussianKernel::createHorizontalKernel(20);
+
+    KisPaintDeviceSP wholeDev = new KisPaintDevice(cs);
+    KisPaintDeviceSP tiledDev = new KisPaintDevice(cs);
+
+    KisConvolutionPainter wholePainter(wholeDev, KisConvolutionPainter::FFTW);
+    wholePainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                             applyRect.size(), BORDER_REPEAT);
+
+    KisConvolutionPainter tiledPainter(tiledDev, KisConvolutionPainter::FFTW_TILED);
+    tiledPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                             applyRect.size(), BORDER_REPEAT);
+
+    const int numBytes = applyRect.width() * applyRect.height() * cs->pixelSize();
+    QVector<quint8> expected(numBytes);
+    QVector<quint8> result(numBytes);
+
+    wholeDev->readBytes(expected.data(), applyRect);
+    tiledDev->readBytes(result.data(), applyRect);
+
+    // the transforms of different sizes may round differently
+    int maxDifference = 0;
+    for (int i = 0; i < numBytes; i++) {
+        maxDifference = qMax(maxDifference, qAbs(int(expected[i]) - int(result[i])));
+    }
+
+    QVERIFY2(maxDifference <= 1,
+             QString("Max difference: %1").arg(maxDifference).toLatin1());
+}
+
+void KisConvolutionPainterTest::testInPlaceFFTW()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // big enough for the painter to consider the tiled mode
+    const QRect applyRect(0, 0, 1100, 1000);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(applyRect, KoColor(Qt::black, cs));
+    dev->fill(QRect(100, 100, 800, 40), KoColor(Qt::white, cs));
+    dev->fill(QRect(450, 0, 60, 1000), KoColor(Qt::red, cs));
+
+    KisConvolutionKernelSP kernel = KisGaussianKernel::createHorizontalKernel(20);
+
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(cs);
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+    // the source is also the destination, like in the blur filters
+    KisConvolutionPainter inPlacePainter(dev, KisConvolutionPainter::NONE);
+    inPlacePainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+    const int numBytes = applyRect.width() * applyRect.height() * cs->pixelSize();
+    QVector<quint8> expected(numBytes);
+    QVector<quint8> result(numBytes);
+
+    spatialDev->readBytes(expected.data(), applyRect);
+    dev->readBytes(result.data(), applyRect);
+
+    // the spatial and the FFT engines may round differently
+    int maxDifference = 0;
+    for (int i = 0; i < numBytes; i++) {
+        maxDifference = qMax(maxDifference, qAbs(int(expected[i]) - int(result[i])));
+    }
+
+    QVERIFY2(maxDifference <= 1,
+             QString("Max difference: %1").arg(maxDifference).toLatin1());
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
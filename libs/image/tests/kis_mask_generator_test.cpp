@@ -26,6 +26,13 @@
 #include <QDomDocument>
 #include <QImage>
 
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_random_source.h"
+#include "kis_cubic_curve.h"
+#include "kis_fixed_paint_device.h"
+#include "kis_brush_mask_applicator_base.h"
+
 QImage createQImageFromMask(const KisMaskGenerator& generator)
 {
     QImage image(10, 10, QImage::Format_ARGB32);
@@ -103,8 +110,6 @@ void KisMaskGeneratorTest::testSquareSerialisation()
     delete cmg2;
 }
 
-#include "kis_random_source.h"
-
 void testCopyCtor(KisMaskGenerator *gen1)
 {
     QScopedPointer<KisMaskGenerator> gen2(gen1->clone());
@@ -141,8 +146,6 @@ void KisMaskGeneratorTest::testCopyCtorRect()
     testCopyCtor(&gen);
 }
 
-#include "kis_cubic_curve.h"
-
 void KisMaskGeneratorTest::testCopyCtorCurveCircle()
 {
     KisCurveCircleMaskGenerator gen(50, 0.8,
@@ -181,5 +184,78 @@ void KisMaskGeneratorTest::testCopyCtorGaussRect()
     testCopyCtor(&gen);
 }
 
+void testVectorApplicator(KisMaskGenerator *gen)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
+    const QRect rc(0, 0, 100, 100);
+
+    KisFixedPaintDeviceSP scalarDev = new KisFixedPaintDevice(cs);
+    scalarDev->setRect(rc);
+    scalarDev->initialize(255);
+
+    KisFixedPaintDeviceSP vectorDev = new KisFixedPaintDevice(cs);
+    vectorDev->setRect(rc);
+    vectorDev->initialize(255);
+
+    MaskProcessingData scalarData(scalarDev, cs, 0.0, 1.0, 50, 50, 0.3);
+    MaskProcessingData vectorData(vectorDev, cs, 0.0, 1.0, 50, 50, 0.3);
+
+    // the base class always returns the plain scalar applicator
+    KisBrushMaskApplicatorBase *scalarApplicator = gen->KisMaskGenerator::applicator();
+    scalarApplicator->initializeData(&scalarData);
+    scalarApplicator->process(rc);
+
+    KisBrushMaskApplicatorBase *vectorApplicator = gen->applicator();
+    vectorApplicator->initializeData(&vectorData);
+    vectorApplicator->process(rc);
+
+    const quint8 *scalarPtr = scalarDev->data();
+    const quint8 *vectorPtr = vectorDev->data();
+
+    for (int i = 0; i < rc.width() * rc.height(); i++) {
+        // the scalar version truncates the values, so allow some difference
+        if (qAbs(int(scalarPtr[i]) - int(vectorPtr[i])) > 3) {
+            qDebug() << ppVar(i % rc.width()) << ppVar(i / rc.width())
+                     << ppVar(scalarPtr[i]) << ppVar(vectorPtr[i]);
+            QFAIL("vector and scalar applicators differ");
+        }
+    }
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorCircle()
+{
+    KisCircleMaskGenerator gen(80, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorRect()
+{
+    KisRectangleMaskGenerator gen(80, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorCurveCircle()
+{
+    KisCurveCircleMaskGenerator gen(80, 0.8, 0.75, 0.85, 2, KisCubicCurve(), true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorCurveRect()
+{
+    KisCurveRectangleMaskGenerator gen(80, 0.8, 0.75, 0.85, 2, KisCubicCurve(), true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorGaussCircle()
+{
+    KisGaussCircleMaskGenerator gen(80, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorGaussRect()
+{
+    KisGaussRectangleMaskGenerator gen(80, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
 
 QTEST_MAIN(KisMaskGeneratorTest)
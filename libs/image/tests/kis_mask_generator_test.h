@@ -37,6 +37,13 @@ private Q_SLOTS:
 
     void testCopyCtorGaussCircle();
     void testCopyCtorGaussRect();
+
+    void testVectorApplicatorCircle();
+    void testVectorApplicatorRect();
+    void testVectorApplicatorCurveCircle();
+    void testVectorApplicatorCurveRect();
+    void testVectorApplicatorGaussCircle();
+    void testVectorApplicatorGaussRect();
 };
 
 #endif
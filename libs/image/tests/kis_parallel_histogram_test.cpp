@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_parallel_histogram_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include "kis_paint_device.h"
+#include "kis_iterator_ng.h"
+#include "kis_parallel_histogram.h"
+#include "testutil.h"
+
+QVector<QVector<quint32>> naiveHistogram(KisPaintDeviceSP dev, const QRect &rect)
+{
+    const KoColorSpace *cs = dev->colorSpace();
+    const int channelCount = cs->channelCount();
+
+    QVector<QVector<quint32>> bins(channelCount, QVector<quint32>(KisParallelHistogram::numBins, 0));
+
+    KisSequentialConstIterator it(dev, rect);
+    do {
+        for (int c = 0; c < channelCount; c++) {
+            bins[c][cs->scaleToU8(it.rawDataConst(), c)]++;
+        }
+    } while (it.nextPixel());
+
+    return bins;
+}
+
+bool checkHistogram(const KisParallelHistogram &histogram, KisPaintDeviceSP dev)
+{
+    QVector<QVector<quint32>> bins = naiveHistogram(dev, histogram.bounds() & dev->exactBounds());
+
+    if (histogram.channelCount() != bins.size()) {
+        qDebug() << "Wrong number of channels:" << histogram.channelCount() << bins.size();
+        return false;
+    }
+
+    for (int c = 0; c < bins.size(); c++) {
+        if (histogram.bins(c) != bins[c]) {
+            qDebug() << "Histogram of channel" << c << "differs";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void KisParallelHistogramTest::test_data()
+{
+    QTest::addColumn<QString>("depthId");
+
+    QTest::newRow("u8") << Integer8BitsColorDepthID.id();
+    QTest::newRow("u16") << Integer16BitsColorDepthID.id();
+    QTest::newRow("f32") << Float32BitsColorDepthID.id();
+}
+
+void KisParallelHistogramTest::test()
+{
+    QFETCH(QString, depthId);
+
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthId, 0);
+    QVERIFY(cs);
+
+    QImage image(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->convertFromQImage(image, 0, 0, 0);
+    dev->fill(QRect(500, 0, 200, 200), KoColor(Qt::green, cs));
+
+    // the bounds cross the borders of the blocks
+    const QRect bounds(-10, 5, 700, 600);
+
+    KisParallelHistogram histogram(bounds);
+    histogram.update(dev);
+    QVERIFY(checkHistogram(histogram, dev));
+
+    // only the blocks touched by the change are recalculated
+    const QRect dirtyRect(230, 200, 100, 80);
+    dev->fill(dirtyRect, KoColor(Qt::red, cs));
+
+    histogram.update(dev, QVector<QRect>() << dirtyRect);
+    QVERIFY(checkHistogram(histogram, dev));
+
+    // the change extends the exact bounds of the device
+    const QRect extendingRect(650, 550, 20, 20);
+    dev->fill(extendingRect, KoColor(Qt::blue, cs));
+
+    histogram.update(dev, QVector<QRect>() << extendingRect);
+    QVERIFY(checkHistogram(histogram, dev));
+}
+
+QTEST_MAIN(KisParallelHistogramTest)
@@ -30,6 +30,7 @@
 #include <KoColorSpaceRegistry.h>
 #include "kis_types.h"
 #include "kis_paint_device.h"
+#include "kis_pixel_selection.h"
 
 
 void KisScanlineFillTest::testFillGeneral(const QVector<KisFillInterval> &initialBackwardIntervals,
@@ -295,4 +296,49 @@ void KisScanlineFillTest::testExternalFill()
     QCOMPARE(c, QColor(Qt::blue));
 }
 
+void KisScanlineFillTest::testMultithreadedSelectionFill()
+{
+    const QRect boundingRect(-30, -20, 600, 500);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dev->fill(boundingRect, KoColor(Qt::white, dev->colorSpace()));
+
+    // a maze of walls with slightly different colors, so that both the
+    // connectivity and the smooth opacity are checked
+    qsrand(123456);
+    for (int i = 0; i < 400; i++) {
+        const QRect wall(boundingRect.x() + qrand() % boundingRect.width(),
+                         boundingRect.y() + qrand() % boundingRect.height(),
+                         i % 2 ? 1 + qrand() % 100 : 2,
+                         i % 2 ? 2 : 1 + qrand() % 100);
+
+        const int gray = qrand() % 256;
+        dev->fill(wall, KoColor(QColor(gray, gray, gray), dev->colorSpace()));
+    }
+
+    KisPixelSelectionSP singleThreaded = new KisPixelSelection();
+    KisPixelSelectionSP multithreaded = new KisPixelSelection();
+
+    {
+        KisScanlineFill fill(dev, QPoint(2, 3), boundingRect);
+        fill.setThreshold(100);
+        fill.setUseMultithreading(false);
+        fill.fillSelection(singleThreaded);
+    }
+
+    {
+        KisScanlineFill fill(dev, QPoint(2, 3), boundingRect);
+        fill.setThreshold(100);
+        fill.setUseMultithreading(true);
+        fill.fillSelection(multithreaded);
+    }
+
+    QVERIFY(!singleThreaded->selectedExactRect().isEmpty());
+
+    QPoint errorPoint;
+    if (!TestUtil::comparePaintDevices(errorPoint, singleThreaded, multithreaded)) {
+        QFAIL(QString("Selections differ at %1,%2").arg(errorPoint.x()).arg(errorPoint.y()).toLatin1());
+    }
+}
+
 QTEST_MAIN(KisScanlineFillTest)
@@ -25,6 +25,7 @@
 #include <KoColorSpaceRegistry.h>
 #include <QTransform>
 #include <QVector>
+#include <QThreadPool>
 
 #include "kis_types.h"
 #include "kis_image.h"
@@ -931,6 +932,45 @@ void KisTransformWorkerTest::benchmarkScaleRotateShear()
     }
 }
 
+void KisTransformWorkerTest::benchmarkScaleBigLayer_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("16 threads") << 16;
+}
+
+void KisTransformWorkerTest::benchmarkScaleBigLayer()
+{
+    QFETCH(int, numThreads);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(QRect(0, 0, 4000, 4000), KoColor(Qt::red, cs));
+    dev->fill(QRect(1000, 1000, 2000, 2000), KoColor(Qt::blue, cs));
+
+    KisFilterStrategy *filter = new KisBicubicFilterStrategy();
+
+    const int oldMaxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+
+    QBENCHMARK {
+        KisPaintDeviceSP tmpDev = new KisPaintDevice(*dev);
+
+        KisTransformWorker tw(tmpDev, 1.379, 0.8,
+                              0.0, 0.0,
+                              0.0, 0.0,
+                              M_PI / 6.0,
+                              0, 0, 0, filter);
+        tw.run();
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(oldMaxThreadCount);
+
+    delete filter;
+}
+
 void KisTransformWorkerTest::generateTestImages()
 {
     QList<KisFilterStrategy*> filters;
@@ -61,6 +61,8 @@ private Q_SLOTS:
     void benchmarkRotate1Q();
     void benchmarkShear();
     void benchmarkScaleRotateShear();
+    void benchmarkScaleBigLayer_data();
+    void benchmarkScaleBigLayer();
 
     void testPartialProcessing();
 
@@ -27,6 +27,7 @@
 
 #include "kis_merge_walker.h"
 #include "kis_updater_context.h"
+#include "kis_work_stealing_executor.h"
 #include "kis_image.h"
 
 #include "scheduler_utils.h"
@@ -237,5 +238,59 @@ void KisUpdaterContextTest::stressTestExclusiveJobs()
              << "/" << NUM_CHECKS * NUM_JOBS;
 }
 
+class SpawningRunnable : public QRunnable
+{
+public:
+    SpawningRunnable(KisWorkStealingExecutor &executor, QAtomicInt &counter, int depth)
+        : m_executor(executor),
+          m_counter(counter),
+          m_depth(depth)
+    {
+    }
+
+    void run() override {
+        m_counter.ref();
+
+        /**
+         * Start the children from inside a worker thread, they
+         * should end up in the local deque of the worker
+         */
+        if (m_depth > 0) {
+            m_executor.start(new SpawningRunnable(m_executor, m_counter, m_depth - 1));
+            m_executor.start(new SpawningRunnable(m_executor, m_counter, m_depth - 1));
+        }
+    }
+
+private:
+    KisWorkStealingExecutor &m_executor;
+    QAtomicInt &m_counter;
+    int m_depth;
+};
+
+void KisUpdaterContextTest::testWorkStealingExecutor()
+{
+    const int numRootJobs = 16;
+    const int depth = 8;
+
+    QAtomicInt counter;
+
+    {
+        KisWorkStealingExecutor executor(NUM_THREADS);
+
+        for (int i = 0; i < numRootJobs; i++) {
+            executor.start(new SpawningRunnable(executor, counter, depth));
+        }
+
+        executor.waitForDone();
+        QCOMPARE(counter.load(), numRootJobs * ((1 << (depth + 1)) - 1));
+
+        // the executor is reusable after waitForDone()
+        executor.start(new SpawningRunnable(executor, counter, 0));
+        executor.waitForDone();
+    }
+
+    QCOMPARE(counter.load(), numRootJobs * ((1 << (depth + 1)) - 1) + 1);
+}
+
 QTEST_MAIN(KisUpdaterContextTest)
 
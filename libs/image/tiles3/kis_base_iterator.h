@@ -71,6 +71,17 @@ protected:
     inline qint32 calcYInTile(qint32 y, qint32 row) const {
         return y - row * KisTileData::HEIGHT;
     }
+
+    /**
+     * The number of tile rows (or columns for vertical iterators)
+     * that are prefetched ahead of the current one
+     */
+    static const qint32 PREFETCH_LINES_AHEAD = 2;
+
+    inline void prefetchTiles(qint32 leftCol, qint32 topRow,
+                              qint32 rightCol, qint32 bottomRow) const {
+        m_dataManager->prefetchTiles(leftCol, topRow, rightCol, bottomRow);
+    }
     
 private:
     KisIteratorCompleteListener *m_completeListener;
@@ -0,0 +1,193 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_compressed_tiles_cache.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "kis_tile_data.h"
+#include "kis_tile_data_store.h"
+#include "kis_image_config.h"
+
+
+namespace {
+
+struct TileKey
+{
+    KisTileData *tileData;
+    qint32 col;
+    qint32 row;
+
+    bool operator==(const TileKey &rhs) const {
+        return tileData == rhs.tileData &&
+            col == rhs.col && row == rhs.row;
+    }
+};
+
+inline uint qHash(const TileKey &key)
+{
+    return ::qHash(key.tileData) ^ ::qHash(key.col) ^ (::qHash(key.row) << 16);
+}
+
+struct CachedTile
+{
+    int codec;
+    QByteArray data;
+    int serial;
+    int generation;
+};
+
+}
+
+struct KisCompressedTilesCache::Private
+{
+    QHash<TileKey, CachedTile> tiles;
+    int generation = 0;
+    int numFetchedTiles = 0;
+    int numAddedTiles = 0;
+    qint64 size = 0;
+    qint64 maxSize = 0;
+    mutable QMutex mutex;
+
+    void resize(qint64 delta) {
+        size += delta;
+        KisTileDataStore::instance()->notifyCompressedTilesCacheResized(delta);
+    }
+};
+
+KisCompressedTilesCache::KisCompressedTilesCache(qint64 maxSize)
+    : m_d(new Private)
+{
+    /**
+     * The compressed streams are usually much smaller than the
+     * tiles themselves, so an eighth of the tiles memory is enough
+     * for caching a document that fits into the memory
+     */
+    if (maxSize < 0) {
+        maxSize = qint64(KisImageConfig(true).tilesHardLimit()) * 1024 * 1024 / 8;
+    }
+
+    m_d->maxSize = maxSize;
+}
+
+KisCompressedTilesCache::~KisCompressedTilesCache()
+{
+    clear();
+}
+
+void KisCompressedTilesCache::beginSaving()
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->generation++;
+    m_d->numFetchedTiles = 0;
+    m_d->numAddedTiles = 0;
+}
+
+void KisCompressedTilesCache::endSaving()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    auto it = m_d->tiles.begin();
+    while (it != m_d->tiles.end()) {
+        if (it.value().generation != m_d->generation) {
+            m_d->resize(-it.value().data.size());
+            it.key().tileData->deref();
+            it = m_d->tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool KisCompressedTilesCache::fetchTile(KisTileData *td, qint32 col, qint32 row, int codec, QByteArray &buffer)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    auto it = m_d->tiles.find({td, col, row});
+    if (it == m_d->tiles.end() ||
+        it.value().codec != codec ||
+        it.value().serial != td->contentSerial()) {
+
+        return false;
+    }
+
+    it.value().generation = m_d->generation;
+    buffer.append(it.value().data);
+    m_d->numFetchedTiles++;
+
+    return true;
+}
+
+void KisCompressedTilesCache::addTile(KisTileData *td, qint32 col, qint32 row, int codec, const QByteArray &data)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    const TileKey key = {td, col, row};
+
+    auto it = m_d->tiles.find(key);
+    const qint64 oldSize = it != m_d->tiles.end() ? it.value().data.size() : 0;
+
+    if (m_d->size - oldSize + data.size() > m_d->maxSize) {
+        return;
+    }
+
+    if (it == m_d->tiles.end()) {
+        td->ref();
+        it = m_d->tiles.insert(key, CachedTile());
+    }
+
+    m_d->resize(data.size() - oldSize);
+
+    it.value().codec = codec;
+    it.value().data = data;
+    it.value().serial = td->contentSerial();
+    it.value().generation = m_d->generation;
+    m_d->numAddedTiles++;
+}
+
+void KisCompressedTilesCache::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    for (auto it = m_d->tiles.begin(); it != m_d->tiles.end(); ++it) {
+        it.key().tileData->deref();
+    }
+    m_d->tiles.clear();
+    m_d->resize(-m_d->size);
+}
+
+qint64 KisCompressedTilesCache::size() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->size;
+}
+
+int KisCompressedTilesCache::numFetchedTiles() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->numFetchedTiles;
+}
+
+int KisCompressedTilesCache::numAddedTiles() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->numAddedTiles;
+}
@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_COMPRESSED_TILES_CACHE_H
+#define KIS_COMPRESSED_TILES_CACHE_H
+
+#include <QScopedPointer>
+#include <QtGlobal>
+
+#include "kritaimage_export.h"
+
+class QByteArray;
+class KisTileData;
+
+
+/**
+ * Keeps the compressed streams of the tiles written by the previous
+ * save of a document, so that the next save can reuse the streams of
+ * all the tiles that have not been changed since then.
+ *
+ * A tile is considered unchanged if it still refers to the same tile
+ * data and the content serial of the data has not changed since the
+ * tile was added. The cache only references the tile datas it keeps,
+ * without becoming their user, so writing into a cached tile doesn't
+ * cause copy-on-write, and the pointer to the data cannot be reused
+ * by another tile meanwhile.
+ *
+ * The tiles not used by a save are dropped from the cache in
+ * endSaving(), so the cache never holds more than one version of
+ * the document. The tile datas of the removed layers are kept
+ * referenced until then.
+ *
+ * The compressed streams cannot be swapped out, so their total size
+ * is limited and is accounted in the memory metric of the tile data
+ * store. The swapper keeps the tiles memory within the limits taking
+ * the cache into account.
+ */
+class KRITAIMAGE_EXPORT KisCompressedTilesCache
+{
+public:
+    /**
+     * Creates a cache holding at most \a maxSize bytes of compressed
+     * streams. If \a maxSize is negative, the limit is a part of
+     * KisImageConfig::tilesHardLimit().
+     */
+    explicit KisCompressedTilesCache(qint64 maxSize = -1);
+    ~KisCompressedTilesCache();
+
+    /**
+     * Starts a new save of the document
+     */
+    void beginSaving();
+
+    /**
+     * Drops all the tiles that have not been fetched or added
+     * since the last call to beginSaving()
+     */
+    void endSaving();
+
+    /**
+     * Appends the cached stream of the tile with data \p td placed at
+     * (\p col, \p row) and compressed with \p codec to \p buffer.
+     *
+     * \return false if the tile has been changed since the last save
+     */
+    bool fetchTile(KisTileData *td, qint32 col, qint32 row, int codec, QByteArray &buffer);
+
+    /**
+     * Adds a compressed stream of the tile to the cache. The stream
+     * is not added if the cache is full.
+     */
+    void addTile(KisTileData *td, qint32 col, qint32 row, int codec, const QByteArray &data);
+
+    /**
+     * The number of tiles fetched from the cache since the last call
+     * to beginSaving()
+     */
+    int numFetchedTiles() const;
+
+    /**
+     * The number of tiles added to the cache since the last call
+     * to beginSaving()
+     */
+    int numAddedTiles() const;
+
+    /**
+     * The total size of the cached streams in bytes
+     */
+    qint64 size() const;
+
+    /**
+     * Drops all the cached tiles
+     */
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* KIS_COMPRESSED_TILES_CACHE_H */
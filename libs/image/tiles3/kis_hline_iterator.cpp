@@ -58,6 +58,9 @@ KisHLineIterator2::KisHLineIterator2(KisDataManager *dataManager, qint32 x, qint
 
     m_tileWidth = m_pixelSize * KisTileData::HEIGHT;
 
+    // ask the store to swap in the rows we are going to walk through
+    prefetchTiles(m_leftCol, m_row, m_rightCol, m_row + PREFETCH_LINES_AHEAD);
+
     // let's prealocate first row
     for (quint32 i = 0; i < m_tilesCacheSize; i++){
         fetchTileDataForCache(m_tilesCache[i], m_leftCol + i, m_row);
@@ -119,6 +122,8 @@ void KisHLineIterator2::nextRow()
     } else {
         ++m_row;
         m_yInTile = 0;
+        prefetchTiles(m_leftCol, m_row + PREFETCH_LINES_AHEAD,
+                      m_rightCol, m_row + PREFETCH_LINES_AHEAD);
         preallocateTiles();
     }
     m_index = 0;
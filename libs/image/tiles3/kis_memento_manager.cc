@@ -209,6 +209,10 @@ void KisMementoManager::commit()
     m_currentMemento = 0;
     Q_ASSERT(m_index.isEmpty());
 
+    setRevisionOldHistory(m_revisions.size() - 1 -
+                          KisTileDataStore::instance()->historyRevisionsInMemory(),
+                          true);
+
     DEBUG_DUMP_MESSAGE("COMMIT_DONE");
 
     // Waking up pooler to prepare copies for us
@@ -303,6 +307,15 @@ void KisMementoManager::rollback(KisTileHashTable *ht)
     Q_ASSERT(!namedTransactionInProgress());
 
     m_cancelledRevisions.prepend(changeList);
+
+    /**
+     * The revisions have come closer to the head of the history,
+     * so they are likely to be undone soon as well
+     */
+    setRevisionOldHistory(m_revisions.size() -
+                          KisTileDataStore::instance()->historyRevisionsInMemory(),
+                          false);
+
     DEBUG_DUMP_MESSAGE("UNDONE");
 
     // Waking up pooler to prepare copies for us
@@ -384,6 +397,51 @@ void KisMementoManager::resetRevisionHistory(KisMementoItemList list)
     }
 }
 
+void KisMementoManager::setRevisionOldHistory(qint32 revisionIndex, bool value)
+{
+    if (revisionIndex < 0 || revisionIndex >= m_revisions.size()) return;
+
+    KisMementoItemSP mi;
+    Q_FOREACH (mi, m_revisions[revisionIndex].itemList) {
+        if (mi->type() == KisMementoItem::CHANGED) {
+            mi->tileData()->setOldHistory(value);
+        }
+    }
+}
+
+inline void addHistorySize(const KisHistoryList &list,
+                           qint64 &memorySize, qint64 &swappedSize)
+{
+    const qint64 tileArea = KisTileData::WIDTH * KisTileData::HEIGHT;
+
+    Q_FOREACH (const KisHistoryItem &item, list) {
+        Q_FOREACH (KisMementoItemSP mi, item.itemList) {
+            KisTileData *td = mi->tileData();
+
+            if (mi->type() != KisMementoItem::CHANGED ||
+                !td || !td->historical()) {
+
+                continue;
+            }
+
+            if (td->data()) {
+                memorySize += td->pixelSize() * tileArea;
+            } else {
+                swappedSize += td->pixelSize() * tileArea;
+            }
+        }
+    }
+}
+
+void KisMementoManager::calculateHistorySize(qint64 &memorySize, qint64 &swappedSize) const
+{
+    memorySize = 0;
+    swappedSize = 0;
+
+    addHistorySize(m_revisions, memorySize, swappedSize);
+    addHistorySize(m_cancelledRevisions, memorySize, swappedSize);
+}
+
 void KisMementoManager::setDefaultTileData(KisTileData *defaultTileData)
 {
     m_headsHashTable.setDefaultTileData(defaultTileData);
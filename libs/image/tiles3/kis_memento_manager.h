@@ -111,10 +111,24 @@ public:
      */
     void purgeHistory(KisMementoSP oldestMemento);
 
+    /**
+     * Calculates the size of the tile datas, that are used
+     * by the history only, in bytes. Tile datas present in memory
+     * and swapped out ones are counted separately.
+     */
+    void calculateHistorySize(qint64 &memorySize, qint64 &swappedSize) const;
+
 protected:
     qint32 findRevisionByMemento(KisMementoSP memento) const;
     void resetRevisionHistory(KisMementoItemList list);
 
+    /**
+     * Marks the tile datas of the revision as (not) old, so that
+     * the swapper could move them out of memory ahead of the
+     * others. Out-of-range indexes are ignored.
+     */
+    void setRevisionOldHistory(qint32 revisionIndex, bool value);
+
 protected:
     /**
      * INDEX of tiles to be committed with next commit()
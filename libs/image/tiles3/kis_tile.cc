@@ -143,6 +143,13 @@ inline void KisTile::unblockSwapping() const
             }
             m_oldTileData.clear();
         }
+
+        if(!m_oldSharedData.isEmpty()) {
+            Q_FOREACH (const KisTileData::SharedDataRef &ref, m_oldSharedData) {
+                KisTileData::releaseSharedData(ref);
+            }
+            m_oldSharedData.clear();
+        }
     }
 }
 
@@ -160,6 +167,34 @@ inline void KisTile::safeReleaseOldTileData(KisTileData *td)
     }
 }
 
+inline void KisTile::safeReleaseOldSharedData(const KisTileData::SharedDataRef &ref)
+{
+    QMutexLocker locker(&m_swapBarrierLock);
+    Q_ASSERT(m_lockCounter >= 0);
+
+    /**
+     * The readers of the tile might still be reading the old
+     * pixel buffer, so keep it alive until they have finished
+     */
+    if(m_lockCounter > 0) {
+        m_oldSharedData.push(ref);
+    }
+    else {
+        KisTileData::releaseSharedData(ref);
+    }
+}
+
+KisTileData* KisTile::refSwappedOutTileData() const
+{
+    QMutexLocker locker(&m_swapBarrierLock);
+
+    KisTileData *td = m_tileData;
+    if (td->data()) return 0;
+
+    td->ref();
+    return td;
+}
+
 void KisTile::lockForRead() const
 {
     DEBUG_LOG_ACTION("lock [R]");
@@ -199,6 +234,17 @@ void KisTile::lockForWrite()
         m_COWMutex.unlock();
     }
 
+    /**
+     * The pixel buffer might have been shared with other tile
+     * datas with the same content by the pooler, so make it
+     * unique before anyone writes into it
+     */
+    if (m_tileData->isDataShared()) {
+        QMutexLocker locker(&m_COWMutex);
+        safeReleaseOldSharedData(m_tileData->detachData());
+    }
+    m_tileData->invalidateContentHash();
+
     DEBUG_LOG_ACTION("lock [W]");
 }
 
@@ -113,6 +113,15 @@ public:
         return m_tileData;
     }
 
+    /**
+     * Returns the tile data of the tile if it is currently swapped
+     * out, otherwise returns null. The returned tile data is ref'ed,
+     * the caller must deref() it after use. The tile data is fetched
+     * under the swap barrier lock, so it cannot be released by
+     * a concurrent copy-on-write. Used for prefetching only.
+     */
+    KisTileData* refSwappedOutTileData() const;
+
 private:
     void init(qint32 col, qint32 row,
               KisTileData *defaultTileData, KisMementoManager* mm);
@@ -121,10 +130,12 @@ private:
     inline void unblockSwapping() const;
 
     inline void safeReleaseOldTileData(KisTileData *td);
+    inline void safeReleaseOldSharedData(const KisTileData::SharedDataRef &ref);
 
 private:
     KisTileData *m_tileData;
     mutable QStack<KisTileData*> m_oldTileData;
+    mutable QStack<KisTileData::SharedDataRef> m_oldSharedData;
     mutable volatile int m_lockCounter;
 
     qint32 m_col;
@@ -39,9 +39,15 @@ const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store)
     : m_state(NORMAL),
       m_mementoFlag(0),
+      m_oldHistoryFlag(false),
       m_age(0),
+      m_prefetchedFlag(0),
       m_usersCount(0),
       m_refCount(0),
+      m_sharedDataCounter(0),
+      m_contentHash(0),
+      m_contentHashValid(false),
+      m_contentSerial(0),
       m_pixelSize(pixelSize),
       m_store(store)
 {
@@ -66,9 +72,15 @@ KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataSt
 KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
     : m_state(NORMAL),
       m_mementoFlag(0),
+      m_oldHistoryFlag(false),
       m_age(0),
+      m_prefetchedFlag(0),
       m_usersCount(0),
       m_refCount(0),
+      m_sharedDataCounter(0),
+      m_contentHash(0),
+      m_contentHashValid(false),
+      m_contentSerial(0),
       m_pixelSize(rhs.m_pixelSize),
       m_store(rhs.m_store)
 {
@@ -98,7 +110,7 @@ void KisTileData::fillWithPixel(const quint8 *defPixel)
 void KisTileData::releaseMemory()
 {
     if (m_data) {
-        freeData(m_data, m_pixelSize);
+        releaseData();
         m_data = 0;
     }
 
@@ -116,6 +128,83 @@ void KisTileData::allocateMemory()
     m_data = allocateData(m_pixelSize);
 }
 
+void KisTileData::releaseData()
+{
+    if (m_sharedDataCounter) {
+        SharedDataRef ref;
+        ref.data = m_data;
+        ref.counter = m_sharedDataCounter;
+        ref.pixelSize = m_pixelSize;
+        ref.store = m_store;
+
+        m_sharedDataCounter = 0;
+        releaseSharedData(ref);
+    } else {
+        freeData(m_data, m_pixelSize);
+    }
+}
+
+void KisTileData::releaseSharedData(const SharedDataRef &ref)
+{
+    if (!ref.counter) return;
+
+    if (ref.counter->deref()) {
+        ref.store->notifyDataUnshared(ref.pixelSize);
+    } else {
+        delete ref.counter;
+        freeData(ref.data, ref.pixelSize);
+    }
+}
+
+KisTileData::SharedDataRef KisTileData::detachData()
+{
+    SharedDataRef oldData;
+
+    if (!m_sharedDataCounter) return oldData;
+
+    /**
+     * Nobody can start sharing the buffer with us while we hold
+     * the swap lock, so if we are the last user of the buffer,
+     * we can just take it over.
+     */
+    if (*m_sharedDataCounter == 1) {
+        delete m_sharedDataCounter;
+        m_sharedDataCounter = 0;
+        return oldData;
+    }
+
+    quint8 *newData = allocateData(m_pixelSize);
+    memcpy(newData, m_data, m_pixelSize * WIDTH * HEIGHT);
+
+    oldData.data = m_data;
+    oldData.counter = m_sharedDataCounter;
+    oldData.pixelSize = m_pixelSize;
+    oldData.store = m_store;
+
+    m_sharedDataCounter = 0;
+    m_data = newData;
+
+    return oldData;
+}
+
+void KisTileData::shareDataWith(KisTileData *rhs)
+{
+    Q_ASSERT(m_pixelSize == rhs->m_pixelSize);
+    Q_ASSERT(m_data && rhs->m_data);
+
+    if (!rhs->m_sharedDataCounter) {
+        rhs->m_sharedDataCounter = new QAtomicInt(1);
+    }
+
+    releaseData();
+
+    rhs->m_sharedDataCounter->ref();
+    m_sharedDataCounter = rhs->m_sharedDataCounter;
+    m_data = rhs->m_data;
+
+    m_store->notifyDataShared(m_pixelSize);
+}
+
 quint8* KisTileData::allocateData(const qint32 pixelSize)
 {
     quint8 *ptr = 0;
@@ -198,6 +287,23 @@ void KisTileData::releaseInternalPools()
         }
 
         if (!failedToLock) {
+            /**
+             * Every tile data gets its own copy of the buffer after
+             * the purge, so the deduplication should be restarted.
+             * The buffers themselves are freed by the purge.
+             */
+            Q_FOREACH (KisTileData *item, dataObjects) {
+                if (item->m_sharedDataCounter) {
+                    if (item->m_sharedDataCounter->deref()) {
+                        item->m_store->notifyDataUnshared(item->m_pixelSize);
+                    } else {
+                        delete item->m_sharedDataCounter;
+                    }
+                    item->m_sharedDataCounter = 0;
+                }
+                item->m_contentHashValid = false;
+            }
+
             // purge the pools memory
             BoostPool4BPP::purge_memory();
             BoostPool8BPP::purge_memory();
@@ -95,6 +95,14 @@ inline void KisTileData::blockSwapping() {
         m_store->ensureTileDataLoaded(this);
     }
     resetAge();
+
+    /**
+     * The prefetcher has loaded the data before we needed it,
+     * so we didn't have to wait for the swap
+     */
+    if (m_prefetchedFlag.load() && m_prefetchedFlag.testAndSetRelaxed(1, 0)) {
+        m_store->notifyPrefetchHit();
+    }
 }
 
 inline void KisTileData::unblockSwapping() {
@@ -115,10 +123,21 @@ inline void KisTileData::setMementoed(bool value) {
     m_mementoFlag += value ? 1 : -1;
 }
 
+inline bool KisTileData::oldHistory() const {
+    return m_oldHistoryFlag;
+}
+inline void KisTileData::setOldHistory(bool value) {
+    m_oldHistoryFlag = value;
+}
+
 inline bool KisTileData::historical() const {
     return mementoed() && numUsers() <= 1;
 }
 
+inline void KisTileData::setPrefetched(bool value) {
+    m_prefetchedFlag = value;
+}
+
 inline int KisTileData::age() const {
     return m_age;
 }
@@ -133,5 +152,18 @@ inline qint32 KisTileData::numUsers() const {
     return m_usersCount;
 }
 
+inline bool KisTileData::isDataShared() const {
+    return m_sharedDataCounter;
+}
+
+inline void KisTileData::invalidateContentHash() {
+    m_contentHashValid = false;
+    m_contentSerial.ref();
+}
+
+inline int KisTileData::contentSerial() const {
+    return m_contentSerial;
+}
+
 #endif /* KIS_TILE_DATA_H_ */
 
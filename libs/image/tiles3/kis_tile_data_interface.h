@@ -118,6 +118,14 @@ public:
     inline bool mementoed() const;
     inline void setMementoed(bool value);
 
+    /**
+     * Show whether a tile data belongs to a revision that is older
+     * than KisImageConfig::historyRevisionsInMemory(). Such tile
+     * datas are the first candidates for swapping out.
+     */
+    inline bool oldHistory() const;
+    inline void setOldHistory(bool value);
+
     /**
      * Controlling methods for setting 'age' marks
      */
@@ -139,6 +147,12 @@ public:
      */
      inline bool historical() const;
 
+    /**
+     * Used by the prefetcher only. Marks the data as loaded
+     * from swap before any reader has asked for it.
+     */
+    inline void setPrefetched(bool value);
+
     /**
      * Used for swapping purposes only.
      * Frees the memory occupied by the tile data.
@@ -167,9 +181,75 @@ public:
      */
     static void releaseInternalPools();
 
+    /**
+     * Returns true if the pixel buffer of the tile data is shared
+     * with another tile data with the same content.
+     *
+     * \see KisTileDataStore::tryDeduplicateTileData()
+     */
+    inline bool isDataShared() const;
+
+    /**
+     * A reference to a pixel buffer shared by several tile datas
+     */
+    struct SharedDataRef {
+        SharedDataRef() : data(0), counter(0), pixelSize(0), store(0) {}
+
+        quint8 *data;
+        QAtomicInt *counter;
+        qint32 pixelSize;
+        KisTileDataStore *store;
+    };
+
+    /**
+     * Makes the pixel buffer of the tile data unique, copying its
+     * content if needed. Should be called before every write
+     * access to the data. The caller must block swapping of the
+     * tile data.
+     *
+     * The readers of the tile data might still be reading the old
+     * buffer, so the reference to it is not dropped, but returned
+     * to the caller. The caller should pass it to releaseSharedData()
+     * when all the readers have finished.
+     */
+    SharedDataRef detachData();
+
+    /**
+     * Drops a reference returned by detachData(). The buffer is
+     * freed if no other tile data uses it anymore.
+     */
+    static void releaseSharedData(const SharedDataRef &ref);
+
+    /**
+     * Marks the content hash calculated by the pooler as outdated
+     * and changes the content serial. Should be called on every
+     * write access to the data.
+     */
+    inline void invalidateContentHash();
+
+    /**
+     * A number that changes on every write access to the data. Lets
+     * the caches check whether the tile data has been changed without
+     * becoming its users, which would force copy-on-write on every
+     * write to it.
+     */
+    inline int contentSerial() const;
+
 private:
     void fillWithPixel(const quint8 *defPixel);
 
+    /**
+     * Drops own pixel buffer and starts using the buffer of \p rhs.
+     * Both tile datas must be locked for writing by the caller.
+     */
+    void shareDataWith(KisTileData *rhs);
+
+    /**
+     * Frees the pixel buffer or just drops the reference to it,
+     * if it is shared with other tile datas
+     */
+    void releaseData();
+
     static quint8* allocateData(const qint32 pixelSize);
     static void freeData(quint8 *ptr, const qint32 pixelSize);
 private:
@@ -221,6 +301,12 @@ private:
      */
     qint32 m_mementoFlag;
 
+    /**
+     * Set by KisMementoManager, when the revision of the
+     * tile data goes deep enough in history
+     */
+    bool m_oldHistoryFlag;
+
     /**
      * Counts up time after last access to the tile data.
      * 0 - recently accessed
@@ -229,6 +315,12 @@ private:
     //FIXME: make memory aligned
     int m_age;
 
+    /**
+     * Set when the data has been loaded from swap by the
+     * prefetcher, reset by the first reader of the data
+     */
+    QAtomicInt m_prefetchedFlag;
+
 
     /**
      * The primitive for controlling swapping of the tile.
@@ -248,6 +340,25 @@ private:
      */
     mutable quint8* m_data;
 
+    /**
+     * Counts the tile datas sharing the same m_data after
+     * deduplication. Null if the buffer is not shared.
+     */
+    QAtomicInt *m_sharedDataCounter;
+
+    /**
+     * The hash of the content of m_data, calculated by the pooler
+     * for searching identical tile datas. Valid only while the
+     * data has not been changed since the hash was calculated.
+     */
+    uint m_contentHash;
+    bool m_contentHashValid;
+
+    /**
+     * \see contentSerial()
+     */
+    QAtomicInt m_contentSerial;
+
     /**
      * How many tiles/mementoes use
      * this tiledata through COW?
@@ -30,6 +30,7 @@ const qint32 KisTileDataPooler::MAX_NUM_CLONES = 16;
 const qint32 KisTileDataPooler::MAX_TIMEOUT = 60000; // 01m00s
 const qint32 KisTileDataPooler::MIN_TIMEOUT = 100; // 00m00.100s
 const qint32 KisTileDataPooler::TIMEOUT_FACTOR = 2;
+const qint32 KisTileDataPooler::MAX_HASHED_TILES_PER_CYCLE = 1024;
 
 //#define DEBUG_POOLER
 
@@ -95,13 +96,16 @@ KisTileDataPooler::KisTileDataPooler(KisTileDataStore *store, qint32 memoryLimit
     m_lastRealMemoryMetric = 0;
     m_lastHistoricalMemoryMetric = 0;
 
+    KisImageConfig config;
+
     if(memoryLimit >= 0) {
         m_memoryLimit = memoryLimit;
     }
     else {
-        KisImageConfig config;
         m_memoryLimit = MiB_TO_METRIC(config.poolLimit());
     }
+
+    m_deduplicationEnabled = config.enableTileDataDeduplication();
 }
 
 KisTileDataPooler::~KisTileDataPooler()
@@ -177,7 +181,7 @@ void KisTileDataPooler::waitForWork()
 
 void KisTileDataPooler::run()
 {
-    if(!m_memoryLimit) return;
+    if(!m_memoryLimit && !m_deduplicationEnabled) return;
 
     m_shouldExitFlag = false;
 
@@ -200,15 +204,18 @@ void KisTileDataPooler::run()
 
         qint32 statRealMemory;
         qint32 statHistoricalMemory;
+        bool hasUnhashedTiles;
 
 
         getLists(iter, beggers, donors,
                  memoryOccupied,
                  statRealMemory,
-                 statHistoricalMemory);
+                 statHistoricalMemory,
+                 hasUnhashedTiles);
 
         m_lastCycleHadWork =
-            processLists(beggers, donors, memoryOccupied);
+            processLists(beggers, donors, memoryOccupied) ||
+            hasUnhashedTiles;
 
         m_lastPoolMemoryMetric = memoryOccupied;
         m_lastRealMemoryMetric = statRealMemory;
@@ -270,11 +277,20 @@ void KisTileDataPooler::getLists(Iter *iter,
                                  QList<KisTileData*> &donors,
                                  qint32 &memoryOccupied,
                                  qint32 &statRealMemory,
-                                 qint32 &statHistoricalMemory)
+                                 qint32 &statHistoricalMemory,
+                                 bool &hasUnhashedTiles)
 {
     memoryOccupied = 0;
     statRealMemory = 0;
     statHistoricalMemory = 0;
+    hasUnhashedTiles = false;
+
+    /**
+     * Hashing is quite expensive, so limit the number of the
+     * tiles processed in a single cycle, otherwise we would
+     * keep the store's list locked for too long
+     */
+    qint32 hashingBudget = m_deduplicationEnabled ? MAX_HASHED_TILES_PER_CYCLE : 0;
 
     qint32 needMemoryTotal = 0;
     qint32 canDonorMemoryTotal = 0;
@@ -300,7 +316,18 @@ void KisTileDataPooler::getLists(Iter *iter,
 
         memoryOccupied += clonesMetric(item);
 
-        // statistics gathering
+        if (m_deduplicationEnabled && !item->m_contentHashValid) {
+            if (hashingBudget > 0 &&
+                m_store->tryDeduplicateTileData(item)) {
+
+                hashingBudget--;
+            }
+
+            if (!item->m_contentHashValid) {
+                hasUnhashedTiles = true;
+            }
+        }
+
         if (item->historical()) {
             statHistoricalMemory += item->pixelSize();
         } else {
@@ -394,4 +421,5 @@ void KisTileDataPooler::testingRereadConfig()
 {
     KisImageConfig config;
     m_memoryLimit = MiB_TO_METRIC(config.poolLimit());
+    m_deduplicationEnabled = config.enableTileDataDeduplication();
 }
@@ -49,6 +49,7 @@ protected:
     static const qint32 MAX_TIMEOUT;
     static const qint32 MIN_TIMEOUT;
     static const qint32 TIMEOUT_FACTOR;
+    static const qint32 MAX_HASHED_TILES_PER_CYCLE;
 
     void waitForWork();
     qint32 numClonesNeeded(KisTileData *td) const;
@@ -68,7 +69,8 @@ protected:
                       QList<KisTileData*> &donors,
                       qint32 &memoryOccupied,
                       qint32 &statRealMemory,
-                      qint32 &statHistoricalMemory);
+                      qint32 &statHistoricalMemory,
+                      bool &hasUnhashedTiles);
 
     bool processLists(QList<KisTileData*> &beggers,
                       QList<KisTileData*> &donors,
@@ -86,6 +88,7 @@ protected:
     qint32 m_lastPoolMemoryMetric;
     qint32 m_lastRealMemoryMetric;
     qint32 m_lastHistoricalMemoryMetric;
+    bool m_deduplicationEnabled;
 };
 
 
@@ -24,6 +24,7 @@
 #include "kis_tile_data_store.h"
 #include "kis_tile_data.h"
 #include "kis_debug.h"
+#include "kis_image_config.h"
 
 #include "kis_tile_data_store_iterators.h"
 
@@ -69,16 +70,24 @@ qint64 __preclone_miss_age = 0;
 KisTileDataStore::KisTileDataStore()
     : m_pooler(this),
       m_swapper(this),
+      m_prefetcher(this),
       m_numTiles(0),
-      m_memoryMetric(0)
+      m_memoryMetric(0),
+      m_deduplicatedMemoryMetric(0),
+      m_compressedTilesCacheSize(0)
 {
+    KisImageConfig config;
+    m_historyRevisionsInMemory = config.historyRevisionsInMemory();
+
     m_clockIterator = m_tileDataList.end();
     m_pooler.start();
     m_swapper.start();
+    m_prefetcher.start();
 }
 
 KisTileDataStore::~KisTileDataStore()
 {
+    m_prefetcher.terminatePrefetcher();
     m_pooler.terminatePooler();
     m_swapper.terminateSwapper();
 
@@ -106,13 +115,29 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
     stats.historicalMemorySize = m_pooler.lastHistoricalMemoryMetric() * metricCoeff;
     stats.poolSize = m_pooler.lastPoolMemoryMetric() * metricCoeff;
 
-    stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize;
+    stats.deduplicatedSize = qint64(m_deduplicatedMemoryMetric.load()) * metricCoeff;
+
+    stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize - stats.deduplicatedSize;
 
     stats.swapSize = m_swappedStore.totalMemoryMetric() * metricCoeff;
 
+    KisTileDataPrefetcher::Statistics prefetchStats = m_prefetcher.statistics();
+    stats.prefetchHits = prefetchStats.numHits;
+    stats.prefetchMisses = prefetchStats.numMisses;
+
     return stats;
 }
 
+KisSwappedDataStore::Statistics KisTileDataStore::swapStatistics() const
+{
+    return m_swappedStore.statistics();
+}
+
+KisTileDataPrefetcher::Statistics KisTileDataStore::prefetchStatistics() const
+{
+    return m_prefetcher.statistics();
+}
+
 inline void KisTileDataStore::registerTileDataImp(KisTileData *td)
 {
     td->m_listIterator = m_tileDataList.insert(m_tileDataList.end(), td);
@@ -181,6 +206,10 @@ void KisTileDataStore::freeTileData(KisTileData *td)
     m_listLock.lock();
     td->m_swapLock.lockForWrite();
 
+    if (m_deduplicationIndex.value(td->m_contentHash) == td) {
+        m_deduplicationIndex.remove(td->m_contentHash);
+    }
+
     if(!td->data()) {
         m_swappedStore.forgetTileData(td);
     }
@@ -205,34 +234,37 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
         td->m_swapLock.unlock();
 
         /**
-         * The order of this heavy locking is very important.
-         * Change it only in case, you really know what you are doing.
+         * The swapped out tile data is not present in m_tileDataList,
+         * so neither the pooler nor the swapper can access it. That
+         * is why we can load it without holding m_listLock, which
+         * lets different threads decompress their tiles in parallel
+         * (in different shards of the swapped store).
+         *
+         * If someone has managed to load the td from swap while we
+         * were waiting for the write lock, the tile data is already
+         * loaded and we should just release the lock.
+         *
+         * The lock ordering of freeTileData() is m_listLock first and
+         * the swap lock of the tile data second, so we register the
+         * loaded tile data only after releasing its swap lock. Until
+         * then the tile data is still invisible to the pooler and the
+         * swapper, and it cannot be freed, because we are its user.
          */
-        m_listLock.lock();
+        bool swappedIn = false;
 
-        /**
-         * If someone has managed to load the td from swap, then, most
-         * probably, they have already taken the swap lock. This may
-         * lead to a deadlock, because COW mechanism breaks lock
-         * ordering rules in duplicateTileData() (it takes m_listLock
-         * while the swap lock is held). In our case it is enough just
-         * to check whether the other thread has already fetched the
-         * data. Please notice that we do not take both of the locks
-         * while checking this, because holding m_listLock is
-         * enough. Nothing can happen to the tile while we hold
-         * m_listLock.
-         */
+        td->m_swapLock.lockForWrite();
 
         if(!td->data()) {
-            td->m_swapLock.lockForWrite();
-
             m_swappedStore.swapInTileData(td);
-            registerTileDataImp(td);
-
-            td->m_swapLock.unlock();
+            m_prefetcher.notifyTileDataSwappedIn(td);
+            swappedIn = true;
         }
 
-        m_listLock.unlock();
+        td->m_swapLock.unlock();
+
+        if (swappedIn) {
+            registerTileData(td);
+        }
 
         /**
          * <-- In theory, livelock is possible here...
@@ -261,6 +293,93 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     return result;
 }
 
+bool KisTileDataStore::trySwapOutCompressedTileData(KisTileData *td, const quint8 *buffer, qint32 size)
+{
+    QMutexLocker lock(&m_listLock);
+
+    /**
+     * Never wait for the tile data while holding m_listLock, the
+     * caller will just load the tile eagerly
+     */
+    if (!td->m_swapLock.tryLockForWrite()) return false;
+
+    bool result = false;
+
+    if (td->data() &&
+        m_swappedStore.tryStoreCompressedTileData(td, buffer, size)) {
+
+        if (m_deduplicationIndex.value(td->m_contentHash) == td) {
+            m_deduplicationIndex.remove(td->m_contentHash);
+        }
+        td->m_contentHashValid = false;
+
+        unregisterTileDataImp(td);
+        result = true;
+    }
+
+    td->m_swapLock.unlock();
+
+    return result;
+}
+
+bool KisTileDataStore::tryDeduplicateTileData(KisTileData *td)
+{
+    /**
+     * This function is called with m_listLock acquired
+     */
+
+    if (td->m_contentHashValid) return false;
+    if (!td->m_swapLock.tryLockForWrite()) return false;
+
+    if (!td->data()) {
+        td->m_swapLock.unlock();
+        return false;
+    }
+
+    if (m_deduplicationIndex.value(td->m_contentHash) == td) {
+        m_deduplicationIndex.remove(td->m_contentHash);
+    }
+
+    const int dataSize = td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
+
+    td->m_contentHash = qHashBits(td->data(), dataSize);
+    td->m_contentHashValid = true;
+
+    KisTileData *candidate = m_deduplicationIndex.value(td->m_contentHash);
+    bool replaceCandidate = !candidate;
+
+    if (candidate && candidate != td) {
+        if (candidate->m_swapLock.tryLockForWrite()) {
+            const bool candidateIsActual =
+                candidate->data() &&
+                candidate->m_contentHashValid &&
+                candidate->m_contentHash == td->m_contentHash;
+
+            if (!candidateIsActual) {
+                replaceCandidate = true;
+            } else if (candidate->pixelSize() == td->pixelSize() &&
+                       candidate->data() != td->data() &&
+                       !memcmp(candidate->data(), td->data(), dataSize)) {
+
+                td->shareDataWith(candidate);
+            }
+
+            candidate->m_swapLock.unlock();
+        } else {
+            // the candidate is being accessed, retry in the next cycle
+            td->m_contentHashValid = false;
+        }
+    }
+
+    if (replaceCandidate) {
+        m_deduplicationIndex.insert(td->m_contentHash, td);
+    }
+
+    td->m_swapLock.unlock();
+
+    return true;
+}
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
     m_listLock.lock();
@@ -331,12 +450,17 @@ void KisTileDataStore::debugClear()
 
     m_tileDataList.clear();
     m_clockIterator = m_tileDataList.end();
+    m_deduplicationIndex.clear();
 
     m_numTiles = 0;
     m_memoryMetric = 0;
+    m_deduplicatedMemoryMetric = 0;
 }
 
 void KisTileDataStore::testingRereadConfig() {
+    KisImageConfig config;
+    m_historyRevisionsInMemory = config.historyRevisionsInMemory();
+
     m_pooler.testingRereadConfig();
     m_swapper.testingRereadConfig();
     kickPooler();
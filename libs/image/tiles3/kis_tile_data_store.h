@@ -21,11 +21,14 @@
 #include "kritaimage_export.h"
 
 #include <QReadWriteLock>
+#include <QHash>
+#include <QAtomicInteger>
 #include "kis_tile_data_interface.h"
 
 #include "kis_tile_data_pooler.h"
 #include "swap/kis_tile_data_swapper.h"
 #include "swap/kis_swapped_data_store.h"
+#include "swap/kis_tile_data_prefetcher.h"
 
 class KisTileDataStoreIterator;
 class KisTileDataStoreReverseIterator;
@@ -51,10 +54,25 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+
+        /**
+         * The amount of memory saved by sharing the pixel
+         * buffers of identical tile datas
+         */
+        qint64 deduplicatedSize;
+
+        qint64 prefetchHits;
+        qint64 prefetchMisses;
     };
 
     MemoryStatistics memoryStatistics();
 
+    /**
+     * Returns detailed statistics of the swap, including
+     * the number of shards and swap-in/out throughput counters
+     */
+    KisSwappedDataStore::Statistics swapStatistics() const;
+
     /**
      * Returns total number of tiles present: in memory
      * or in a swap file
@@ -70,15 +88,84 @@ public:
         return m_numTiles;
     }
 
+    /**
+     * Returns true if at least one tile data object is swapped out,
+     * that is if there is any sense in prefetching
+     */
+    inline bool hasSwappedTileData() const {
+        return m_swappedStore.numTiles() > 0;
+    }
+
+    /**
+     * Asks the prefetcher to load the swapped out tile data in the
+     * background. The tile data should be ref'ed by the caller, the
+     * store takes the ownership of the reference.
+     */
+    inline void prefetchTileData(KisTileData *td) {
+        m_prefetcher.prefetchTileData(td);
+    }
+
+    /**
+     * Called by a reader that has found the data already
+     * loaded by the prefetcher
+     */
+    inline void notifyPrefetchHit() {
+        m_prefetcher.notifyPrefetchHit();
+    }
+
+    /**
+     * Called when a tile data starts using the pixel buffer
+     * of another tile data with the same content
+     */
+    inline void notifyDataShared(qint32 pixelSize) {
+        m_deduplicatedMemoryMetric.fetchAndAddRelaxed(pixelSize);
+    }
+
+    /**
+     * Called when a tile data stops using a shared pixel buffer,
+     * which is still used by other tile datas
+     */
+    inline void notifyDataUnshared(qint32 pixelSize) {
+        m_deduplicatedMemoryMetric.fetchAndAddRelaxed(-pixelSize);
+    }
+
+    KisTileDataPrefetcher::Statistics prefetchStatistics() const;
+
     inline void checkFreeMemory() {
         m_swapper.checkFreeMemory();
     }
 
+    /**
+     * Accounts the memory occupied by the compressed streams kept by
+     * KisCompressedTilesCache. The streams cannot be swapped out, but
+     * they are counted against the tiles memory limits.
+     */
+    inline void notifyCompressedTilesCacheResized(qint64 delta) {
+        m_compressedTilesCacheSize.fetchAndAddRelaxed(delta);
+    }
+
     /**
      * \see m_memoryMetric
      */
     inline qint64 memoryMetric() const {
-        return m_memoryMetric;
+        return m_memoryMetric +
+            m_compressedTilesCacheSize.load() / (KisTileData::WIDTH * KisTileData::HEIGHT);
+    }
+
+    /**
+     * The memory used by the old history tiles present in memory, as
+     * measured by the last cycle of the pooler. It is cheap to get,
+     * but may be a bit out of date.
+     */
+    inline qint64 lastHistoricalMemoryMetric() const {
+        return m_pooler.lastHistoricalMemoryMetric();
+    }
+
+    /**
+     * \see KisImageConfig::historyRevisionsInMemory()
+     */
+    inline int historyRevisionsInMemory() const {
+        return m_historyRevisionsInMemory;
     }
 
     KisTileDataStoreIterator* beginIteration();
@@ -109,6 +196,31 @@ public:
      */
     bool trySwapTileData(KisTileData *td);
 
+    /**
+     * Swaps out the tile data replacing its content with the data
+     * from \a buffer, prepared by KisTileCompressor2::prepareLazyBuffer().
+     * The data is decompressed on the first access to the tile data.
+     * Used for lazy loading of the tiles.
+     *
+     * Returns false if there is no space left in the swap or the tile
+     * data is being accessed, then the tile data is not changed.
+     */
+    bool trySwapOutCompressedTileData(KisTileData *td, const quint8 *buffer, qint32 size);
+
+    /**
+     * Calculates the content hash of the tile data and, if there
+     * is another tile data with exactly the same content, makes
+     * them share the same pixel buffer. The sharing is broken
+     * again by KisTile::lockForWrite().
+     *
+     * It may skip the tile data in case it is being accessed at
+     * the same moment of time. This function should be called
+     * with m_listLock acquired, that is, from the pooler only.
+     *
+     * Returns true if the content hash has been recalculated.
+     */
+    bool tryDeduplicateTileData(KisTileData *td);
+
 
     /**
      * WARN: The following three method are only for usage
@@ -154,6 +266,7 @@ private:
 private:
     KisTileDataPooler m_pooler;
     KisTileDataSwapper m_swapper;
+    KisTileDataPrefetcher m_prefetcher;
 
     friend class KisTileDataStoreTest;
     friend class KisTileDataPoolerTest;
@@ -171,6 +284,28 @@ private:
      * metric = num_bytes / (KisTileData::WIDTH * KisTileData::HEIGHT)
      */
     qint64 m_memoryMetric;
+
+    /**
+     * The memory saved by sharing pixel buffers. It is updated
+     * along with the buffers themselves, so swapping out a tile
+     * data that shares its buffer doesn't reduce the total memory
+     * reported by the store.
+     */
+    QAtomicInt m_deduplicatedMemoryMetric;
+
+    /**
+     * The size of the compressed streams kept by the compressed
+     * tiles caches, in bytes
+     */
+    QAtomicInteger<qint64> m_compressedTilesCacheSize;
+
+    int m_historyRevisionsInMemory;
+
+    /**
+     * Maps content hashes onto the tile datas that can share
+     * their buffers with identical ones. Guarded by m_listLock.
+     */
+    QHash<uint, KisTileData*> m_deduplicationIndex;
 };
 
 template<typename T>
@@ -30,6 +30,12 @@
  * col()/row() methods and be able to answer setNext()/next() requests to
  * be   stored   here.    It   is   used   in   KisTiledDataManager   and
  * KisMementoManager.
+ *
+ * The table is protected by a set of striped locks. Every lock guards
+ * a subset of buckets, so the threads accessing tiles in different
+ * parts of the image do not contend with each other. The operations
+ * touching the whole table (clear(), iteration, copying) take all the
+ * stripes in ascending order.
  */
 
 template<class T>
@@ -48,7 +54,7 @@ public:
     ~KisTileHashTableTraits();
 
     bool isEmpty() {
-        return !m_numTiles;
+        return !m_numTiles.load();
     }
 
     bool tileExists(qint32 col, qint32 row);
@@ -90,7 +96,7 @@ public:
     KisTileData* defaultTileData() const;
 
     qint32 numTiles() {
-        return m_numTiles;
+        return m_numTiles.load();
     }
 
     void debugPrintInfo();
@@ -106,6 +112,11 @@ private:
 
     static inline quint32 calculateHash(qint32 col, qint32 row);
 
+    inline QReadWriteLock* stripeLock(quint32 idx) const;
+    void lockAllStripesForRead() const;
+    void lockAllStripesForWrite() const;
+    void unlockAllStripes() const;
+
     inline qint32 debugChainLen(qint32 idx);
     void debugListLengthDistibution();
     void sanityChecksumCheck();
@@ -113,13 +124,15 @@ private:
     template<class U> friend class KisTileHashTableIteratorTraits;
 
     static const qint32 TABLE_SIZE = 1024;
+    static const qint32 NUM_STRIPES = 64;
     TileTypeSP *m_hashTable;
-    qint32 m_numTiles;
+    QAtomicInt m_numTiles;
 
     KisTileData *m_defaultTileData;
     KisMementoManager *m_mementoManager;
 
-    mutable QReadWriteLock m_lock;
+    mutable QReadWriteLock m_stripeLocks[NUM_STRIPES];
+    mutable QReadWriteLock m_defaultTileDataLock;
 };
 
 #include "kis_tile_hash_table_p.h"
@@ -141,16 +154,16 @@ public:
 
     KisTileHashTableIteratorTraits(KisTileHashTableTraits<T> *ht) {
         m_hashTable = ht;
+        m_hashTable->lockAllStripesForWrite();
+
         m_index = nextNonEmptyList(0);
         if (m_index < KisTileHashTableTraits<T>::TABLE_SIZE)
             m_tile = m_hashTable->m_hashTable[m_index];
-
-        m_hashTable->m_lock.lockForWrite();
     }
 
     ~KisTileHashTableIteratorTraits<T>() {
         if (m_index != -1)
-            m_hashTable->m_lock.unlock();
+            m_hashTable->unlockAllStripes();
     }
 
     KisTileHashTableIteratorTraits<T>& operator++() {
@@ -197,7 +210,7 @@ public:
 
     void destroy() {
         m_index = -1;
-        m_hashTable->m_lock.unlock();
+        m_hashTable->unlockAllStripes();
     }
 protected:
     TileTypeSP m_tile;
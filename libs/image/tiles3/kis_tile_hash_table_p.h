@@ -26,12 +26,11 @@
 
 template<class T>
 KisTileHashTableTraits<T>::KisTileHashTableTraits(KisMementoManager *mm)
-        : m_lock(QReadWriteLock::NonRecursive)
+        : m_numTiles(0)
 {
     m_hashTable = new TileTypeSP [TABLE_SIZE];
     Q_CHECK_PTR(m_hashTable);
 
-    m_numTiles = 0;
     m_defaultTileData = 0;
     m_mementoManager = mm;
 }
@@ -39,13 +38,17 @@ KisTileHashTableTraits<T>::KisTileHashTableTraits(KisMementoManager *mm)
 template<class T>
 KisTileHashTableTraits<T>::KisTileHashTableTraits(const KisTileHashTableTraits<T> &ht,
         KisMementoManager *mm)
-        : m_lock(QReadWriteLock::NonRecursive)
+        : m_numTiles(0)
 {
-    QReadLocker locker(&ht.m_lock);
+    ht.lockAllStripesForRead();
 
     m_mementoManager = mm;
     m_defaultTileData = 0;
-    setDefaultTileDataImp(ht.m_defaultTileData);
+
+    {
+        QReadLocker locker(&ht.m_defaultTileDataLock);
+        setDefaultTileDataImp(ht.m_defaultTileData);
+    }
 
     m_hashTable = new TileTypeSP [TABLE_SIZE];
     Q_CHECK_PTR(m_hashTable);
@@ -68,7 +71,9 @@ KisTileHashTableTraits<T>::KisTileHashTableTraits(const KisTileHashTableTraits<T
 
         m_hashTable[i] = nativeTileHead;
     }
-    m_numTiles = ht.m_numTiles;
+    m_numTiles.store(ht.m_numTiles.load());
+
+    ht.unlockAllStripes();
 }
 
 template<class T>
@@ -85,6 +90,40 @@ quint32 KisTileHashTableTraits<T>::calculateHash(qint32 col, qint32 row)
     return ((row << 5) + (col & 0x1F)) & 0x3FF;
 }
 
+template<class T>
+inline QReadWriteLock* KisTileHashTableTraits<T>::stripeLock(quint32 idx) const
+{
+    /**
+     * The lower bits of the hash come from the column of the tile,
+     * so the neighbouring tiles of a row fall into different stripes
+     */
+    return &m_stripeLocks[idx & (NUM_STRIPES - 1)];
+}
+
+template<class T>
+void KisTileHashTableTraits<T>::lockAllStripesForRead() const
+{
+    for (qint32 i = 0; i < NUM_STRIPES; i++) {
+        m_stripeLocks[i].lockForRead();
+    }
+}
+
+template<class T>
+void KisTileHashTableTraits<T>::lockAllStripesForWrite() const
+{
+    for (qint32 i = 0; i < NUM_STRIPES; i++) {
+        m_stripeLocks[i].lockForWrite();
+    }
+}
+
+template<class T>
+void KisTileHashTableTraits<T>::unlockAllStripes() const
+{
+    for (qint32 i = NUM_STRIPES - 1; i >= 0; i--) {
+        m_stripeLocks[i].unlock();
+    }
+}
+
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row)
@@ -116,7 +155,7 @@ void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile)
 
     tile->setNext(firstTile);
     m_hashTable[idx] = tile;
-    m_numTiles++;
+    m_numTiles.ref();
 }
 
 template<class T>
@@ -146,7 +185,7 @@ KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row)
             tile->notifyDead();
             tile = TileTypeSP();
 
-            m_numTiles--;
+            m_numTiles.deref();
             return tile;
         }
         prevTile = tile;
@@ -179,7 +218,7 @@ inline KisTileData* KisTileHashTableTraits<T>::defaultTileDataImp() const
 template<class T>
 bool KisTileHashTableTraits<T>::tileExists(qint32 col, qint32 row)
 {
-    QReadLocker locker(&m_lock);
+    QReadLocker locker(stripeLock(calculateHash(col, row)));
     return getTile(col, row);
 }
 
@@ -187,7 +226,7 @@ template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getExistedTile(qint32 col, qint32 row)
 {
-    QReadLocker locker(&m_lock);
+    QReadLocker locker(stripeLock(calculateHash(col, row)));
     return getTile(col, row);
 }
 
@@ -196,14 +235,28 @@ typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getTileLazy(qint32 col, qint32 row,
                                        bool& newTile)
 {
+    QReadWriteLock *lock = stripeLock(calculateHash(col, row));
+    newTile = false;
+
     /**
-     * FIXME: Read access is better
+     * Most of the requests come for already existing tiles, so
+     * try to find the tile with a shared lock first
      */
-    QWriteLocker locker(&m_lock);
+    {
+        QReadLocker locker(lock);
+        TileTypeSP tile = getTile(col, row);
+        if (tile) return tile;
+    }
 
-    newTile = false;
+    QWriteLocker locker(lock);
+
+    /**
+     * Someone could have created the tile while we were
+     * waiting for the write lock, so check it once again
+     */
     TileTypeSP tile = getTile(col, row);
     if (!tile) {
+        QReadLocker defaultLocker(&m_defaultTileDataLock);
         tile = new TileType(col, row, m_defaultTileData, m_mementoManager);
         linkTile(tile);
         newTile = true;
@@ -216,11 +269,13 @@ template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
 {
-    QReadLocker locker(&m_lock);
+    QReadLocker locker(stripeLock(calculateHash(col, row)));
 
     TileTypeSP tile = getTile(col, row);
-    if (!tile)
+    if (!tile) {
+        QReadLocker defaultLocker(&m_defaultTileDataLock);
         tile = new TileType(col, row, m_defaultTileData, 0);
+    }
 
     return tile;
 }
@@ -228,14 +283,14 @@ KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
 template<class T>
 void KisTileHashTableTraits<T>::addTile(TileTypeSP tile)
 {
-    QWriteLocker locker(&m_lock);
+    QWriteLocker locker(stripeLock(calculateHash(tile->col(), tile->row())));
     linkTile(tile);
 }
 
 template<class T>
 void KisTileHashTableTraits<T>::deleteTile(qint32 col, qint32 row)
 {
-    QWriteLocker locker(&m_lock);
+    QWriteLocker locker(stripeLock(calculateHash(col, row)));
 
     TileTypeSP tile = unlinkTile(col, row);
 
@@ -254,7 +309,7 @@ void KisTileHashTableTraits<T>::deleteTile(TileTypeSP tile)
 template<class T>
 void KisTileHashTableTraits<T>::clear()
 {
-    QWriteLocker locker(&m_lock);
+    lockAllStripesForWrite();
     TileTypeSP tile = TileTypeSP();
     qint32 i;
 
@@ -273,26 +328,27 @@ void KisTileHashTableTraits<T>::clear()
             tmp->notifyDead();
             tmp = 0;
 
-            m_numTiles--;
+            m_numTiles.deref();
         }
 
         m_hashTable[i] = 0;
     }
 
-    Q_ASSERT(!m_numTiles);
+    Q_ASSERT(!m_numTiles.load());
+    unlockAllStripes();
 }
 
 template<class T>
 void KisTileHashTableTraits<T>::setDefaultTileData(KisTileData *defaultTileData)
 {
-    QWriteLocker locker(&m_lock);
+    QWriteLocker locker(&m_defaultTileDataLock);
     setDefaultTileDataImp(defaultTileData);
 }
 
 template<class T>
 KisTileData* KisTileHashTableTraits<T>::defaultTileData() const
 {
-    QWriteLocker locker(&m_lock);
+    QReadLocker locker(&m_defaultTileDataLock);
     return defaultTileDataImp();
 }
 
@@ -305,7 +361,7 @@ void KisTileHashTableTraits<T>::debugPrintInfo()
     dbgTiles << "==========================\n"
              << "TileHashTable:"
              << "\n   def. data:\t\t" << m_defaultTileData
-             << "\n   numTiles:\t\t" << m_numTiles;
+             << "\n   numTiles:\t\t" << m_numTiles.load();
     debugListLengthDistibution();
     dbgTiles << "==========================\n";
 }
@@ -323,7 +379,7 @@ void KisTileHashTableTraits<T>::debugMaxListLength(qint32 &min, qint32 &max)
 {
     TileTypeSP tile;
     qint32 maxLen = 0;
-    qint32 minLen = m_numTiles;
+    qint32 minLen = m_numTiles.load();
     qint32 tmp = 0;
 
     for (qint32 i = 0; i < TABLE_SIZE; i++) {
@@ -370,10 +426,12 @@ template<class T>
 void KisTileHashTableTraits<T>::sanityChecksumCheck()
 {
     /**
-     * We assume that the lock should have already been taken
-     * by the code that was going to change the table
+     * We assume that all the stripes should have already been
+     * locked by the code that was going to change the table
      */
-    Q_ASSERT(!m_lock.tryLockForWrite());
+    for (qint32 i = 0; i < NUM_STRIPES; i++) {
+        Q_ASSERT(!m_stripeLocks[i].tryLockForWrite());
+    }
 
     TileTypeSP tile = 0;
     qint32 exactNumTiles = 0;
@@ -386,10 +444,10 @@ void KisTileHashTableTraits<T>::sanityChecksumCheck()
         }
     }
 
-    if (exactNumTiles != m_numTiles) {
+    if (exactNumTiles != m_numTiles.load()) {
         dbgKrita << "Sanity check failed!";
         dbgKrita << ppVar(exactNumTiles);
-        dbgKrita << ppVar(m_numTiles);
+        dbgKrita << ppVar(m_numTiles.load());
         dbgKrita << "Wrong tiles checksum!";
         Q_ASSERT(0); // not fatalKrita for a backtrace support
     }
@@ -20,16 +20,21 @@
 
 #include <QRect>
 #include <QVector>
+#include <QThread>
+#include <QtConcurrent>
 
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
 #include "kis_tile_data_wrapper.h"
 #include "kis_tiled_data_manager_p.h"
 #include "kis_memento_manager.h"
+#include "kis_tile_data_store.h"
+#include "kis_compressed_tiles_cache.h"
 #include "swap/kis_legacy_tile_compressor.h"
 #include "swap/kis_tile_compressor_factory.h"
 
 #include "kis_paint_device_writer.h"
+#include "kis_image_config.h"
 
 #include "kis_global.h"
 
@@ -114,8 +119,69 @@ void KisTiledDataManager::setDefaultPixelImpl(const quint8 *defaultPixel)
     memcpy(m_defaultPixel, defaultPixel, pixelSize());
 }
 
+namespace {
+
+struct CompressedTilesBatch
+{
+    QVector<KisTileSP> tiles;
+    QByteArray data;
+};
+
+struct CompressTilesBatch
+{
+    CompressTilesBatch(KisTileCompressor2::Codec codec, KisCompressedTilesCache *cache)
+        : m_codec(codec),
+          m_cache(cache)
+    {
+    }
+
+    inline void operator() (CompressedTilesBatch &batch) {
+        KisTileCompressor2 compressor(m_codec);
+
+        Q_FOREACH (KisTileSP tile, batch.tiles) {
+            const int offset = batch.data.size();
+            compressor.compressTile(tile, batch.data);
+
+            if (m_cache) {
+                m_cache->addTile(tile->tileData(), tile->col(), tile->row(), m_codec,
+                                 batch.data.mid(offset));
+            }
+        }
+        batch.tiles.clear();
+    }
+
+    KisTileCompressor2::Codec m_codec;
+    KisCompressedTilesCache *m_cache;
+};
+
+QVector<CompressedTilesBatch> splitIntoBatches(const QVector<KisTileSP> &tiles,
+                                               int first, int numBatches, int tilesPerBatch)
+{
+    QVector<CompressedTilesBatch> batches;
+
+    for (int i = 0; i < numBatches && first < tiles.size(); i++) {
+        const int last = qMin(first + tilesPerBatch, tiles.size());
+
+        CompressedTilesBatch batch;
+        batch.tiles = tiles.mid(first, last - first);
+        batches << batch;
+
+        first = last;
+    }
+
+    return batches;
+}
+
+}
+
 bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
 {
+    KisTileCompressor2::Codec codec = KisTileCompressor2::LZF;
+    {
+        KisImageConfig config(true);
+        KisTileCompressor2::codecFromName(config.tilesCompressionCodec(), &codec);
+    }
+
     QReadLocker locker(&m_lock);
 
     bool retval = true;
@@ -126,23 +192,83 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
         retval = store.write(str, strlen(str));
     }
     else {
-        retval = writeTilesHeader(store, m_hashTable->numTiles());
+        retval = writeTilesHeader(store, m_hashTable->numTiles(),
+                                  codec == KisTileCompressor2::LZF ?
+                                  CURRENT_VERSION : MULTICODEC_VERSION);
     }
 
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
 
-    KisTileHashTableIterator iter(m_hashTable);
-    KisTileSP tile;
+    {
+        KisTileHashTableIterator iter(m_hashTable);
+        KisTileSP tile;
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(CURRENT_VERSION);
+        while ((tile = iter.tile())) {
+            tiles << tile;
+            ++iter;
+        }
+    }
 
-    while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
-        if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
+    /**
+     * The tiles that have not been changed since the previous save
+     * are written as they are, only the rest of them are compressed
+     */
+    KisCompressedTilesCache *tilesCache = store.compressedTilesCache();
+
+    if (tilesCache) {
+        const int maxCachedDataChunk = 1024 * 1024;
+
+        QVector<KisTileSP> changedTiles;
+        QByteArray cachedData;
+
+        Q_FOREACH (KisTileSP tile, tiles) {
+            if (!tilesCache->fetchTile(tile->tileData(), tile->col(), tile->row(),
+                                       codec, cachedData)) {
+                changedTiles << tile;
+            }
+
+            if (cachedData.size() > maxCachedDataChunk) {
+                retval = retval && store.write(cachedData);
+                cachedData.clear();
+            }
         }
-        ++iter;
+
+        retval = retval && (cachedData.isEmpty() || store.write(cachedData));
+        tiles = changedTiles;
+    }
+
+    /**
+     * The tiles are compressed by the thread pool in batches, while
+     * the store gets only the ready compressed data in the original
+     * order of the tiles. The next round of batches is compressed
+     * while the previous one is being written, so the compression
+     * and the I/O overlap, and only two rounds are kept in memory.
+     */
+    const int tilesPerBatch = 64;
+    const int batchesPerRound = 2 * QThread::idealThreadCount();
+    const int tilesPerRound = tilesPerBatch * batchesPerRound;
+
+    QVector<CompressedTilesBatch> currentRound =
+        splitIntoBatches(tiles, 0, batchesPerRound, tilesPerBatch);
+    QtConcurrent::blockingMap(currentRound, CompressTilesBatch(codec, tilesCache));
+
+    for (int first = tilesPerRound; retval && !currentRound.isEmpty(); first += tilesPerRound) {
+        QVector<CompressedTilesBatch> nextRound =
+            splitIntoBatches(tiles, first, batchesPerRound, tilesPerBatch);
+        QFuture<void> nextRoundDone =
+            QtConcurrent::map(nextRound, CompressTilesBatch(codec, tilesCache));
+
+        Q_FOREACH (const CompressedTilesBatch &batch, currentRound) {
+            retval = store.write(batch.data);
+            if (!retval) {
+                warnFile << "Failed to write tile";
+                break;
+            }
+        }
+
+        nextRoundDone.waitForFinished();
+        currentRound = nextRound;
     }
 
     return retval;
@@ -182,8 +308,14 @@ bool KisTiledDataManager::read(QIODevice *stream)
         numTiles = line.toUInt();
     }
 
+    bool lazyLoading = false;
+    {
+        KisImageConfig config(true);
+        lazyLoading = config.lazyTilesLoading();
+    }
+
     KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(tilesVersion);
+        KisTileCompressorFactory::create(tilesVersion, lazyLoading);
 
     bool readSuccess = true;
     for (quint32 i = 0; i < numTiles; i++) {
@@ -196,7 +328,7 @@ bool KisTiledDataManager::read(QIODevice *stream)
     return readSuccess;
 }
 
-bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles)
+bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles, qint32 version)
 {
     QString buffer;
 
@@ -205,7 +337,7 @@ bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32
                      "TILEHEIGHT %3\n"
                      "PIXELSIZE %4\n"
                      "DATA %5\n")
-        .arg(CURRENT_VERSION)
+        .arg(version)
         .arg(KisTileData::WIDTH)
         .arg(KisTileData::HEIGHT)
         .arg(pixelSize())
@@ -721,6 +853,37 @@ void KisTiledDataManager::writeBytes(const quint8 *data,
     writeBytesBody(data, x, y, width, height, dataRowStride);
 }
 
+void KisTiledDataManager::prefetchTileData(const QRect &rect) const
+{
+    if (rect.isEmpty()) return;
+
+    prefetchTiles(xToCol(rect.left()), yToRow(rect.top()),
+                  xToCol(rect.right()), yToRow(rect.bottom()));
+}
+
+void KisTiledDataManager::prefetchTiles(qint32 leftCol, qint32 topRow,
+                                        qint32 rightCol, qint32 bottomRow) const
+{
+    KisTileDataStore *store = KisTileDataStore::instance();
+    if (!store->hasSwappedTileData()) return;
+
+    /**
+     * Tiles are queued in the same order the iterators walk
+     * through them, so the prefetcher stays ahead of the reader
+     */
+    for (qint32 row = topRow; row <= bottomRow; ++row) {
+        for (qint32 col = leftCol; col <= rightCol; ++col) {
+            KisTileSP tile = m_hashTable->getExistedTile(col, row);
+            if (!tile) continue;
+
+            KisTileData *td = tile->refSwappedOutTileData();
+            if (td) {
+                store->prefetchTileData(td);
+            }
+        }
+    }
+}
+
 void KisTiledDataManager::readBytes(quint8 *data,
                                     qint32 x, qint32 y,
                                     qint32 width, qint32 height,
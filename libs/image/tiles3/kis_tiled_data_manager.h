@@ -64,6 +64,14 @@ private:
     static const qint32 LEGACY_VERSION = 1;
     static const qint32 CURRENT_VERSION = 2;
 
+    /**
+     * The layout of the version 3 is the same as in version 2, but
+     * the tiles may be compressed by codecs other than LZF. It is
+     * written only when such codec is selected in the settings, so
+     * the files stay readable by older versions of Krita by default.
+     */
+    static const qint32 MULTICODEC_VERSION = 3;
+
 protected:
     /*FIXME:*/
 public:
@@ -166,8 +174,24 @@ public:
         m_mementoManager->purgeHistory(oldestMemento);
     }
 
+    /**
+     * Returns the size of the undo history of the data manager
+     * in bytes, see KisMementoManager::calculateHistorySize()
+     */
+    void calculateHistorySize(qint64 &memorySize, qint64 &swappedSize) {
+        QReadLocker locker(&m_lock);
+        m_mementoManager->calculateHistorySize(memorySize, swappedSize);
+    }
+
     static void releaseInternalPools();
 
+    /**
+     * Asks the tile data store to load all the swapped out tiles
+     * intersecting \p rect in the background. Does nothing if
+     * nothing has been swapped out.
+     */
+    void prefetchTileData(const QRect &rect) const;
+
 protected:
     /**
      * Reads and writes the tiles 
@@ -321,12 +345,20 @@ private:
     qint32 xToCol(qint32 x) const;
     qint32 yToRow(qint32 y) const;
 
+    /**
+     * The same as prefetchTileData(), but works in tile coordinates.
+     * Used by the iterators to fetch the rows they are going to
+     * walk through.
+     */
+    void prefetchTiles(qint32 leftCol, qint32 topRow,
+                       qint32 rightCol, qint32 bottomRow) const;
+
 private:
     void setDefaultPixelImpl(const quint8 *defPixel);
 
     QRect extentImpl() const;
 
-    bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles);
+    bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles, qint32 version);
     bool processTilesHeader(QIODevice *stream, quint32 &numTiles);
 
     qint32 divideRoundDown(qint32 x, const qint32 y) const;
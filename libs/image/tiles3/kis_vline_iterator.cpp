@@ -62,6 +62,9 @@ KisVLineIterator2::KisVLineIterator2(KisDataManager *dataManager, qint32 x, qint
 
     m_tileSize = m_lineStride * KisTileData::HEIGHT;
 
+    // ask the store to swap in the columns we are going to walk through
+    prefetchTiles(m_column, m_topRow, m_column + PREFETCH_LINES_AHEAD, m_bottomRow);
+
     // let's prealocate first row
     for (int i = 0; i < m_tilesCacheSize; i++){
         fetchTileDataForCache(m_tilesCache[i], m_column, m_topRow + i);
@@ -123,6 +126,8 @@ void KisVLineIterator2::nextColumn()
     } else {
         ++m_column;
         m_xInTile = 0;
+        prefetchTiles(m_column + PREFETCH_LINES_AHEAD, m_topRow,
+                      m_column + PREFETCH_LINES_AHEAD, m_bottomRow);
         preallocateTiles();
     }
     m_index = 0;
@@ -30,18 +30,52 @@
 #define WRAP_PREVIOUS_CHUNK_DATA(iter) (KisChunk((iter)-1))
 
 
-KisChunkAllocator::KisChunkAllocator(quint64 slabSize, quint64 storeSize)
+KisChunkAllocator::KisChunkAllocator(quint64 slabSize, quint64 storeSize,
+                                     QAtomicInteger<quint64> *sharedStoreSize)
 {
     m_storeMaxSize = storeSize;
     m_storeSlabSize = slabSize;
+    m_sharedStoreSize = sharedStoreSize;
 
     m_iterator = m_list.begin();
     m_storeSize = m_storeSlabSize;
+
+    /**
+     * The first slab is always given to the allocator,
+     * even if it exceeds the shared limit
+     */
+    if (m_sharedStoreSize) {
+        m_sharedStoreSize->fetchAndAddOrdered(m_storeSize);
+    }
+
     INIT_FAIL_COUNTER();
 }
 
 KisChunkAllocator::~KisChunkAllocator()
 {
+    if (m_sharedStoreSize) {
+        m_sharedStoreSize->fetchAndSubOrdered(m_storeSize);
+    }
+}
+
+bool KisChunkAllocator::tryGrowStore()
+{
+    if (!m_sharedStoreSize) {
+        if (m_storeSize + m_storeSlabSize > m_storeMaxSize) {
+            return false;
+        }
+    } else {
+        const quint64 sharedSize =
+            m_sharedStoreSize->fetchAndAddOrdered(m_storeSlabSize) + m_storeSlabSize;
+
+        if (sharedSize > m_storeMaxSize) {
+            m_sharedStoreSize->fetchAndSubOrdered(m_storeSlabSize);
+            return false;
+        }
+    }
+
+    m_storeSize += m_storeSlabSize;
+    return true;
 }
 
 KisChunk KisChunkAllocator::getChunk(quint64 size)
@@ -77,7 +111,7 @@ KisChunk KisChunkAllocator::getChunk(quint64 size)
     REGISTER_FAIL();
     m_iterator = m_list.end();
 
-    while ((m_storeSize += m_storeSlabSize) <= m_storeMaxSize) {
+    while (tryGrowStore()) {
         if(tryInsertChunk(m_list, m_iterator, size))
             return WRAP_PREVIOUS_CHUNK_DATA(m_iterator);
     }
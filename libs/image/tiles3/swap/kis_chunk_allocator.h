@@ -20,6 +20,7 @@
 #define __KIS_CHUNK_LIST_H
 
 #include <QLinkedList>
+#include <QAtomicInteger>
 
 #define MiB (1ULL << 20)
 
@@ -127,8 +128,14 @@ private:
 class KisChunkAllocator
 {
 public:
+    /**
+     * If \p sharedStoreSize is not null, the allocator shares the
+     * \p storeSize limit with all the other allocators using the
+     * same counter. The counter keeps the total size of their stores.
+     */
     KisChunkAllocator(quint64 slabSize = DEFAULT_SLAB_SIZE,
-                      quint64 storeSize = DEFAULT_STORE_SIZE);
+                      quint64 storeSize = DEFAULT_STORE_SIZE,
+                      QAtomicInteger<quint64> *sharedStoreSize = 0);
     ~KisChunkAllocator();
 
     inline quint64 numChunks() const {
@@ -147,9 +154,12 @@ private:
                         KisChunkDataListIterator &iterator,
                         quint64 size);
 
+    bool tryGrowStore();
+
 private:
     quint64 m_storeMaxSize;
     quint64 m_storeSlabSize;
+    QAtomicInteger<quint64> *m_sharedStoreSize;
 
 
     KisChunkDataList m_list;
@@ -0,0 +1,256 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_lz4_compression.h"
+
+#include <string.h>
+
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MF_LIMIT 12
+#define MAX_DISTANCE 65535
+#define RUN_MASK 15
+#define SKIP_TRIGGER 6
+
+namespace {
+
+inline quint32 read32(const quint8 *p)
+{
+    quint32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline quint64 read64(const quint8 *p)
+{
+    quint64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline quint32 hashSequence(quint32 sequence, int hashLog)
+{
+    return (sequence * 2654435761U) >> (32 - hashLog);
+}
+
+inline quint8* writeLength(quint8 *op, qint32 length)
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = quint8(length);
+    return op;
+}
+
+inline bool readLength(const quint8 *&ip, const quint8 *iend, qint32 &length)
+{
+    quint8 s;
+    do {
+        if (ip >= iend) return false;
+        s = *ip++;
+        length += s;
+    } while (s == 255);
+
+    return true;
+}
+
+inline quint8* writeLiterals(quint8 *op, const quint8 *anchor, qint32 literalLength, quint8 matchToken)
+{
+    quint8 *token = op++;
+
+    if (literalLength >= RUN_MASK) {
+        *token = (RUN_MASK << 4) | matchToken;
+        op = writeLength(op, literalLength - RUN_MASK);
+    } else {
+        *token = (literalLength << 4) | matchToken;
+    }
+
+    memcpy(op, anchor, literalLength);
+    return op + literalLength;
+}
+
+}
+
+
+KisLz4Compression::KisLz4Compression()
+{
+}
+
+KisLz4Compression::~KisLz4Compression()
+{
+}
+
+qint32 KisLz4Compression::compress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength)
+{
+    Q_UNUSED(outputLength);
+
+    const quint8 *ip = input;
+    const quint8 *anchor = input;
+    const quint8 *const iend = input + inputLength;
+    const quint8 *const mflimit = iend - MF_LIMIT;
+    const quint8 *const matchlimit = iend - LAST_LITERALS;
+
+    quint8 *op = output;
+
+    if (inputLength >= MF_LIMIT + 1) {
+        memset(m_hashTable, 0, sizeof(m_hashTable));
+
+        ip++;
+
+        while (ip < mflimit) {
+            /**
+             * Find a match. The step grows when we cannot find
+             * anything for a long time, so incompressible data
+             * is skipped quickly.
+             */
+            const quint8 *ref = 0;
+            quint32 searchCount = 1 << SKIP_TRIGGER;
+
+            forever {
+                const quint32 sequence = read32(ip);
+                const quint32 h = hashSequence(sequence, HASH_LOG);
+
+                ref = input + m_hashTable[h];
+                m_hashTable[h] = ip - input;
+
+                if (ip - ref <= MAX_DISTANCE && ref < ip && read32(ref) == sequence) {
+                    break;
+                }
+
+                ip += searchCount++ >> SKIP_TRIGGER;
+                if (ip >= mflimit) goto lastLiterals;
+            }
+
+            // catch up
+            while (ip > anchor && ref > input && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            const quint16 offset = ip - ref;
+
+            // count the match length
+            const quint8 *matchStart = ip;
+            ip += MIN_MATCH;
+            ref += MIN_MATCH;
+
+            while (ip < matchlimit - 7) {
+                const quint64 diff = read64(ip) ^ read64(ref);
+                if (diff) break;
+                ip += 8;
+                ref += 8;
+            }
+
+            while (ip < matchlimit && *ip == *ref) {
+                ip++;
+                ref++;
+            }
+
+            const qint32 matchLength = ip - matchStart - MIN_MATCH;
+
+            op = writeLiterals(op, anchor, matchStart - anchor,
+                               matchLength >= RUN_MASK ? RUN_MASK : matchLength);
+
+            *op++ = offset & 0xff;
+            *op++ = offset >> 8;
+
+            if (matchLength >= RUN_MASK) {
+                op = writeLength(op, matchLength - RUN_MASK);
+            }
+
+            anchor = ip;
+
+            if (ip < mflimit) {
+                m_hashTable[hashSequence(read32(ip - 2), HASH_LOG)] = ip - 2 - input;
+            }
+        }
+    }
+
+lastLiterals:
+    op = writeLiterals(op, anchor, iend - anchor, 0);
+
+    return op - output;
+}
+
+qint32 KisLz4Compression::decompress(const quint8* input, qint32 inputLength, quint8* output, qint32 outputLength)
+{
+    const quint8 *ip = input;
+    const quint8 *const iend = input + inputLength;
+
+    quint8 *op = output;
+    quint8 *const oend = output + outputLength;
+
+    while (ip < iend) {
+        const quint8 token = *ip++;
+
+        qint32 literalLength = token >> 4;
+        if (literalLength == RUN_MASK && !readLength(ip, iend, literalLength)) {
+            return 0;
+        }
+
+        if (literalLength > iend - ip || literalLength > oend - op) {
+            return 0;
+        }
+
+        memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        // the last sequence has no match part
+        if (ip >= iend) break;
+
+        if (iend - ip < 2) return 0;
+        const qint32 offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if (!offset || offset > op - output) {
+            return 0;
+        }
+
+        qint32 matchLength = token & RUN_MASK;
+        if (matchLength == RUN_MASK && !readLength(ip, iend, matchLength)) {
+            return 0;
+        }
+        matchLength += MIN_MATCH;
+
+        if (matchLength > oend - op) {
+            return 0;
+        }
+
+        const quint8 *ref = op - offset;
+
+        if (offset >= matchLength) {
+            memcpy(op, ref, matchLength);
+            op += matchLength;
+        } else {
+            // overlapping copy, e.g. a run of a repeated pixel
+            for (qint32 i = 0; i < matchLength; i++) {
+                *op++ = *ref++;
+            }
+        }
+    }
+
+    return op - output;
+}
+
+qint32 KisLz4Compression::outputBufferSize(qint32 dataSize)
+{
+    return dataSize + dataSize / 255 + 16;
+}
@@ -16,35 +16,105 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
-//#include "kis_debug.h"
 #include "kis_swapped_data_store.h"
 #include "kis_memory_window.h"
 #include "kis_image_config.h"
 
+#include <QByteArray>
+
+#include <kis_debug.h>
+
 #include "kis_tile_compressor_2.h"
 
 //#define COMPRESSOR_VERSION 2
 
-KisSwappedDataStore::KisSwappedDataStore()
-    : m_memoryMetric(0)
+
+struct KisSwappedDataStore::Shard
+{
+    Shard(const QString &swapDir, quint64 slabSize, quint64 maxSize, quint64 windowSize,
+          KisTileCompressor2::Codec codec, QAtomicInteger<quint64> *sharedSwapSize)
+        : compressor(codec),
+          allocator(slabSize, maxSize, sharedSwapSize),
+          swapSpace(swapDir, windowSize),
+          memoryMetric(0),
+          compressedSize(0),
+          numSwapOuts(0),
+          numSwapIns(0),
+          bytesSwappedOut(0),
+          bytesSwappedIn(0)
+    {
+    }
+
+    QByteArray buffer;
+    KisTileCompressor2 compressor;
+
+    KisChunkAllocator allocator;
+    KisMemoryWindow swapSpace;
+
+    QMutex lock;
+
+    qint64 memoryMetric;
+    qint64 compressedSize;
+
+    qint64 numSwapOuts;
+    qint64 numSwapIns;
+    qint64 bytesSwappedOut;
+    qint64 bytesSwappedIn;
+};
+
+
+KisSwappedDataStore::KisSwappedDataStore(int numShards)
+    : m_swapSize(0),
+      m_compressedSize(0)
 {
     KisImageConfig config;
+
+    if (numShards <= 0) {
+        numShards = config.swapShardsCount();
+    }
+    numShards = qMax(1, numShards);
+
     const quint64 maxSwapSize = config.maxSwapSize() * MiB;
     const quint64 swapSlabSize = config.swapSlabSize() * MiB;
     const quint64 swapWindowSize = config.swapWindowSize() * MiB;
 
-    m_allocator = new KisChunkAllocator(swapSlabSize, maxSwapSize);
-    m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
+    KisTileCompressor2::Codec codec = KisTileCompressor2::LZ4;
+    KisTileCompressor2::codecFromName(config.swapCompressionCodec(), &codec);
 
-    // FIXME: use a factory after the patch is committed
-    m_compressor = new KisTileCompressor2();
+    /**
+     * The swap limit is shared between the shards: the allocators
+     * take the slabs from the common budget, so a shard is not
+     * limited by its part of the swap if the others don't use it.
+     * Every shard is still given at least one slab.
+     */
+    m_maxSwapSize = qMax(maxSwapSize, numShards * swapSlabSize);
+
+    m_shards.reserve(numShards);
+    for (int i = 0; i < numShards; i++) {
+        m_shards.append(new Shard(config.swapDir(), swapSlabSize,
+                                  m_maxSwapSize, swapWindowSize, codec,
+                                  &m_swapSize));
+    }
 }
 
 KisSwappedDataStore::~KisSwappedDataStore()
 {
-    delete m_compressor;
-    delete m_swapSpace;
-    delete m_allocator;
+    qDeleteAll(m_shards);
+}
+
+inline KisSwappedDataStore::Shard* KisSwappedDataStore::shardForTileData(KisTileData *td) const
+{
+    /**
+     * Tile data objects are allocated by a memory pool, so the
+     * lowest bits of the address are always the same. Mix the
+     * higher bits in to get more or less even distribution.
+     */
+    quintptr key = reinterpret_cast<quintptr>(td);
+    key ^= key >> 17;
+    key *= 0x9E3779B1U;
+    key ^= key >> 15;
+
+    return m_shards[key % m_shards.size()];
 }
 
 quint64 KisSwappedDataStore::numTiles() const
@@ -52,13 +122,25 @@ quint64 KisSwappedDataStore::numTiles() const
     // We are not acquiring the lock here...
     // Hope QLinkedList will ensure atomic access to it's size...
 
-    return m_allocator->numChunks();
+    quint64 result = 0;
+
+    Q_FOREACH (Shard *shard, m_shards) {
+        result += shard->allocator.numChunks();
+    }
+
+    return result;
+}
+
+int KisSwappedDataStore::numShards() const
+{
+    return m_shards.size();
 }
 
 void KisSwappedDataStore::swapOutTileData(KisTileData *td)
 {
     Q_ASSERT(td->data());
-    QMutexLocker locker(&m_lock);
+    Shard *shard = shardForTileData(td);
+    QMutexLocker locker(&shard->lock);
 
     /**
      * We are expecting that the lock of KisTileData
@@ -66,27 +148,32 @@ void KisSwappedDataStore::swapOutTileData(KisTileData *td)
      * So we can modify the tile data freely.
      */
 
-    const qint32 expectedBufferSize = m_compressor->tileDataBufferSize(td);
-    if(m_buffer.size() < expectedBufferSize)
-        m_buffer.resize(expectedBufferSize);
+    const qint32 expectedBufferSize = shard->compressor.tileDataBufferSize(td);
+    if(shard->buffer.size() < expectedBufferSize)
+        shard->buffer.resize(expectedBufferSize);
 
     qint32 bytesWritten;
-    m_compressor->compressTileData(td, (quint8*) m_buffer.data(), m_buffer.size(), bytesWritten);
+    shard->compressor.compressTileData(td, (quint8*) shard->buffer.data(), shard->buffer.size(), bytesWritten);
 
-    KisChunk chunk = m_allocator->getChunk(bytesWritten);
-    quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
-    memcpy(ptr, m_buffer.data(), bytesWritten);
+    KisChunk chunk = shard->allocator.getChunk(bytesWritten);
+    quint8 *ptr = shard->swapSpace.getWriteChunkPtr(chunk);
+    memcpy(ptr, shard->buffer.data(), bytesWritten);
 
     td->releaseMemory();
     td->setSwapChunk(chunk);
 
-    m_memoryMetric += td->pixelSize();
+    shard->memoryMetric += td->pixelSize();
+    shard->compressedSize += bytesWritten;
+    m_compressedSize.fetchAndAddRelaxed(bytesWritten);
+    shard->numSwapOuts++;
+    shard->bytesSwappedOut += td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
 }
 
 void KisSwappedDataStore::swapInTileData(KisTileData *td)
 {
     Q_ASSERT(!td->data());
-    QMutexLocker locker(&m_lock);
+    Shard *shard = shardForTileData(td);
+    QMutexLocker locker(&shard->lock);
 
     // see comment in swapOutTileData()
 
@@ -95,30 +182,104 @@ void KisSwappedDataStore::swapInTileData(KisTileData *td)
     td->allocateMemory();
     td->setSwapChunk(KisChunk());
 
-    quint8 *ptr = m_swapSpace->getReadChunkPtr(chunk);
-    m_compressor->decompressTileData(ptr, chunk.size(), td);
-    m_allocator->freeChunk(chunk);
+    quint8 *ptr = shard->swapSpace.getReadChunkPtr(chunk);
+    if (!shard->compressor.decompressTileData(ptr, chunk.size(), td)) {
+        /**
+         * Only the data loaded lazily from a file can be corrupted.
+         * The compressor has filled the tile with the default pixel.
+         */
+        warnTiles << "Failed to decompress a tile data loaded from the file."
+                  << "The tile is filled with the default pixel.";
+    }
+
+    shard->compressedSize -= chunk.size();
+    m_compressedSize.fetchAndSubRelaxed(chunk.size());
+    shard->allocator.freeChunk(chunk);
 
-    m_memoryMetric -= td->pixelSize();
+    shard->memoryMetric -= td->pixelSize();
+    shard->numSwapIns++;
+    shard->bytesSwappedIn += td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
+}
+
+bool KisSwappedDataStore::tryStoreCompressedTileData(KisTileData *td, const quint8 *buffer, qint32 size)
+{
+    Q_ASSERT(td->data());
+    Shard *shard = shardForTileData(td);
+    QMutexLocker locker(&shard->lock);
+
+    /**
+     * Running out of the swap space is fatal, so leave a half of
+     * it for the fragmentation and for the regular swapping
+     */
+    if (quint64(m_compressedSize.load() + size) > m_maxSwapSize / 2) {
+        return false;
+    }
+
+    KisChunk chunk = shard->allocator.getChunk(size);
+    quint8 *ptr = shard->swapSpace.getWriteChunkPtr(chunk);
+    memcpy(ptr, buffer, size);
+
+    td->releaseMemory();
+    td->setSwapChunk(chunk);
+
+    shard->memoryMetric += td->pixelSize();
+    shard->compressedSize += size;
+    m_compressedSize.fetchAndAddRelaxed(size);
+
+    return true;
 }
 
 void KisSwappedDataStore::forgetTileData(KisTileData *td)
 {
-    QMutexLocker locker(&m_lock);
+    Shard *shard = shardForTileData(td);
+    QMutexLocker locker(&shard->lock);
 
-    m_allocator->freeChunk(td->swapChunk());
+    KisChunk chunk = td->swapChunk();
+    shard->compressedSize -= chunk.size();
+    m_compressedSize.fetchAndSubRelaxed(chunk.size());
+    shard->allocator.freeChunk(chunk);
     td->setSwapChunk(KisChunk());
 
-    m_memoryMetric -= td->pixelSize();
+    shard->memoryMetric -= td->pixelSize();
 }
 
 qint64 KisSwappedDataStore::totalMemoryMetric() const
 {
-    return m_memoryMetric;
+    qint64 result = 0;
+
+    Q_FOREACH (Shard *shard, m_shards) {
+        result += shard->memoryMetric;
+    }
+
+    return result;
+}
+
+KisSwappedDataStore::Statistics KisSwappedDataStore::statistics() const
+{
+    Statistics stats;
+    stats.numShards = m_shards.size();
+
+    Q_FOREACH (Shard *shard, m_shards) {
+        QMutexLocker locker(&shard->lock);
+
+        stats.numTiles += shard->allocator.numChunks();
+        stats.memoryMetric += shard->memoryMetric;
+        stats.compressedSize += shard->compressedSize;
+        stats.numSwapOuts += shard->numSwapOuts;
+        stats.numSwapIns += shard->numSwapIns;
+        stats.bytesSwappedOut += shard->bytesSwappedOut;
+        stats.bytesSwappedIn += shard->bytesSwappedIn;
+    }
+
+    return stats;
 }
 
 void KisSwappedDataStore::debugStatistics()
 {
-    m_allocator->sanityCheck();
-    m_allocator->debugFragmentation();
+    Q_FOREACH (Shard *shard, m_shards) {
+        QMutexLocker locker(&shard->lock);
+
+        shard->allocator.sanityCheck();
+        shard->allocator.debugFragmentation();
+    }
 }
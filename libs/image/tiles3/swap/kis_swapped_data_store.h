@@ -22,19 +22,74 @@
 #include "kritaimage_export.h"
 
 #include <QMutex>
-#include <QByteArray>
+#include <QVector>
+#include <QAtomicInteger>
 
 
-class QMutex;
 class KisTileData;
-class KisAbstractTileCompressor;
-class KisChunkAllocator;
-class KisMemoryWindow;
 
+/**
+ * The store is split into a set of independent shards. Each shard
+ * owns its own swap file, chunk allocator, tile compressor and
+ * compression buffer, guarded by its own lock. The shard for a tile
+ * data object is selected by hashing the object's address, so the
+ * same tile data always goes to the same shard and swap-in/out
+ * requests for different tiles can be compressed concurrently.
+ *
+ * The swap size limit is shared by all the shards, so a shard that
+ * gets more tiles than the others can take the space they don't use.
+ */
 class KRITAIMAGE_EXPORT KisSwappedDataStore
 {
 public:
-    KisSwappedDataStore();
+    struct Statistics {
+        Statistics()
+            : numShards(0),
+              numTiles(0),
+              memoryMetric(0),
+              compressedSize(0),
+              numSwapOuts(0),
+              numSwapIns(0),
+              bytesSwappedOut(0),
+              bytesSwappedIn(0)
+        {
+        }
+
+        int numShards;
+
+        /**
+         * Number of currently swapped out tile data objects
+         */
+        quint64 numTiles;
+
+        /**
+         * The same as totalMemoryMetric()
+         */
+        qint64 memoryMetric;
+
+        /**
+         * Number of bytes the swapped out tiles occupy in the
+         * swap files
+         */
+        qint64 compressedSize;
+
+        /**
+         * Cumulative counters since the creation of the store.
+         * Byte counters are measured in *uncompressed* form.
+         */
+        qint64 numSwapOuts;
+        qint64 numSwapIns;
+        qint64 bytesSwappedOut;
+        qint64 bytesSwappedIn;
+    };
+
+public:
+    /**
+     * \p numShards defines the number of independent shards of the
+     * store. Zero means that the value should be read from
+     * KisImageConfig::swapShardsCount()
+     */
+    KisSwappedDataStore(int numShards = 0);
     ~KisSwappedDataStore();
 
     /**
@@ -42,6 +97,11 @@ public:
      */
     quint64 numTiles() const;
 
+    /**
+     * Returns the number of shards the store is split into
+     */
+    int numShards() const;
+
     /**
      * Swap out the data stored in the \a td to the swap file
      * and free memory occupied by td->data().
@@ -58,6 +118,16 @@ public:
      */
     void swapInTileData(KisTileData *td);
 
+    /**
+     * Puts the data of \a td into the swap file directly from the
+     * \a buffer prepared by KisTileCompressor2::prepareLazyBuffer(),
+     * and frees memory occupied by td->data(). Returns false
+     * if there is not enough space left in the swap.
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    bool tryStoreCompressedTileData(KisTileData *td, const quint8 *buffer, qint32 size);
+
     /**
      * Forget all the information linked with the tile data.
      * This should be done before deleting of the tile data,
@@ -71,21 +141,28 @@ public:
      */
     qint64 totalMemoryMetric() const;
 
+    /**
+     * Collects statistics from all the shards of the store.
+     * Every shard is locked for a short period of time while
+     * reading, so the result is not an atomic snapshot.
+     */
+    Statistics statistics() const;
+
     /**
      * Some debugging output
      */
     void debugStatistics();
 
 private:
-    QByteArray m_buffer;
-    KisAbstractTileCompressor *m_compressor;
+    struct Shard;
+    inline Shard* shardForTileData(KisTileData *td) const;
 
-    KisChunkAllocator *m_allocator;
-    KisMemoryWindow *m_swapSpace;
-
-    QMutex m_lock;
+private:
+    QVector<Shard*> m_shards;
 
-    qint64 m_memoryMetric;
+    quint64 m_maxSwapSize;
+    QAtomicInteger<quint64> m_swapSize;
+    QAtomicInteger<qint64> m_compressedSize;
 };
 
 #endif /* __KIS_SWAPPED_DATA_STORE_H */
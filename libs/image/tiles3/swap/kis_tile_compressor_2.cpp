@@ -18,24 +18,128 @@
 
 #include "kis_tile_compressor_2.h"
 #include "kis_lzf_compression.h"
+#include "kis_lz4_compression.h"
+#include "kis_zlib_compression.h"
 #include <QIODevice>
 #include "kis_paint_device_writer.h"
+#include "../kis_tile_data_store.h"
 #define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
-const QString KisTileCompressor2::m_compressionName = "LZF";
+/**
+ * The data is stored in raw form if compression saves less
+ * than 1/MIN_COMPRESSION_GAIN_FACTOR of the tile size. It is
+ * cheaper to copy a bit bigger chunk than to decompress it.
+ */
+#define MIN_COMPRESSION_GAIN_FACTOR 16
+#define COMPRESSION_PAYS(compressedSize, tileDataSize)                  \
+    ((compressedSize) > 0 &&                                            \
+     (compressedSize) < (tileDataSize) - (tileDataSize) / MIN_COMPRESSION_GAIN_FACTOR)
 
 
-KisTileCompressor2::KisTileCompressor2()
+KisTileCompressor2::KisTileCompressor2(Codec codec)
+    : m_codec(codec),
+      m_lazyLoading(false)
 {
-    m_compression = new KisLzfCompression();
+    for (int i = 0; i < NUM_CODECS; i++) {
+        m_compressions[i] = 0;
+    }
 }
 
 KisTileCompressor2::~KisTileCompressor2()
 {
-    delete m_compression;
+    for (int i = 0; i < NUM_CODECS; i++) {
+        delete m_compressions[i];
+    }
+}
+
+QString KisTileCompressor2::codecName(Codec codec)
+{
+    switch (codec) {
+    case LZF:
+        return "LZF";
+    case LZ4:
+        return "LZ4";
+    case ZLIB:
+        return "ZLIB";
+    case NUM_CODECS:
+        break;
+    }
+
+    return QString();
+}
+
+bool KisTileCompressor2::codecFromName(const QString &name, Codec *codec)
+{
+    for (int i = 0; i < NUM_CODECS; i++) {
+        if (name == codecName(Codec(i))) {
+            *codec = Codec(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+qint32 KisTileCompressor2::prepareLazyBuffer(quint8 *buffer, qint32 size, Codec codec,
+                                            const quint8 *defaultPixel, qint32 pixelSize)
+{
+    /**
+     * Raw data cannot be corrupted once its size is checked,
+     * so it is stored as it is
+     */
+    if (buffer[0] != COMPRESSED_DATA_FLAG) return size;
+
+    buffer[0] = EXPLICIT_CODEC_DATA_FLAG + codec;
+    memcpy(buffer + size, defaultPixel, pixelSize);
+
+    return size + pixelSize;
+}
+
+KisTileCompressor2::Codec KisTileCompressor2::codec() const
+{
+    return m_codec;
+}
+
+void KisTileCompressor2::setLazyLoading(bool value)
+{
+    m_lazyLoading = value;
+}
+
+KisAbstractCompression* KisTileCompressor2::compression(Codec codec)
+{
+    if (!m_compressions[codec]) {
+        switch (codec) {
+        case LZF:
+            m_compressions[codec] = new KisLzfCompression();
+            break;
+        case LZ4:
+            m_compressions[codec] = new KisLz4Compression();
+            break;
+        case ZLIB:
+            m_compressions[codec] = new KisZlibCompression();
+            break;
+        case NUM_CODECS:
+            qFatal("KisTileCompressor2: unknown codec");
+            break;
+        }
+    }
+
+    return m_compressions[codec];
 }
 
 bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
+{
+    QByteArray buffer;
+    compressTile(tile, buffer);
+
+    bool retval = store.write(buffer);
+    if (!retval) {
+        warnFile << "Failed to write the tile data";
+    }
+    return retval;
+}
+
+void KisTileCompressor2::compressTile(KisTileSP tile, QByteArray &buffer)
 {
     const qint32 tileDataSize = TILE_DATA_SIZE(tile->pixelSize());
     prepareStreamingBuffer(tileDataSize);
@@ -47,17 +151,8 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
                      m_streamingBuffer.size(), bytesWritten);
     tile->unlock();
 
-    QString header = getHeader(tile, bytesWritten);
-    bool retval = true;
-    retval = store.write(header.toLatin1());
-    if (!retval) {
-        warnFile << "Failed to write the tile header";
-    }
-    retval = store.write(m_streamingBuffer.data(), bytesWritten);
-    if (!retval) {
-        warnFile << "Failed to write the tile datak";
-    }
-    return retval;
+    buffer.append(getHeader(tile, bytesWritten).toLatin1());
+    buffer.append(m_streamingBuffer.constData(), bytesWritten);
 }
 
 bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
@@ -75,17 +170,76 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
         qint32 dataSize = headerItems.takeFirst().toInt();
 
         Q_ASSERT(headerItems.isEmpty());
-        Q_ASSERT(compressionName == m_compressionName);
+
+        Codec codec;
+        if (!codecFromName(compressionName, &codec)) {
+            warnFile << "Unknown tile compression:" << compressionName;
+            return false;
+        }
+
+        if (dataSize > tileDataSize + 1) {
+            warnFile << "Tile data is bigger than the uncompressed tile";
+            return false;
+        }
+
+        if (dataSize < 1) {
+            warnFile << "Tile data is empty";
+            return false;
+        }
 
         qint32 row = yToRow(dm, y);
         qint32 col = xToCol(dm, x);
 
         KisTileSP tile = dm->getTile(col, row, true);
 
-        stream->read(m_streamingBuffer.data(), dataSize);
+        // leave space for the default pixel of a lazily loaded tile
+        m_streamingBuffer.resize(tileDataSize + 1 + pixelSize(dm));
+
+        if (stream->read(m_streamingBuffer.data(), dataSize) != dataSize) {
+            warnFile << "Failed to read the tile data";
+            return false;
+        }
+
+        quint8 *buffer = (quint8*)m_streamingBuffer.data();
+
+        /**
+         * Only the data that has been validated is loaded lazily,
+         * otherwise the corrupted data would be found only when the
+         * tile is accessed. The corrupted data will be reported right
+         * away by the decompression below.
+         */
+        const bool canLoadLazily =
+            m_lazyLoading &&
+            ((buffer[0] == COMPRESSED_DATA_FLAG &&
+              isValidCompressedData(buffer + 1, dataSize - 1, tileDataSize, codec)) ||
+             (buffer[0] == RAW_DATA_FLAG && dataSize == tileDataSize + 1));
 
         tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
+
+        if (canLoadLazily) {
+            /**
+             * The tile has got its own tile data in lockForWrite(),
+             * so it can be swapped out safely after unlocking
+             */
+            tile->unlock();
+
+            const qint32 lazyBufferSize =
+                prepareLazyBuffer(buffer, dataSize, codec, dm->defaultPixel(), pixelSize(dm));
+
+            if (KisTileDataStore::instance()->trySwapOutCompressedTileData(tile->tileData(), buffer, lazyBufferSize)) {
+                return true;
+            }
+
+            // restore the flag changed by prepareLazyBuffer()
+            if (lazyBufferSize != dataSize) {
+                buffer[0] = COMPRESSED_DATA_FLAG;
+            }
+
+            // there is no space in the swap, just load the tile
+            tile->lockForWrite();
+        }
+
+        bool res = decompressTileData(buffer, dataSize, tile->tileData(), codec);
         tile->unlock();
         return res;
     }
@@ -101,12 +255,31 @@ void KisTileCompressor2::prepareStreamingBuffer(qint32 tileDataSize)
     m_streamingBuffer.resize(tileDataSize + 1);
 }
 
-void KisTileCompressor2::prepareWorkBuffers(qint32 tileDataSize)
+void KisTileCompressor2::prepareWorkBuffers(qint32 tileDataSize, Codec codec)
 {
-    const qint32 bufferSize = m_compression->outputBufferSize(tileDataSize);
+    const qint32 bufferSize = compression(codec)->outputBufferSize(tileDataSize);
 
     m_linearizationBuffer.resize(tileDataSize);
-    m_compressionBuffer.resize(bufferSize);
+
+    if (m_compressionBuffer.size() < bufferSize) {
+        m_compressionBuffer.resize(bufferSize);
+    }
+}
+
+bool KisTileCompressor2::isWorthCompressing(qint32 tileDataSize)
+{
+    KisAbstractCompression *probe = compression(LZ4);
+
+    const qint32 bufferSize = probe->outputBufferSize(tileDataSize);
+    if (m_compressionBuffer.size() < bufferSize) {
+        m_compressionBuffer.resize(bufferSize);
+    }
+
+    const qint32 probeBytes =
+        probe->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
+                        (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
+
+    return COMPRESSION_PAYS(probeBytes, tileDataSize);
 }
 
 void KisTileCompressor2::compressTileData(KisTileData *tileData,
@@ -116,20 +289,27 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
 {
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
-    qint32 compressedBytes;
+    qint32 compressedBytes = 0;
 
     Q_UNUSED(bufferSize);
     Q_ASSERT(bufferSize >= tileDataSize + 1);
 
-    prepareWorkBuffers(tileDataSize);
+    prepareWorkBuffers(tileDataSize, m_codec);
 
     KisAbstractCompression::linearizeColors(tileData->data(), (quint8*)m_linearizationBuffer.data(),
                                             tileDataSize, pixelSize);
 
-    compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
-                                              (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
+    /**
+     * Slow codecs spend a lot of time on the data that cannot be
+     * compressed anyway (e.g. noise), so check it with a fast one
+     * first. This is a per-tile decision.
+     */
+    if (m_codec != ZLIB || isWorthCompressing(tileDataSize)) {
+        compressedBytes = compression(m_codec)->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
+                                                         (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
+    }
 
-    if(compressedBytes < tileDataSize) {
+    if(COMPRESSION_PAYS(compressedBytes, tileDataSize)) {
         buffer[0] = COMPRESSED_DATA_FLAG;
         memcpy(buffer + 1, m_compressionBuffer.data(), compressedBytes);
         bytesWritten = compressedBytes + 1;
@@ -144,30 +324,88 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
 bool KisTileCompressor2::decompressTileData(quint8 *buffer,
                                             qint32 bufferSize,
                                             KisTileData *tileData)
+{
+    return decompressTileData(buffer, bufferSize, tileData, m_codec);
+}
+
+bool KisTileCompressor2::decompressTileData(quint8 *buffer,
+                                            qint32 bufferSize,
+                                            KisTileData *tileData,
+                                            Codec codec)
 {
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
 
-    if(buffer[0] == COMPRESSED_DATA_FLAG) {
-        prepareWorkBuffers(tileDataSize);
+    if (buffer[0] >= EXPLICIT_CODEC_DATA_FLAG) {
+        /**
+         * The buffer has been prepared by prepareLazyBuffer(), so
+         * the data is followed by the default pixel of the device
+         */
+        const int explicitCodec = buffer[0] - EXPLICIT_CODEC_DATA_FLAG;
+        const qint32 dataSize = bufferSize - pixelSize;
+
+        if (explicitCodec < NUM_CODECS && dataSize > 1 &&
+            decompressData(buffer + 1, dataSize - 1, tileData, Codec(explicitCodec))) {
 
-        qint32 bytesWritten;
-        bytesWritten = m_compression->decompress(buffer + 1, bufferSize - 1,
-                                                 (quint8*)m_linearizationBuffer.data(), tileDataSize);
-        if (bytesWritten == tileDataSize) {
-            KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
-                                                      tileData->data(),
-                                                      tileDataSize, pixelSize);
             return true;
         }
+
+        if (dataSize > 0) {
+            const quint8 *defaultPixel = buffer + dataSize;
+            quint8 *it = tileData->data();
+
+            for (int i = 0; i < KisTileData::WIDTH * KisTileData::HEIGHT; i++, it += pixelSize) {
+                memcpy(it, defaultPixel, pixelSize);
+            }
+        }
         return false;
     }
-    else {
+    else if (buffer[0] == COMPRESSED_DATA_FLAG) {
+        return decompressData(buffer + 1, bufferSize - 1, tileData, codec);
+    }
+    else if (bufferSize >= tileDataSize + 1) {
         memcpy(tileData->data(), buffer + 1, tileDataSize);
         return true;
     }
     return false;
+}
+
+bool KisTileCompressor2::decompressData(const quint8 *buffer,
+                                        qint32 bufferSize,
+                                        KisTileData *tileData,
+                                        Codec codec)
+{
+    const qint32 pixelSize = tileData->pixelSize();
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+
+    prepareWorkBuffers(tileDataSize, codec);
+
+    qint32 bytesWritten;
+    bytesWritten = compression(codec)->decompress(buffer, bufferSize,
+                                                  (quint8*)m_linearizationBuffer.data(), tileDataSize);
+    if (bytesWritten == tileDataSize) {
+        KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
+                                                  tileData->data(),
+                                                  tileDataSize, pixelSize);
+        return true;
+    }
+    return false;
+}
+
+bool KisTileCompressor2::isValidCompressedData(const quint8 *buffer,
+                                               qint32 bufferSize,
+                                               qint32 tileDataSize,
+                                               Codec codec)
+{
+    if (bufferSize < 1) return false;
+
+    prepareWorkBuffers(tileDataSize, codec);
+
+    const qint32 bytesWritten =
+        compression(codec)->decompress(buffer, bufferSize,
+                                       (quint8*)m_linearizationBuffer.data(), tileDataSize);
 
+    return bytesWritten == tileDataSize;
 }
 
 qint32 KisTileCompressor2::tileDataBufferSize(KisTileData *tileData)
@@ -191,5 +429,5 @@ inline QString KisTileCompressor2::getHeader(KisTileSP tile,
     qint32 width, height;
     tile->extent().getRect(&x, &y, &width, &height);
 
-    return QString("%1,%2,%3,%4\n").arg(x).arg(y).arg(m_compressionName).arg(compressedSize);
+    return QString("%1,%2,%3,%4\n").arg(x).arg(y).arg(codecName(m_codec)).arg(compressedSize);
 }
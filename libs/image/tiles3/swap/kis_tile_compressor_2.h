@@ -26,12 +26,63 @@ class KisAbstractCompression;
 class KRITAIMAGE_EXPORT KisTileCompressor2 : public KisAbstractTileCompressor
 {
 public:
-    KisTileCompressor2();
+    /**
+     * The codec used for compressing the tiles. When writing into
+     * a stream, the name of the codec is saved into the header of
+     * every tile, so the reader can decompress tiles written with
+     * any of the codecs.
+     */
+    enum Codec {
+        LZF = 0,
+        LZ4,
+        ZLIB,
+        NUM_CODECS
+    };
+
+public:
+    KisTileCompressor2(Codec codec = LZF);
     ~KisTileCompressor2() override;
 
+    static QString codecName(Codec codec);
+    static bool codecFromName(const QString &name, Codec *codec);
+
+    /**
+     * Prepares the \a buffer of \a size bytes, produced by
+     * compressTileData() of a compressor with \a codec, for putting
+     * into the swap directly. The compressed data is marked with the
+     * codec explicitly, so that it can be decompressed by a compressor
+     * with any codec, and \a defaultPixel is appended to it. The tile
+     * is filled with the default pixel if the data gets corrupted in
+     * the swap. The buffer must have space for one more pixel.
+     *
+     * \return the new size of the buffer
+     */
+    static qint32 prepareLazyBuffer(quint8 *buffer, qint32 size, Codec codec,
+                                    const quint8 *defaultPixel, qint32 pixelSize);
+
+    Codec codec() const;
+
+    /**
+     * In lazy loading mode readTile() doesn't decompress the tile
+     * data, but puts the compressed data into the swap directly. The
+     * data is decompressed on the first access to the tile, the same
+     * way as swapped out tiles are. The compressed data is validated
+     * before that, so the corrupted tiles are still reported by
+     * readTile().
+     */
+    void setLazyLoading(bool value);
+
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
     bool readTile(QIODevice *io, KisTiledDataManager *dm) override;
 
+    /**
+     * Compresses the \a tile and appends it to the \a buffer in
+     * the same format writeTile() writes it into the store. Doesn't
+     * touch any stream, so the tiles can be compressed by several
+     * compressors in parallel and written into the store later.
+     */
+    void compressTile(KisTileSP tile, QByteArray &buffer);
+
 
     void compressTileData(KisTileData *tileData,quint8 *buffer,
                           qint32 bufferSize, qint32 &bytesWritten) override;
@@ -46,19 +97,49 @@ private:
 
     QString getHeader(KisTileSP tile, qint32 compressedSize);
 
-    void prepareWorkBuffers(qint32 tileDataSize);
+    KisAbstractCompression* compression(Codec codec);
+
+    bool decompressTileData(quint8 *buffer, qint32 bufferSize,
+                            KisTileData *tileData, Codec codec);
+
+    bool decompressData(const quint8 *buffer, qint32 bufferSize,
+                        KisTileData *tileData, Codec codec);
+
+    /**
+     * Checks whether the compressed stream decompresses into a
+     * complete tile, without storing the result anywhere
+     */
+    bool isValidCompressedData(const quint8 *buffer, qint32 bufferSize,
+                               qint32 tileDataSize, Codec codec);
+
+    /**
+     * Checks whether the (linearized) tile data is worth compressing
+     * with a slow codec by compressing it with the fast one first
+     */
+    bool isWorthCompressing(qint32 tileDataSize);
+
+    void prepareWorkBuffers(qint32 tileDataSize, Codec codec);
     void prepareStreamingBuffer(qint32 tileDataSize);
 
 private:
     static const qint8 RAW_DATA_FLAG = 0;
     static const qint8 COMPRESSED_DATA_FLAG = 1;
 
+    /**
+     * The data compressed with a codec marked by prepareLazyBuffer()
+     * has flag EXPLICIT_CODEC_DATA_FLAG + codec
+     */
+    static const qint8 EXPLICIT_CODEC_DATA_FLAG = 2;
+
 private:
     QByteArray m_linearizationBuffer;
     QByteArray m_compressionBuffer;
     QByteArray m_streamingBuffer;
-    KisAbstractCompression *m_compression;
-    static const QString m_compressionName;
+
+    Codec m_codec;
+    KisAbstractCompression *m_compressions[NUM_CODECS];
+
+    bool m_lazyLoading;
 };
 
 #endif /* __KIS_TILE_COMPRESSOR_2_H */
@@ -25,14 +25,18 @@
 class KRITAIMAGE_EXPORT KisTileCompressorFactory
 {
 public:
-    static KisAbstractTileCompressorSP create(qint32 version) {
+    static KisAbstractTileCompressorSP create(qint32 version, bool lazyLoading = false) {
         switch(version) {
         case 1:
             return KisAbstractTileCompressorSP(new KisLegacyTileCompressor());
             break;
         case 2:
-            return KisAbstractTileCompressorSP(new KisTileCompressor2());
+        case 3: {
+            KisTileCompressor2 *compressor = new KisTileCompressor2();
+            compressor->setLazyLoading(lazyLoading);
+            return KisAbstractTileCompressorSP(compressor);
             break;
+        }
         default:
             qFatal("Unknown version of the tiles");
             return KisAbstractTileCompressorSP();
@@ -0,0 +1,134 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_data_prefetcher.h"
+
+#include "tiles3/kis_tile_data.h"
+#include "tiles3/kis_tile_data_store.h"
+
+/**
+ * Every queued tile data is ref'ed, so we should not let the
+ * queue grow infinitely when the prefetcher cannot keep up with
+ * the readers.
+ */
+const int KisTileDataPrefetcher::MAX_QUEUE_SIZE = 4096;
+
+
+KisTileDataPrefetcher::KisTileDataPrefetcher(KisTileDataStore *store)
+    : QThread(),
+      m_store(store)
+{
+    m_shouldExitFlag = 0;
+}
+
+KisTileDataPrefetcher::~KisTileDataPrefetcher()
+{
+}
+
+void KisTileDataPrefetcher::prefetchTileData(KisTileData *td)
+{
+    m_numRequests.ref();
+
+    {
+        QMutexLocker locker(&m_queueLock);
+
+        if (m_queue.size() < MAX_QUEUE_SIZE) {
+            m_queue.enqueue(td);
+            td = 0;
+        }
+    }
+
+    if (td) {
+        m_numDropped.ref();
+        td->deref();
+    } else {
+        m_semaphore.release();
+    }
+}
+
+void KisTileDataPrefetcher::notifyTileDataSwappedIn(KisTileData *td)
+{
+    /**
+     * The tile loaded by the prefetcher is counted as a hit only
+     * when some reader actually accesses it
+     */
+    if (QThread::currentThread() == this) {
+        td->setPrefetched(true);
+    } else {
+        td->setPrefetched(false);
+        m_numMisses.ref();
+    }
+}
+
+void KisTileDataPrefetcher::notifyPrefetchHit()
+{
+    m_numHits.ref();
+}
+
+KisTileDataPrefetcher::Statistics KisTileDataPrefetcher::statistics() const
+{
+    Statistics stats;
+    stats.numRequests = m_numRequests;
+    stats.numHits = m_numHits;
+    stats.numMisses = m_numMisses;
+    stats.numDropped = m_numDropped;
+    return stats;
+}
+
+void KisTileDataPrefetcher::terminatePrefetcher()
+{
+    m_shouldExitFlag = 1;
+    m_semaphore.release();
+    wait();
+
+    QMutexLocker locker(&m_queueLock);
+    while (!m_queue.isEmpty()) {
+        m_queue.dequeue()->deref();
+    }
+}
+
+void KisTileDataPrefetcher::run()
+{
+    forever {
+        m_semaphore.acquire();
+
+        if (m_shouldExitFlag) break;
+
+        KisTileData *td = 0;
+
+        {
+            QMutexLocker locker(&m_queueLock);
+            if (!m_queue.isEmpty()) {
+                td = m_queue.dequeue();
+            }
+        }
+
+        if (!td) continue;
+
+        /**
+         * The reader might have already fetched the tile
+         * itself, then there is nothing to do for us.
+         */
+        if (!td->data()) {
+            m_store->ensureTileDataLoaded(td);
+            td->unblockSwapping();
+        }
+
+        td->deref();
+    }
+}
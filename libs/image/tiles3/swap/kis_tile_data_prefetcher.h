@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_TILE_DATA_PREFETCHER_H
+#define __KIS_TILE_DATA_PREFETCHER_H
+
+#include <QThread>
+#include <QSemaphore>
+#include <QMutex>
+#include <QQueue>
+
+class KisTileDataStore;
+class KisTileData;
+
+
+/**
+ * A background thread that loads swapped out tile data objects
+ * before the actual reader needs them. The requests are posted by
+ * the iterators and KisTiledDataManager::readBytes() for the area
+ * they are going to walk through, so the walking thread mostly finds
+ * the tiles already resident in memory.
+ *
+ * Hits and misses are counted from the point of view of the readers:
+ * a hit is an access to a tile that has been loaded by the prefetcher
+ * before the reader needed it, a miss is a tile that the reader had
+ * to swap in synchronously itself.
+ */
+class KisTileDataPrefetcher : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct Statistics {
+        Statistics()
+            : numRequests(0),
+              numHits(0),
+              numMisses(0),
+              numDropped(0)
+        {
+        }
+
+        qint64 numRequests;
+        qint64 numHits;
+        qint64 numMisses;
+        qint64 numDropped;
+    };
+
+public:
+    KisTileDataPrefetcher(KisTileDataStore *store);
+    ~KisTileDataPrefetcher() override;
+
+    /**
+     * Queues the tile data for loading. The caller should ref()
+     * the tile data before the call, the prefetcher will deref()
+     * it when the request is processed.
+     */
+    void prefetchTileData(KisTileData *td);
+
+    /**
+     * Called by the store every time it has to swap in a tile
+     * data object. The store doesn't care who is the caller,
+     * the prefetcher checks it itself.
+     */
+    void notifyTileDataSwappedIn(KisTileData *td);
+
+    /**
+     * Called when a reader finds the tile data that has been
+     * loaded by the prefetcher
+     */
+    void notifyPrefetchHit();
+
+    Statistics statistics() const;
+
+    void terminatePrefetcher();
+
+protected:
+    void run() override;
+
+private:
+    static const int MAX_QUEUE_SIZE;
+
+    KisTileDataStore *m_store;
+
+    QSemaphore m_semaphore;
+    QAtomicInt m_shouldExitFlag;
+
+    mutable QMutex m_queueLock;
+    QQueue<KisTileData*> m_queue;
+
+    QAtomicInt m_numRequests;
+    QAtomicInt m_numHits;
+    QAtomicInt m_numMisses;
+    QAtomicInt m_numDropped;
+};
+
+#endif /* __KIS_TILE_DATA_PREFETCHER_H */
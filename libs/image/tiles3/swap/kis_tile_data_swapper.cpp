@@ -40,6 +40,7 @@ const qint32 KisTileDataSwapper::DELAY = 0.7 * SEC;
 #define DEBUG_VALUE(value)
 #endif
 
+class HistorySwapStrategy;
 class SoftSwapStrategy;
 class AggressiveSwapStrategy;
 
@@ -52,6 +53,13 @@ public:
     KisTileDataStore *store;
     KisStoreLimits limits;
     QMutex cycleLock;
+
+    /**
+     * The history metric measured by the pooler and the memory freed
+     * by the history passes since the pooler has measured it
+     */
+    qint64 lastHistoricalMetric = 0;
+    qint64 historyFreedSinceMeasurement = 0;
 };
 
 KisTileDataSwapper::KisTileDataSwapper(KisTileDataStore *store)
@@ -125,6 +133,25 @@ void KisTileDataSwapper::doJob()
     DEBUG_VALUE(m_d->limits.softLimitThreshold());
     DEBUG_VALUE(m_d->limits.hardLimitThreshold());
 
+    /**
+     * The undo history has its own budget, so the old revisions
+     * are moved out of memory before the swapper has to touch
+     * anything else
+     */
+    qint64 historicalMetric = historicalMemoryMetric();
+    DEBUG_VALUE(historicalMetric);
+    DEBUG_VALUE(m_d->limits.historyLimitThreshold());
+
+    if(historicalMetric > m_d->limits.historyLimitThreshold()) {
+        qint64 historyFree = historicalMetric - m_d->limits.historyLimit();
+        DEBUG_VALUE(historyFree);
+        DEBUG_ACTION("\t history pass");
+        const qint64 freed = pass<HistorySwapStrategy>(historyFree);
+        m_d->historyFreedSinceMeasurement += freed;
+        memoryMetric -= freed;
+        DEBUG_VALUE(memoryMetric);
+    }
+
 
     if(memoryMetric > m_d->limits.softLimitThreshold()) {
         qint32 softFree =  memoryMetric - m_d->limits.softLimit();
@@ -144,6 +171,48 @@ void KisTileDataSwapper::doJob()
 }
 
 
+qint64 KisTileDataSwapper::historicalMemoryMetric()
+{
+    /**
+     * Walking through all the tiles is too expensive for the
+     * emergency checks made by the painting threads, so we take the
+     * metric measured by the pooler and subtract what the history
+     * passes have freed since then.
+     */
+    const qint64 metric = m_d->store->lastHistoricalMemoryMetric();
+
+    if (metric != m_d->lastHistoricalMetric) {
+        m_d->lastHistoricalMetric = metric;
+        m_d->historyFreedSinceMeasurement = 0;
+    }
+
+    return qMax(qint64(0), metric - m_d->historyFreedSinceMeasurement);
+}
+
+
+class HistorySwapStrategy
+{
+public:
+    typedef KisTileDataStoreIterator iterator;
+
+    static inline iterator* beginIteration(KisTileDataStore *store) {
+        return store->beginIteration();
+    }
+
+    static inline void endIteration(KisTileDataStore *store, iterator *iter) {
+        store->endIteration(iter);
+    }
+
+    static inline bool isInteresting(KisTileData *td) {
+        return td->historical();
+    }
+
+    static inline bool swapOutFirst(KisTileData *td) {
+        // the recent revisions are the most probable to be undone
+        return td->oldHistory();
+    }
+};
+
 class SoftSwapStrategy
 {
 public:
@@ -163,7 +232,7 @@ public:
     }
 
     static inline bool swapOutFirst(KisTileData *td) {
-        return td->age() > 0;
+        return td->age() > 0 || td->oldHistory();
     }
 };
 
@@ -47,6 +47,7 @@ private:
     void run() override;
 
     void doJob();
+    qint64 historicalMemoryMetric();
     template<class strategy> qint64 pass(qint64 needToFreeMetric);
 
 private:
@@ -53,6 +53,11 @@
   |                        |
   +------------------------+  <-- 0 MiB
 
+  Independently, the memory used by the undo history only is
+  checked against historyLimitThreshold and is shrunk down to
+  historyLimit, starting with the tiles of the old revisions
+  (see KisImageConfig::historyRevisionsInMemory()).
+
  */
 
 
@@ -69,6 +74,9 @@ public:
 
         m_softLimitThreshold = qBound(0, MiB_TO_METRIC(config.tilesSoftLimit()), m_hardLimitThreshold);
         m_softLimit = m_softLimitThreshold - m_softLimitThreshold / 8;
+
+        m_historyLimitThreshold = qBound(0, MiB_TO_METRIC(config.historyLimit()), m_hardLimitThreshold);
+        m_historyLimit = m_historyLimitThreshold - m_historyLimitThreshold / 8;
     }
 
     /**
@@ -95,12 +103,22 @@ public:
         return m_softLimit;
     }
 
+    inline qint32 historyLimitThreshold() {
+        return m_historyLimitThreshold;
+    }
+
+    inline qint32 historyLimit() {
+        return m_historyLimit;
+    }
+
 private:
     qint32 m_emergencyThreshold;
     qint32 m_hardLimitThreshold;
     qint32 m_hardLimit;
     qint32 m_softLimitThreshold;
     qint32 m_softLimit;
+    qint32 m_historyLimitThreshold;
+    qint32 m_historyLimit;
 };
 
 
@@ -42,6 +42,39 @@ void KisChunkAllocatorTest::testOperations()
     QVERIFY(qFuzzyCompare(allocator.debugFragmentation(), 1./6));
 }
 
+void KisChunkAllocatorTest::testSharedStoreSize()
+{
+    const quint64 slabSize = 1024;
+    const quint64 storeSize = 4 * slabSize;
+
+    QAtomicInteger<quint64> sharedStoreSize(0);
+
+    {
+        KisChunkAllocator allocator1(slabSize, storeSize, &sharedStoreSize);
+        KisChunkAllocator allocator2(slabSize, storeSize, &sharedStoreSize);
+
+        QCOMPARE(sharedStoreSize.load(), 2 * slabSize);
+
+        /**
+         * The first allocator can take all the slabs
+         * the second one doesn't use
+         */
+        for (int i = 0; i < 3; i++) {
+            allocator1.getChunk(slabSize);
+        }
+
+        QCOMPARE(sharedStoreSize.load(), storeSize);
+        allocator1.sanityCheck();
+
+        // the second allocator still has its own slab
+        allocator2.getChunk(slabSize);
+        allocator2.sanityCheck();
+
+        QCOMPARE(sharedStoreSize.load(), storeSize);
+    }
+
+    QCOMPARE(sharedStoreSize.load(), quint64(0));
+}
 
 #define NUM_TRANSACTIONS 30
 #define NUM_CHUNKS_ALLOC 15000
@@ -31,6 +31,7 @@ qreal measureFragmentation(qint32 transactions, qint32 chunksAlloc,
 
 private Q_SLOTS:
     void testOperations();
+    void testSharedStoreSize();
     void testFragmentation();
 };
 
@@ -212,4 +212,53 @@ void KisLowMemoryTests::hangingTilesTest()
     dstTile = 0;
 }
 
+void KisLowMemoryTests::prefetchSwappedTilesTest()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    const QRect rc(0, 0, 8 * 64, 8 * 64);
+    QVector<quint8> buffer(rc.width() * rc.height());
+
+    for (int i = 0; i < buffer.size(); i++) {
+        buffer[i] = i % 251;
+    }
+
+    dm.writeBytes(buffer.data(), rc.x(), rc.y(), rc.width(), rc.height());
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->debugSwapAll();
+    QVERIFY(store->hasSwappedTileData());
+
+    const KisTileDataPrefetcher::Statistics statsBefore = store->prefetchStatistics();
+
+    dm.prefetchTileData(rc);
+
+    QCOMPARE(store->prefetchStatistics().numRequests - statsBefore.numRequests, qint64(64));
+
+    // give the prefetcher some time to do its work
+    for (int i = 0; i < 100; i++) {
+        bool allLoaded = true;
+
+        for (int row = 0; row < 8 && allLoaded; row++) {
+            for (int col = 0; col < 8 && allLoaded; col++) {
+                allLoaded = dm.getTile(col, row, false)->tileData()->data();
+            }
+        }
+
+        if (allLoaded) break;
+        QTest::qSleep(10);
+    }
+
+    // nobody has accessed the prefetched tiles yet
+    QCOMPARE(store->prefetchStatistics().numHits, statsBefore.numHits);
+
+    QVector<quint8> result(buffer.size());
+    dm.readBytes(result.data(), rc.x(), rc.y(), rc.width(), rc.height());
+    QCOMPARE(result, buffer);
+
+    const KisTileDataPrefetcher::Statistics statsAfter = store->prefetchStatistics();
+    QVERIFY(statsAfter.numHits > statsBefore.numHits);
+}
+
 QTEST_MAIN(KisLowMemoryTests)
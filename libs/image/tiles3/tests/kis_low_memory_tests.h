@@ -29,6 +29,7 @@ private Q_SLOTS:
 
     void readWriteOnSharedTiles();
     void hangingTilesTest();
+    void prefetchSwappedTilesTest();
 };
 
 #endif /* __KIS_LOW_MEMORY_TESTS_H */
@@ -30,12 +30,14 @@ void KisStoreLimitsTest::testLimits()
     config.setMemoryHardLimitPercent(50);
     config.setMemorySoftLimitPercent(25);
     config.setMemoryPoolLimitPercent(10);
+    config.setMemoryHistoryLimitPercent(20);
 
     const int totalRAM = KisImageConfig::totalRAM();
 
     // values are shifted because of the pooler part
     const int halfRAMMetric = MiB_TO_METRIC(int(totalRAM * 0.4));
     const int quarterRAMMetric = MiB_TO_METRIC(int(totalRAM * 0.15));
+    const int historyRAMMetric = MiB_TO_METRIC(int(config.tilesHardLimit() * 0.2));
 
     KisStoreLimits limits;
 
@@ -44,6 +46,8 @@ void KisStoreLimitsTest::testLimits()
     QCOMPARE(limits.hardLimit(), (halfRAMMetric * 7 / 8) * 7 / 8);
     QCOMPARE(limits.softLimitThreshold(), quarterRAMMetric);
     QCOMPARE(limits.softLimit(), quarterRAMMetric * 7 / 8);
+    QCOMPARE(limits.historyLimitThreshold(), historyRAMMetric);
+    QCOMPARE(limits.historyLimit(), historyRAMMetric * 7 / 8);
 }
 
 QTEST_MAIN(KisStoreLimitsTest)
@@ -18,6 +18,7 @@
 
 #include "kis_swapped_data_store_test.h"
 #include <QTest>
+#include <QThread>
 
 #include "kis_debug.h"
 
@@ -131,5 +132,99 @@ void KisSwappedDataStoreTest::testRandomAccess()
         delete tileDataList[i];
 }
 
+class SwapStoreAccessThread : public QThread
+{
+public:
+    SwapStoreAccessThread(const QList<KisTileData*> &tileDataList,
+                          qint32 firstColumn,
+                          KisSwappedDataStore &store)
+        : m_tileDataList(tileDataList),
+          m_firstColumn(firstColumn),
+          m_store(store),
+          m_failed(false)
+    {
+    }
+
+    bool failed() const {
+        return m_failed;
+    }
+
+protected:
+    void run() override {
+        for(qint32 cycle = 0; cycle < 4; cycle++) {
+            for(qint32 i = 0; i < m_tileDataList.size(); i++) {
+                const qint32 column = m_firstColumn + i;
+                KisTileData *td = m_tileDataList[i];
+
+                if(td->data()) {
+                    memset(td->data(), COLUMN2COLOR(column), TILESIZE);
+                    m_store.swapOutTileData(td);
+                }
+                else {
+                    m_store.swapInTileData(td);
+                    m_failed |= !memoryIsFilled(COLUMN2COLOR(column), td->data(), TILESIZE);
+                }
+            }
+        }
+    }
+
+private:
+    QList<KisTileData*> m_tileDataList;
+    qint32 m_firstColumn;
+    KisSwappedDataStore &m_store;
+    bool m_failed;
+};
+
+void KisSwappedDataStoreTest::testConcurrentAccess()
+{
+    const qint32 pixelSize = 1;
+    const quint8 defaultPixel = 128;
+    const qint32 NUM_THREADS = 8;
+    const qint32 NUM_TILES_PER_THREAD = 1000;
+
+    KisImageConfig config;
+    config.setMaxSwapSize(40);
+    config.setSwapSlabSize(1);
+    config.setSwapWindowSize(1);
+
+
+    KisSwappedDataStore store(4);
+    QCOMPARE(store.numShards(), 4);
+
+    QList<KisTileData*> allTileData;
+    QList<SwapStoreAccessThread*> threads;
+
+    for(qint32 i = 0; i < NUM_THREADS; i++) {
+        QList<KisTileData*> tileDataList;
+        for(qint32 j = 0; j < NUM_TILES_PER_THREAD; j++)
+            tileDataList.append(new KisTileData(pixelSize, &defaultPixel, KisTileDataStore::instance()));
+
+        allTileData.append(tileDataList);
+        threads.append(new SwapStoreAccessThread(tileDataList, i * NUM_TILES_PER_THREAD, store));
+    }
+
+    Q_FOREACH (SwapStoreAccessThread *thread, threads) {
+        thread->start();
+    }
+
+    Q_FOREACH (SwapStoreAccessThread *thread, threads) {
+        thread->wait();
+        QVERIFY(!thread->failed());
+    }
+
+    KisSwappedDataStore::Statistics stats = store.statistics();
+    QCOMPARE(stats.numShards, 4);
+    QCOMPARE(stats.numTiles, quint64(0));
+    QCOMPARE(stats.memoryMetric, qint64(0));
+    QCOMPARE(stats.compressedSize, qint64(0));
+    QCOMPARE(stats.numSwapOuts, qint64(2 * NUM_THREADS * NUM_TILES_PER_THREAD));
+    QCOMPARE(stats.numSwapIns, qint64(2 * NUM_THREADS * NUM_TILES_PER_THREAD));
+
+    store.debugStatistics();
+
+    qDeleteAll(threads);
+    qDeleteAll(allTileData);
+}
+
 QTEST_MAIN(KisSwappedDataStoreTest)
 
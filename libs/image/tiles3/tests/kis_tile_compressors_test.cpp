@@ -22,6 +22,9 @@
 #include "tiles3/kis_tiled_data_manager.h"
 #include "tiles3/swap/kis_legacy_tile_compressor.h"
 #include "tiles3/swap/kis_tile_compressor_2.h"
+#include "tiles3/kis_compressed_tiles_cache.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "kis_image_config.h"
 
 #include "tiles_test_utils.h"
 
@@ -179,6 +182,271 @@ void KisTileCompressorsTest::testLowLevelRoundTripIncompressible2()
     delete compressor;
 }
 
+void KisTileCompressorsTest::testRoundTripLz4()
+{
+    KisAbstractTileCompressor *compressor = new KisTileCompressor2(KisTileCompressor2::LZ4);
+    doRoundTrip(compressor);
+    delete compressor;
+}
+
+void KisTileCompressorsTest::testLowLevelRoundTripLz4()
+{
+    KisAbstractTileCompressor *compressor = new KisTileCompressor2(KisTileCompressor2::LZ4);
+    doLowLevelRoundTrip(compressor);
+    doLowLevelRoundTripIncompressible(compressor);
+    delete compressor;
+}
+
+void KisTileCompressorsTest::testRoundTripZlib()
+{
+    KisAbstractTileCompressor *compressor = new KisTileCompressor2(KisTileCompressor2::ZLIB);
+    doRoundTrip(compressor);
+    delete compressor;
+}
+
+void KisTileCompressorsTest::testLowLevelRoundTripZlib()
+{
+    KisAbstractTileCompressor *compressor = new KisTileCompressor2(KisTileCompressor2::ZLIB);
+    doLowLevelRoundTrip(compressor);
+    doLowLevelRoundTripIncompressible(compressor);
+    delete compressor;
+}
+
+void fillTilesWithPattern(KisTiledDataManager &dm, int numTilesX, int numTilesY)
+{
+    for (int row = 0; row < numTilesY; row++) {
+        for (int col = 0; col < numTilesX; col++) {
+            quint8 pixel = (row * numTilesX + col) % 255 + 1;
+            dm.clear(col * 64, row * 64, 64, 64, &pixel);
+        }
+    }
+}
+
+void KisTileCompressorsTest::testDataManagerRoundTrip()
+{
+    /**
+     * The tiles are compressed in parallel batches, so check
+     * that they are written into the stream in correct shape
+     * when there are many more tiles than a single batch holds
+     */
+    const int numTilesX = 50;
+    const int numTilesY = 40;
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+    fillTilesWithPattern(dm, numTilesX, numTilesY);
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+
+    QVERIFY(dm.write(writer));
+
+    fakeStore.startReading();
+
+    KisTiledDataManager readDm(1, &defaultPixel);
+    QVERIFY(readDm.read(fakeStore.device()));
+
+    QCOMPARE(readDm.extent(), dm.extent());
+
+    for (int row = 0; row < numTilesY; row++) {
+        for (int col = 0; col < numTilesX; col++) {
+            quint8 pixel = (row * numTilesX + col) % 255 + 1;
+
+            KisTileSP tile = readDm.getTile(col, row, false);
+
+            // the tile may be loaded lazily, lock it to get the data
+            tile->lockForRead();
+            QVERIFY(memoryIsFilled(pixel, tile->data(), TILESIZE));
+            tile->unlock();
+        }
+    }
+}
+
+void KisTileCompressorsTest::testLazyLoading()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    dm.clear(64, 64, 64, 64, &oddPixel1);
+
+    KisTileSP tile11 = dm.getTile(1, 1, false);
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+
+    // use a codec different from the swap one
+    KisTileCompressor2 compressor(KisTileCompressor2::ZLIB);
+    QVERIFY(compressor.writeTile(tile11, writer));
+    tile11 = 0;
+
+    fakeStore.startReading();
+    dm.clear();
+
+    compressor.setLazyLoading(true);
+    QVERIFY(compressor.readTile(fakeStore.device(), &dm));
+
+    tile11 = dm.getTile(1, 1, false);
+
+    // the data stays in the swap until the first access
+    QVERIFY(!tile11->tileData()->data());
+
+    tile11->lockForRead();
+    QVERIFY(memoryIsFilled(oddPixel1, tile11->data(), TILESIZE));
+    tile11->unlock();
+}
+
+void KisTileCompressorsTest::testLazyLoadingCorruptedTile()
+{
+    quint8 defaultPixel = 7;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+
+    // a compressed tile with garbage instead of the stream
+    QByteArray data(16, 'x');
+    data[0] = 1;
+
+    QVERIFY(writer.write(QByteArray("64,64,ZLIB,16\n")));
+    QVERIFY(writer.write(data));
+
+    fakeStore.startReading();
+
+    KisTileCompressor2 compressor(KisTileCompressor2::ZLIB);
+    compressor.setLazyLoading(true);
+
+    // the corrupted data is reported when loading, not put into the swap
+    QVERIFY(!compressor.readTile(fakeStore.device(), &dm));
+
+    KisTileSP tile11 = dm.getTile(1, 1, false);
+    QVERIFY(tile11->tileData()->data());
+}
+
+void KisTileCompressorsTest::testCompressedTilesCache()
+{
+    const int numTilesX = 4;
+    const int numTilesY = 4;
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+    fillTilesWithPattern(dm, numTilesX, numTilesY);
+
+    KisTileCompressor2::Codec codec = KisTileCompressor2::LZF;
+    KisTileCompressor2::codecFromName(KisImageConfig(true).tilesCompressionCodec(), &codec);
+
+    KisCompressedTilesCache cache;
+
+    {
+        KoStoreFake fakeStore;
+        KisFakePaintDeviceWriter writer(&fakeStore, &cache);
+
+        cache.beginSaving();
+        QVERIFY(dm.write(writer));
+        cache.endSaving();
+    }
+
+    KisTileSP tile00 = dm.getTile(0, 0, false);
+    KisTileSP tile11 = dm.getTile(1, 1, false);
+    KisTileData *oldTileData00 = tile00->tileData();
+
+    QByteArray buffer;
+    QVERIFY(cache.fetchTile(oldTileData00, 0, 0, codec, buffer));
+    QVERIFY(cache.fetchTile(tile11->tileData(), 1, 1, codec, buffer));
+
+    // the cache doesn't use the data of the saved tile, so the write
+    // should change it in place
+    quint8 oddPixel = 128;
+    dm.clear(0, 0, 10, 10, &oddPixel);
+
+    QVERIFY(tile00->tileData() == oldTileData00);
+    QVERIFY(!cache.fetchTile(tile00->tileData(), 0, 0, codec, buffer));
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore, &cache);
+
+    cache.beginSaving();
+    QVERIFY(dm.write(writer));
+    cache.endSaving();
+
+    // only the changed tile has been compressed again
+    QCOMPARE(cache.numFetchedTiles(), numTilesX * numTilesY - 1);
+    QCOMPARE(cache.numAddedTiles(), 1);
+
+    QVERIFY(cache.fetchTile(tile00->tileData(), 0, 0, codec, buffer));
+    QVERIFY(cache.fetchTile(tile11->tileData(), 1, 1, codec, buffer));
+
+    fakeStore.startReading();
+
+    KisTiledDataManager readDm(1, &defaultPixel);
+    QVERIFY(readDm.read(fakeStore.device()));
+
+    QCOMPARE(readDm.extent(), dm.extent());
+
+    for (int row = 0; row < numTilesY; row++) {
+        for (int col = 0; col < numTilesX; col++) {
+            quint8 pixel = (row * numTilesX + col) % 255 + 1;
+
+            KisTileSP tile = readDm.getTile(col, row, false);
+
+            tile->lockForRead();
+            if (!col && !row) {
+                QCOMPARE(tile->data()[0], oddPixel);
+                QCOMPARE(tile->data()[TILESIZE - 1], pixel);
+            } else {
+                QVERIFY(memoryIsFilled(pixel, tile->data(), TILESIZE));
+            }
+            tile->unlock();
+        }
+    }
+
+    // the cached streams are counted in the memory of the tiles
+    const qint64 memoryMetric = KisTileDataStore::instance()->memoryMetric();
+    QVERIFY(cache.size() > 0);
+    cache.clear();
+    QCOMPARE(cache.size(), qint64(0));
+    QVERIFY(KisTileDataStore::instance()->memoryMetric() <= memoryMetric);
+}
+
+void KisTileCompressorsTest::testCompressedTilesCacheLimit()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+    fillTilesWithPattern(dm, 4, 4);
+
+    // the limit is less than a single compressed tile
+    KisCompressedTilesCache cache(1);
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore, &cache);
+
+    cache.beginSaving();
+    QVERIFY(dm.write(writer));
+    cache.endSaving();
+
+    QCOMPARE(cache.size(), qint64(0));
+
+    KisTileSP tile00 = dm.getTile(0, 0, false);
+    QByteArray buffer;
+    QVERIFY(!cache.fetchTile(tile00->tileData(), 0, 0, KisTileCompressor2::LZF, buffer));
+}
+
+void KisTileCompressorsTest::benchmarkDataManagerWrite()
+{
+    const int numTilesX = 128;
+    const int numTilesY = 128;
+
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+    fillTilesWithPattern(dm, numTilesX, numTilesY);
+
+    QBENCHMARK {
+        KoStoreFake fakeStore;
+        KisFakePaintDeviceWriter writer(&fakeStore);
+        dm.write(writer);
+    }
+}
+
 
 QTEST_MAIN(KisTileCompressorsTest)
 
@@ -38,6 +38,19 @@ private Q_SLOTS:
     void testRoundTrip2();
     void testLowLevelRoundTrip2();
     void testLowLevelRoundTripIncompressible2();
+
+    void testRoundTripLz4();
+    void testLowLevelRoundTripLz4();
+
+    void testRoundTripZlib();
+    void testLowLevelRoundTripZlib();
+
+    void testDataManagerRoundTrip();
+    void testLazyLoading();
+    void testLazyLoadingCorruptedTile();
+    void testCompressedTilesCache();
+    void testCompressedTilesCacheLimit();
+    void benchmarkDataManagerWrite();
 };
 
 #endif /* KIS_TILE_COMPRESSORS_TEST_H */
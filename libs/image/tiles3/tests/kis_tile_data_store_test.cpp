@@ -181,5 +181,90 @@ void KisTileDataStoreTest::testSwapping()
     }
 }
 
+void KisTileDataStoreTest::testDeduplication()
+{
+    KisTileDataStore::instance()->debugClear();
+
+    const qint32 pixelSize = 4;
+    quint8 defaultPixel[pixelSize] = {128, 128, 128, 255};
+    quint8 otherPixel[pixelSize] = {10, 20, 30, 255};
+
+    KisTileData *td1 = KisTileDataStore::instance()->createDefaultTileData(pixelSize, defaultPixel);
+    KisTileData *td2 = KisTileDataStore::instance()->createDefaultTileData(pixelSize, defaultPixel);
+    KisTileData *td3 = KisTileDataStore::instance()->createDefaultTileData(pixelSize, otherPixel);
+
+    QVERIFY(KisTileDataStore::instance()->tryDeduplicateTileData(td1));
+    QVERIFY(KisTileDataStore::instance()->tryDeduplicateTileData(td2));
+    QVERIFY(KisTileDataStore::instance()->tryDeduplicateTileData(td3));
+
+    // the hash is not recalculated until the data is changed
+    QVERIFY(!KisTileDataStore::instance()->tryDeduplicateTileData(td1));
+
+    QVERIFY(td1->isDataShared());
+    QVERIFY(td2->isDataShared());
+    QVERIFY(!td3->isDataShared());
+    QCOMPARE(td1->data(), td2->data());
+
+    QCOMPARE(KisTileDataStore::instance()->memoryStatistics().deduplicatedSize,
+             qint64(pixelSize * TILESIZE));
+
+    td2->blockSwapping();
+    KisTileData::SharedDataRef oldData = td2->detachData();
+    td2->invalidateContentHash();
+    memset(td2->data(), 0, pixelSize * TILESIZE);
+    td2->unblockSwapping();
+
+    // the old buffer is still alive until the reference is dropped
+    QCOMPARE(oldData.data, td1->data());
+    KisTileData::releaseSharedData(oldData);
+
+    QCOMPARE(KisTileDataStore::instance()->memoryStatistics().deduplicatedSize, qint64(0));
+
+    QVERIFY(!td2->isDataShared());
+    QVERIFY(td1->data() != td2->data());
+    QVERIFY(memoryIsFilled(0, td2->data(), TILESIZE * pixelSize));
+
+    for (int i = 0; i < TILESIZE; i++) {
+        QVERIFY(!memcmp(td1->data() + i * pixelSize, defaultPixel, pixelSize));
+    }
+
+    KisTileDataStore::instance()->freeTileData(td1);
+    KisTileDataStore::instance()->freeTileData(td2);
+    KisTileDataStore::instance()->freeTileData(td3);
+
+    QCOMPARE(KisTileDataStore::instance()->numTiles(), 0);
+}
+
+void KisTileDataStoreTest::testDeduplicationReleasePools()
+{
+    KisTileDataStore::instance()->debugClear();
+
+    const qint32 pixelSize = 4;
+    quint8 defaultPixel[pixelSize] = {128, 128, 128, 255};
+
+    KisTileData *td1 = KisTileDataStore::instance()->createDefaultTileData(pixelSize, defaultPixel);
+    KisTileData *td2 = KisTileDataStore::instance()->createDefaultTileData(pixelSize, defaultPixel);
+
+    QVERIFY(KisTileDataStore::instance()->tryDeduplicateTileData(td1));
+    QVERIFY(KisTileDataStore::instance()->tryDeduplicateTileData(td2));
+    QVERIFY(td1->isDataShared());
+
+    QCOMPARE(KisTileDataStore::instance()->memoryStatistics().deduplicatedSize,
+             qint64(pixelSize * TILESIZE));
+
+    // the purge gives every tile data its own copy of the buffer
+    KisTileData::releaseInternalPools();
+
+    QVERIFY(!td1->isDataShared());
+    QVERIFY(!td2->isDataShared());
+    QVERIFY(td1->data() != td2->data());
+    QCOMPARE(KisTileDataStore::instance()->memoryStatistics().deduplicatedSize, qint64(0));
+
+    KisTileDataStore::instance()->freeTileData(td1);
+    KisTileDataStore::instance()->freeTileData(td2);
+
+    QCOMPARE(KisTileDataStore::instance()->numTiles(), 0);
+}
+
 QTEST_MAIN(KisTileDataStoreTest)
 
@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_hash_table_test.h"
+#include <QTest>
+
+#include "kis_debug.h"
+
+#include "tiles3/kis_tile.h"
+#include "tiles3/kis_tile_hash_table.h"
+#include "tiles3/kis_tile_data_store.h"
+
+
+#define NUM_THREADS 16
+#define AREA_SIZE 64
+#define NUM_CYCLES 16
+
+static KisTileData* createDefaultTileData()
+{
+    quint8 defaultPixel = 0;
+    return KisTileDataStore::instance()->createDefaultTileData(1, &defaultPixel);
+}
+
+class KisGetTileLazyJob : public QRunnable
+{
+public:
+    KisGetTileLazyJob(KisTileHashTable &ht, qint32 firstCol, qint32 firstRow)
+        : m_ht(ht), m_firstCol(firstCol), m_firstRow(firstRow),
+          m_numNewTiles(0), m_numWrongTiles(0)
+    {
+    }
+
+    void run() override {
+        for (qint32 i = 0; i < NUM_CYCLES; i++) {
+            for (qint32 row = m_firstRow; row < m_firstRow + AREA_SIZE; row++) {
+                for (qint32 col = m_firstCol; col < m_firstCol + AREA_SIZE; col++) {
+                    bool newTile = false;
+                    KisTileSP tile = m_ht.getTileLazy(col, row, newTile);
+
+                    if (newTile) {
+                        m_numNewTiles++;
+                    }
+
+                    if (tile->col() != col || tile->row() != row) {
+                        m_numWrongTiles++;
+                    }
+                }
+            }
+        }
+    }
+
+    qint32 numNewTiles() const {
+        return m_numNewTiles;
+    }
+
+    qint32 numWrongTiles() const {
+        return m_numWrongTiles;
+    }
+
+private:
+    KisTileHashTable &m_ht;
+    qint32 m_firstCol;
+    qint32 m_firstRow;
+    qint32 m_numNewTiles;
+    qint32 m_numWrongTiles;
+};
+
+void KisTileHashTableTest::testConcurrentGetTileLazy()
+{
+    KisTileHashTable ht(0);
+    ht.setDefaultTileData(createDefaultTileData());
+
+    QList<KisGetTileLazyJob*> jobs;
+    QThreadPool pool;
+    pool.setMaxThreadCount(NUM_THREADS);
+
+    /**
+     * Every job overlaps half of the area of its neighbour,
+     * so the threads will race for creation of the same tiles
+     */
+    for (qint32 i = 0; i < NUM_THREADS; i++) {
+        KisGetTileLazyJob *job = new KisGetTileLazyJob(ht, i * AREA_SIZE / 2, 0);
+        job->setAutoDelete(false);
+        jobs.append(job);
+        pool.start(job);
+    }
+    pool.waitForDone();
+
+    const qint32 expectedNumTiles = (NUM_THREADS + 1) * AREA_SIZE / 2 * AREA_SIZE;
+
+    qint32 numNewTiles = 0;
+    Q_FOREACH (KisGetTileLazyJob *job, jobs) {
+        numNewTiles += job->numNewTiles();
+        QCOMPARE(job->numWrongTiles(), 0);
+    }
+    qDeleteAll(jobs);
+
+    QCOMPARE(numNewTiles, expectedNumTiles);
+    QCOMPARE(ht.numTiles(), expectedNumTiles);
+
+    qint32 numIteratedTiles = 0;
+    {
+        KisTileHashTableIterator iter(&ht);
+        for (; !iter.isDone(); iter.next()) {
+            numIteratedTiles++;
+        }
+    }
+
+    QCOMPARE(numIteratedTiles, expectedNumTiles);
+}
+
+class KisCreateDeleteTileJob : public QRunnable
+{
+public:
+    KisCreateDeleteTileJob(KisTileHashTable &ht, qint32 row)
+        : m_ht(ht), m_row(row)
+    {
+    }
+
+    void run() override {
+        for (qint32 i = 0; i < NUM_CYCLES; i++) {
+            for (qint32 col = 0; col < AREA_SIZE; col++) {
+                bool newTile = false;
+                m_ht.getTileLazy(col, m_row, newTile);
+            }
+
+            for (qint32 col = 0; col < AREA_SIZE; col++) {
+                m_ht.deleteTile(col, m_row);
+            }
+        }
+    }
+
+private:
+    KisTileHashTable &m_ht;
+    qint32 m_row;
+};
+
+void KisTileHashTableTest::testConcurrentDeleteTile()
+{
+    KisTileHashTable ht(0);
+    ht.setDefaultTileData(createDefaultTileData());
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(NUM_THREADS);
+
+    for (qint32 i = 0; i < NUM_THREADS; i++) {
+        pool.start(new KisCreateDeleteTileJob(ht, i));
+    }
+    pool.waitForDone();
+
+    QVERIFY(ht.isEmpty());
+    QCOMPARE(ht.numTiles(), 0);
+}
+
+void KisTileHashTableTest::runContentionBenchmark(int numThreads, bool sameArea)
+{
+    KisTileHashTable ht(0);
+    ht.setDefaultTileData(createDefaultTileData());
+
+    QList<KisGetTileLazyJob*> jobs;
+    for (qint32 i = 0; i < numThreads; i++) {
+        KisGetTileLazyJob *job =
+            new KisGetTileLazyJob(ht, sameArea ? 0 : i * AREA_SIZE, 0);
+        job->setAutoDelete(false);
+        jobs.append(job);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    QBENCHMARK {
+        Q_FOREACH (KisGetTileLazyJob *job, jobs) {
+            pool.start(job);
+        }
+        pool.waitForDone();
+    }
+
+    qDeleteAll(jobs);
+}
+
+void KisTileHashTableTest::benchmarkGetTileLazy1Thread()
+{
+    runContentionBenchmark(1, false);
+}
+
+void KisTileHashTableTest::benchmarkGetTileLazy16Threads()
+{
+    runContentionBenchmark(NUM_THREADS, false);
+}
+
+void KisTileHashTableTest::benchmarkGetTileLazy16ThreadsSameArea()
+{
+    runContentionBenchmark(NUM_THREADS, true);
+}
+
+QTEST_MAIN(KisTileHashTableTest)
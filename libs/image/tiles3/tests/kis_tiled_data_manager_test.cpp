@@ -474,6 +474,51 @@ void KisTiledDataManagerTest::testPurgeHistory()
     dm.purgeHistory(memento4);
 }
 
+void KisTiledDataManagerTest::testHistorySize()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    qint64 memorySize = -1;
+    qint64 swappedSize = -1;
+
+    dm.calculateHistorySize(memorySize, swappedSize);
+    QCOMPARE(memorySize, 0LL);
+    QCOMPARE(swappedSize, 0LL);
+
+    KisMementoSP memento1 = dm.getMemento();
+    dm.clear(0, 0, 64, 64, &oddPixel1);
+    dm.commit();
+
+    /**
+     * The tile data of the first revision is still used
+     * by the device, so it is not counted as history
+     */
+    dm.calculateHistorySize(memorySize, swappedSize);
+    QCOMPARE(memorySize, 0LL);
+    QCOMPARE(swappedSize, 0LL);
+
+    KisMementoSP memento2 = dm.getMemento();
+    dm.clear(0, 0, 64, 64, &oddPixel2);
+    dm.commit();
+
+    dm.calculateHistorySize(memorySize, swappedSize);
+    QCOMPARE(memorySize, qint64(TILESIZE));
+    QCOMPARE(swappedSize, 0LL);
+
+    /**
+     * Undone revisions are still a part of the history
+     */
+    dm.rollback(memento2);
+
+    dm.calculateHistorySize(memorySize, swappedSize);
+    QCOMPARE(memorySize, qint64(TILESIZE));
+    QCOMPARE(swappedSize, 0LL);
+}
+
 void KisTiledDataManagerTest::testUndoSetDefaultPixel()
 {
     quint8 defaultPixel = 0;
@@ -51,6 +51,7 @@ private Q_SLOTS:
     void testBitBltRough();
     void testTransactions();
     void testPurgeHistory();
+    void testHistorySize();
     void testUndoSetDefaultPixel();
 
     void benchmarkReadOnlyTileLazy();
@@ -25,8 +25,9 @@
 
 class KisFakePaintDeviceWriter : public KisPaintDeviceWriter {
 public:
-    KisFakePaintDeviceWriter(KoStore *store)
-        : m_store(store)
+    KisFakePaintDeviceWriter(KoStore *store, KisCompressedTilesCache *tilesCache = 0)
+        : m_store(store),
+          m_tilesCache(tilesCache)
     {
     }
 
@@ -38,7 +39,12 @@ public:
         return (m_store->write(data, length) == length);
     }
 
+    KisCompressedTilesCache* compressedTilesCache() const override {
+        return m_tilesCache;
+    }
+
     KoStore *m_store;
+    KisCompressedTilesCache *m_tilesCache;
 };
 
 
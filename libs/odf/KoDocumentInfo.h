@@ -58,6 +58,12 @@ public:
      */
     explicit KoDocumentInfo(QObject *parent = 0);
 
+    /**
+     * Creates a copy of \p rhs, e.g. for saving it in a background thread
+     * @param parent a pointer to the parent object
+     */
+    explicit KoDocumentInfo(const KoDocumentInfo &rhs, QObject *parent = 0);
+
     /** The destructor */
     ~KoDocumentInfo() override;
     /**
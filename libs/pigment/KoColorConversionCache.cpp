@@ -23,6 +23,7 @@
 #include <QList>
 #include <QMutex>
 #include <QThreadStorage>
+#include <QAtomicInt>
 
 #include <KoColorSpace.h>
 
@@ -56,10 +57,46 @@ uint qHash(const KoColorConversionCacheKey& key)
     return qHash(key.src) + qHash(key.dst) + qHash(key.renderingIntent) + qHash(key.conversionFlags);
 }
 
+/**
+ * The key of the thread-local caches. Only the pointers of the color
+ * spaces are compared, so the lookup never touches the color spaces
+ * themselves. Equal color spaces with different pointers just get
+ * separate entries.
+ */
+struct ThreadLocalCacheKey {
+
+    ThreadLocalCacheKey(const KoColorSpace* _src,
+                        const KoColorSpace* _dst,
+                        KoColorConversionTransformation::Intent _renderingIntent,
+                        KoColorConversionTransformation::ConversionFlags _conversionFlags)
+        : src(_src)
+        , dst(_dst)
+        , renderingIntent(_renderingIntent)
+        , conversionFlags(_conversionFlags)
+    {
+    }
+
+    bool operator==(const ThreadLocalCacheKey& rhs) const {
+        return src == rhs.src && dst == rhs.dst
+                && renderingIntent == rhs.renderingIntent
+                && conversionFlags == rhs.conversionFlags;
+    }
+
+    const KoColorSpace* src;
+    const KoColorSpace* dst;
+    KoColorConversionTransformation::Intent renderingIntent;
+    KoColorConversionTransformation::ConversionFlags conversionFlags;
+};
+
+uint qHash(const ThreadLocalCacheKey& key)
+{
+    return qHash(key.src) + qHash(key.dst) + qHash(key.renderingIntent) + qHash(key.conversionFlags);
+}
+
 struct KoColorConversionCache::CachedTransformation {
 
     CachedTransformation(KoColorConversionTransformation* _transfo)
-        : transfo(_transfo), use(0)
+        : transfo(_transfo), use(0), owner(0)
     {}
 
     ~CachedTransformation() {
@@ -67,22 +104,75 @@ struct KoColorConversionCache::CachedTransformation {
     }
 
     bool available() {
-        return use == 0;
+        return use.load() == 0;
     }
 
     KoColorConversionTransformation* transfo;
-    int use;
+
+    /**
+     * The number of handles to the transformation. A handle may be
+     * kept for a long time and passed to another thread, so the
+     * counter is updated atomically.
+     */
+    QAtomicInt use;
+
+    /**
+     * The thread-local cache the transformation belongs to. Only the
+     * owner thread uses the transformation, so it needs no locking.
+     * Protected by the cache mutex.
+     */
+    ThreadLocalCache *owner;
 };
 
-typedef QPair<KoColorConversionCacheKey, KoCachedColorConversionTransformation> FastPathCacheItem;
+/**
+ * Every thread keeps its own set of transformations, so in the common
+ * case a converter is found without taking any locks. The shared
+ * cache is locked only when a thread meets a pair of color spaces for
+ * the first time.
+ */
+struct KoColorConversionCache::ThreadLocalCache {
+    ThreadLocalCache(Private *_cache, int _generation)
+        : cache(_cache), generation(_generation)
+    {}
+
+    ~ThreadLocalCache();
+
+    Private *cache;
+
+    /**
+     * The generation of the shared cache the entries belong to. When
+     * a color space is destroyed, the generation changes and all the
+     * entries must be dropped without dereferencing them.
+     */
+    int generation;
+
+    QHash<ThreadLocalCacheKey, CachedTransformation*> transformations;
+};
 
 struct KoColorConversionCache::Private {
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*> cache;
     QMutex cacheMutex;
 
-    QThreadStorage<FastPathCacheItem*> fastStorage;
+    QAtomicInt generation;
+
+    QThreadStorage<ThreadLocalCache*> threadCaches;
+
+    void releaseThreadCache(ThreadLocalCache *threadCache) {
+        QMutexLocker lock(&cacheMutex);
+
+        Q_FOREACH (CachedTransformation* ct, cache) {
+            if (ct->owner == threadCache) {
+                ct->owner = 0;
+            }
+        }
+    }
 };
 
+KoColorConversionCache::ThreadLocalCache::~ThreadLocalCache()
+{
+    cache->releaseThreadCache(this);
+}
+
 
 KoColorConversionCache::KoColorConversionCache() : d(new Private)
 {
@@ -90,6 +180,8 @@ KoColorConversionCache::KoColorConversionCache() : d(new Private)
 
 KoColorConversionCache::~KoColorConversionCache()
 {
+    d->threadCaches.setLocalData(0);
+
     Q_FOREACH (CachedTransformation* transfo, d->cache) {
         delete transfo;
     }
@@ -101,48 +193,67 @@ KoCachedColorConversionTransformation KoColorConversionCache::cachedConverter(co
                                                                               KoColorConversionTransformation::Intent _renderingIntent,
                                                                               KoColorConversionTransformation::ConversionFlags _conversionFlags)
 {
-    KoColorConversionCacheKey key(src, dst, _renderingIntent, _conversionFlags);
+    const int generation = d->generation.loadAcquire();
 
-    FastPathCacheItem *cacheItem =
-        d->fastStorage.localData();
+    ThreadLocalCache *threadCache = d->threadCaches.localData();
 
-    if (cacheItem) {
-        if (cacheItem->first == key) {
-            return cacheItem->second;
-        }
+    if (!threadCache) {
+        threadCache = new ThreadLocalCache(d, generation);
+        d->threadCaches.setLocalData(threadCache);
+    } else if (threadCache->generation != generation) {
+        threadCache->transformations.clear();
+        threadCache->generation = generation;
+    }
+
+    ThreadLocalCacheKey localKey(src, dst, _renderingIntent, _conversionFlags);
+
+    /**
+     * Even the owner thread cannot reuse a transformation while there
+     * is a handle to it, e.g. a long-lived one kept by another
+     * transformation, so in that case a new one is fetched
+     */
+    CachedTransformation *cachedTransfo = threadCache->transformations.value(localKey, 0);
+    if (cachedTransfo && cachedTransfo->available()) {
+        return KoCachedColorConversionTransformation(this, cachedTransfo);
     }
+    cachedTransfo = 0;
 
-    cacheItem = 0;
+    KoColorConversionCacheKey key(src, dst, _renderingIntent, _conversionFlags);
 
     QMutexLocker lock(&d->cacheMutex);
     QList< CachedTransformation* > cachedTransfos = d->cache.values(key);
-    if (cachedTransfos.size() != 0) {
-        Q_FOREACH (CachedTransformation* ct, cachedTransfos) {
-            if (ct->available()) {
-                ct->transfo->setSrcColorSpace(src);
-                ct->transfo->setDstColorSpace(dst);
-
-                cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
-                break;
-            }
+    Q_FOREACH (CachedTransformation* ct, cachedTransfos) {
+        if (ct->available() && (!ct->owner || ct->owner == threadCache)) {
+            cachedTransfo = ct;
+            break;
         }
     }
-    if (!cacheItem) {
+
+    if (!cachedTransfo) {
         KoColorConversionTransformation* transfo = src->createColorConverter(dst, _renderingIntent, _conversionFlags);
-        CachedTransformation* ct = new CachedTransformation(transfo);
-        d->cache.insert(key, ct);
-        cacheItem = new FastPathCacheItem(key, KoCachedColorConversionTransformation(this, ct));
+        cachedTransfo = new CachedTransformation(transfo);
+        d->cache.insert(key, cachedTransfo);
     }
 
-    d->fastStorage.setLocalData(cacheItem);
-    return cacheItem->second;
+    cachedTransfo->owner = threadCache;
+    cachedTransfo->transfo->setSrcColorSpace(src);
+    cachedTransfo->transfo->setDstColorSpace(dst);
+
+    threadCache->transformations.insert(localKey, cachedTransfo);
+
+    return KoCachedColorConversionTransformation(this, cachedTransfo);
 }
 
 void KoColorConversionCache::colorSpaceIsDestroyed(const KoColorSpace* cs)
 {
-    d->fastStorage.setLocalData(0);
-
     QMutexLocker lock(&d->cacheMutex);
+
+    /**
+     * Make all the threads drop their local entries before they
+     * dereference any of the transformations deleted below
+     */
+    d->generation.ref();
+
     QMultiHash< KoColorConversionCacheKey, CachedTransformation*>::iterator endIt = d->cache.end();
     for (QMultiHash< KoColorConversionCacheKey, CachedTransformation*>::iterator it = d->cache.begin(); it != endIt;) {
         if (it.key().src == cs || it.key().dst == cs) {
@@ -168,18 +279,18 @@ KoCachedColorConversionTransformation::KoCachedColorConversionTransformation(KoC
     Q_ASSERT(transfo->available());
     d->cache = cache;
     d->transfo = transfo;
-    d->transfo->use++;
+    d->transfo->use.ref();
 }
 
 KoCachedColorConversionTransformation::KoCachedColorConversionTransformation(const KoCachedColorConversionTransformation& rhs) : d(new Private(*rhs.d))
 {
-    d->transfo->use++;
+    d->transfo->use.ref();
 }
 
 KoCachedColorConversionTransformation::~KoCachedColorConversionTransformation()
 {
-    d->transfo->use--;
-    Q_ASSERT(d->transfo->use >= 0);
+    d->transfo->use.deref();
+    Q_ASSERT(d->transfo->use.load() >= 0);
     delete d;
 }
 
@@ -57,6 +57,7 @@ public:
      */
     void colorSpaceIsDestroyed(const KoColorSpace* src);
 private:
+    struct ThreadLocalCache;
     struct Private;
     Private* const d;
 };
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KoColorConversionCacheBenchmark.h"
+
+#include <QTest>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QVector>
+#include <QPair>
+
+#include <KoColorSpaceRegistry.h>
+#include <KoColorSpace.h>
+
+#define NB_CONVERSIONS 20000
+#define NB_PIXELS 16
+
+typedef QPair<const KoColorSpace*, const KoColorSpace*> ColorSpacePair;
+
+/**
+ * Converts a small buffer of pixels, switching the pair of color
+ * spaces on every call, like the filters and the paintops do when
+ * they run on many threads at once. The buffers are small, so the
+ * time is dominated by fetching the converter from the cache.
+ */
+class MixedPairsConverter : public QRunnable
+{
+public:
+    MixedPairsConverter(const QVector<ColorSpacePair> &pairs)
+        : m_pairs(pairs)
+    {
+    }
+
+    void run() override {
+        QVector<quint8> src(NB_PIXELS * 16);
+        QVector<quint8> dst(NB_PIXELS * 16);
+
+        for (int i = 0; i < NB_CONVERSIONS; i++) {
+            const ColorSpacePair &pair = m_pairs[i % m_pairs.size()];
+            pair.first->convertPixelsTo(src.constData(), dst.data(), pair.second, NB_PIXELS,
+                                        KoColorConversionTransformation::internalRenderingIntent(),
+                                        KoColorConversionTransformation::internalConversionFlags());
+        }
+    }
+
+private:
+    QVector<ColorSpacePair> m_pairs;
+};
+
+void KoColorConversionCacheBenchmark::benchmarkMixedPairs_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("16 threads") << 16;
+}
+
+void KoColorConversionCacheBenchmark::benchmarkMixedPairs()
+{
+    QFETCH(int, numThreads);
+
+    KoColorSpaceRegistry *registry = KoColorSpaceRegistry::instance();
+
+    const KoColorSpace *rgb8 = registry->rgb8();
+    const KoColorSpace *rgb16 = registry->rgb16();
+    const KoColorSpace *lab16 = registry->lab16();
+
+    QVector<ColorSpacePair> pairs;
+    pairs << ColorSpacePair(rgb8, rgb16);
+    pairs << ColorSpacePair(rgb16, rgb8);
+    pairs << ColorSpacePair(rgb8, lab16);
+    pairs << ColorSpacePair(lab16, rgb8);
+    pairs << ColorSpacePair(rgb16, lab16);
+    pairs << ColorSpacePair(lab16, rgb16);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    QBENCHMARK {
+        for (int i = 0; i < numThreads; i++) {
+            pool.start(new MixedPairsConverter(pairs));
+        }
+        pool.waitForDone();
+    }
+}
+
+QTEST_MAIN(KoColorConversionCacheBenchmark)
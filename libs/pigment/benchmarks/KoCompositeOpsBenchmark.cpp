@@ -72,19 +72,38 @@ void KoCompositeOpsBenchmark::cleanupTestCase()
 
 void KoCompositeOpsBenchmark::benchmarkCompositeOver()
 {
-    KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createOverOp32(KoColorSpaceRegistry::instance()->rgb16());
+    KoCompositeOp *compositeOp = new KoCompositeOpOver<KoBgrU16Traits>(KoColorSpaceRegistry::instance()->rgb16());
     QBENCHMARK{
         COMPOSITE_BENCHMARK
     }
+    delete compositeOp;
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeOverOptimized()
+{
+    KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createOverOp64(KoColorSpaceRegistry::instance()->rgb16());
+    QBENCHMARK{
+        COMPOSITE_BENCHMARK
+    }
+    delete compositeOp;
 }
 
 void KoCompositeOpsBenchmark::benchmarkCompositeAlphaDarken()
 {
-    //KoCompositeOpAlphaDarken<KoBgrU16Traits> compositeOp(0);
-    KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOp32(KoColorSpaceRegistry::instance()->rgb16());
+    KoCompositeOp *compositeOp = new KoCompositeOpAlphaDarken<KoBgrU16Traits>(KoColorSpaceRegistry::instance()->rgb16());
+    QBENCHMARK{
+        COMPOSITE_BENCHMARK
+    }
+    delete compositeOp;
+}
+
+void KoCompositeOpsBenchmark::benchmarkCompositeAlphaDarkenOptimized()
+{
+    KoCompositeOp *compositeOp = KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(KoColorSpaceRegistry::instance()->rgb16());
     QBENCHMARK{
         COMPOSITE_BENCHMARK
     }
+    delete compositeOp;
 }
 
 
@@ -31,7 +31,9 @@ private Q_SLOTS:
     void cleanupTestCase();
     
     void benchmarkCompositeOver();
+    void benchmarkCompositeOverOptimized();
     void benchmarkCompositeAlphaDarken();
+    void benchmarkCompositeAlphaDarkenOptimized();
 
 private:
     quint8 * m_dstBuffer;
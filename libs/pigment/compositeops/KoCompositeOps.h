@@ -58,6 +58,16 @@ struct OptimizedOpsSelector
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return new KoCompositeOpOver<Traits>(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<Traits>(cs);
+    }
+    static KoCompositeOp* createEraseOp(const KoColorSpace *cs) {
+        return new KoCompositeOpErase<Traits>(cs);
+    }
+    template<typename Traits::channels_type compositeFunc(typename Traits::channels_type, typename Traits::channels_type)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return new KoCompositeOpGenericSC<Traits, compositeFunc>(cs, id, description, category);
+    }
 };
 
 template<>
@@ -69,6 +79,18 @@ struct OptimizedOpsSelector<KoBgrU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createBlendOp32(cs, COMPOSITE_COPY, i18n("Copy"), KoCompositeOp::categoryMisc());
+    }
+    static KoCompositeOp* createEraseOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createBlendOp32(cs, COMPOSITE_ERASE, i18n("Erase"), KoCompositeOp::categoryMix());
+    }
+    template<quint8 compositeFunc(quint8, quint8)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return KoOptimizedCompositeOpFactory::supportsBlendOp(id) ?
+            KoOptimizedCompositeOpFactory::createBlendOp32(cs, id, description, category) :
+            new KoCompositeOpGenericSC<KoBgrU8Traits, compositeFunc>(cs, id, description, category);
+    }
 };
 
 template<>
@@ -80,6 +102,58 @@ struct OptimizedOpsSelector<KoLabU8Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp32(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoLabU8Traits>(cs);
+    }
+    static KoCompositeOp* createEraseOp(const KoColorSpace *cs) {
+        return new KoCompositeOpErase<KoLabU8Traits>(cs);
+    }
+    template<quint8 compositeFunc(quint8, quint8)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return new KoCompositeOpGenericSC<KoLabU8Traits, compositeFunc>(cs, id, description, category);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoBgrU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoBgrU16Traits>(cs);
+    }
+    static KoCompositeOp* createEraseOp(const KoColorSpace *cs) {
+        return new KoCompositeOpErase<KoBgrU16Traits>(cs);
+    }
+    template<quint16 compositeFunc(quint16, quint16)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return new KoCompositeOpGenericSC<KoBgrU16Traits, compositeFunc>(cs, id, description, category);
+    }
+};
+
+template<>
+struct OptimizedOpsSelector<KoLabU16Traits>
+{
+    static KoCompositeOp* createAlphaDarkenOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(cs);
+    }
+    static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createOverOp64(cs);
+    }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return new KoCompositeOpCopy2<KoLabU16Traits>(cs);
+    }
+    static KoCompositeOp* createEraseOp(const KoColorSpace *cs) {
+        return new KoCompositeOpErase<KoLabU16Traits>(cs);
+    }
+    template<quint16 compositeFunc(quint16, quint16)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return new KoCompositeOpGenericSC<KoLabU16Traits, compositeFunc>(cs, id, description, category);
+    }
 };
 
 template<>
@@ -91,6 +165,18 @@ struct OptimizedOpsSelector<KoRgbF32Traits>
     static KoCompositeOp* createOverOp(const KoColorSpace *cs) {
         return KoOptimizedCompositeOpFactory::createOverOp128(cs);
     }
+    static KoCompositeOp* createCopyOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createBlendOp128(cs, COMPOSITE_COPY, i18n("Copy"), KoCompositeOp::categoryMisc());
+    }
+    static KoCompositeOp* createEraseOp(const KoColorSpace *cs) {
+        return KoOptimizedCompositeOpFactory::createBlendOp128(cs, COMPOSITE_ERASE, i18n("Erase"), KoCompositeOp::categoryMix());
+    }
+    template<float compositeFunc(float, float)>
+    static KoCompositeOp* createBlendOp(const KoColorSpace *cs, const QString& id, const QString& description, const QString& category) {
+        return KoOptimizedCompositeOpFactory::supportsBlendOp(id) ?
+            KoOptimizedCompositeOpFactory::createBlendOp128(cs, id, description, category) :
+            new KoCompositeOpGenericSC<KoRgbF32Traits, compositeFunc>(cs, id, description, category);
+    }
 };
 
 template<class Traits>
@@ -102,14 +188,14 @@ struct AddGeneralOps<Traits, true>
 
      template<CompositeFunc func>
      static void add(KoColorSpace* cs, const QString& id, const QString& description, const QString& category) {
-         cs->addCompositeOp(new KoCompositeOpGenericSC<Traits, func>(cs, id, description, category));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::template createBlendOp<func>(cs, id, description, category));
      }
 
      static void add(KoColorSpace* cs) {
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createOverOp(cs));
          cs->addCompositeOp(OptimizedOpsSelector<Traits>::createAlphaDarkenOp(cs));
-         cs->addCompositeOp(new KoCompositeOpCopy2<Traits>(cs));
-         cs->addCompositeOp(new KoCompositeOpErase<Traits>(cs));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createCopyOp(cs));
+         cs->addCompositeOp(OptimizedOpsSelector<Traits>::createEraseOp(cs));
          cs->addCompositeOp(new KoCompositeOpBehind<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpDestinationIn<Traits>(cs));
          cs->addCompositeOp(new KoCompositeOpDestinationAtop<Traits>(cs));
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2012 Dmitry Kazakov <dimula73@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOGENERICBLENDOPFACTORY_H
+#define KOGENERICBLENDOPFACTORY_H
+
+#include <QString>
+
+#include "KoCompositeOpGeneric.h"
+#include "KoCompositeOpFunctions.h"
+#include "KoCompositeOpErase.h"
+#include "KoCompositeOpCopy2.h"
+#include "KoCompositeOpRegistry.h"
+
+/**
+ * Creates the generic (non-vectorized) version of a composite op
+ * that has an optimized counterpart in KoOptimizedCompositeOpFactory.
+ * It is used when vectorization is not available and as a reference
+ * in the tests of the optimized ops.
+ *
+ * \return null if the op \p id has no optimized counterpart
+ */
+template<class Traits>
+KoCompositeOp* createGenericBlendOp(const KoColorSpace *cs, const QString &id,
+                                    const QString &description, const QString &category)
+{
+    typedef typename Traits::channels_type Arg;
+    KoCompositeOp *op = 0;
+
+    if (id == COMPOSITE_MULT) {
+        op = new KoCompositeOpGenericSC<Traits, &cfMultiply<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_SCREEN) {
+        op = new KoCompositeOpGenericSC<Traits, &cfScreen<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_OVERLAY) {
+        op = new KoCompositeOpGenericSC<Traits, &cfOverlay<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_HARD_LIGHT) {
+        op = new KoCompositeOpGenericSC<Traits, &cfHardLight<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_ADD || id == COMPOSITE_LINEAR_DODGE) {
+        op = new KoCompositeOpGenericSC<Traits, &cfAddition<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_DARKEN) {
+        op = new KoCompositeOpGenericSC<Traits, &cfDarkenOnly<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_LIGHTEN) {
+        op = new KoCompositeOpGenericSC<Traits, &cfLightenOnly<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_DODGE) {
+        op = new KoCompositeOpGenericSC<Traits, &cfColorDodge<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_BURN) {
+        op = new KoCompositeOpGenericSC<Traits, &cfColorBurn<Arg> >(cs, id, description, category);
+    } else if (id == COMPOSITE_ERASE) {
+        op = new KoCompositeOpErase<Traits>(cs);
+    } else if (id == COMPOSITE_COPY) {
+        op = new KoCompositeOpCopy2<Traits>(cs);
+    }
+
+    return op;
+}
+
+#endif /* KOGENERICBLENDOPFACTORY_H */
@@ -0,0 +1,239 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPALPHADARKEN64_H_
+#define KOOPTIMIZEDCOMPOSITEOPALPHADARKEN64_H_
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include <klocalizedstring.h>
+#include "KoStreamedMath.h"
+
+template<typename channels_type, typename pixel_type>
+struct AlphaDarkenCompositor64 {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+            : flow(params.flow),
+              averageOpacity(*params.lastOpacity * params.flow),
+              premultipliedOpacity(params.opacity * params.flow)
+        {
+        }
+        float flow;
+        float averageOpacity;
+        float premultipliedOpacity;
+    };
+
+    // \see docs in AlphaDarkenCompositor32
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Vc::float_v src_alpha;
+        Vc::float_v dst_alpha;
+
+        Vc::float_v opacity_vec(65535.0 * oparams.premultipliedOpacity);
+        Vc::float_v average_opacity_vec(65535.0 * oparams.averageOpacity);
+        Vc::float_v flow_norm_vec(oparams.flow);
+
+
+        Vc::float_v uint16MaxRec1((float)1.0 / 65535.0);
+        Vc::float_v uint16Uint8MaxRec((float)1.0 / (65535.0 * 255.0));
+        Vc::float_v uint16Max((float)65535.0);
+        Vc::float_v zeroValue(Vc::Zero);
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        KoStreamedMath<_impl>::fetch_channels_64(src, src_c1, src_c2, src_c3, src_alpha);
+
+        Vc::float_v msk_norm_alpha;
+
+        if (haveMask) {
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            msk_norm_alpha = src_alpha * mask_vec * uint16Uint8MaxRec;
+        } else {
+            msk_norm_alpha = src_alpha * uint16MaxRec1;
+        }
+
+        src_alpha = msk_norm_alpha * opacity_vec;
+
+        bool srcAlphaIsZero = (src_alpha == zeroValue).isFull();
+        if (srcAlphaIsZero) return;
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        KoStreamedMath<_impl>::fetch_channels_64(dst, dst_c1, dst_c2, dst_c3, dst_alpha);
+
+        Vc::float_m empty_dst_pixels_mask = dst_alpha == zeroValue;
+
+        Vc::float_v dst_blend = src_alpha * uint16MaxRec1;
+
+        if (empty_dst_pixels_mask.isFull()) {
+            dst_c1 = src_c1;
+            dst_c2 = src_c2;
+            dst_c3 = src_c3;
+        } else if ((src_alpha == uint16Max).isFull()) {
+            dst_c1 = src_c1;
+            dst_c2 = src_c2;
+            dst_c3 = src_c3;
+        } else if (empty_dst_pixels_mask.isEmpty()) {
+            dst_c1 = dst_blend * (src_c1 - dst_c1) + dst_c1;
+            dst_c2 = dst_blend * (src_c2 - dst_c2) + dst_c2;
+            dst_c3 = dst_blend * (src_c3 - dst_c3) + dst_c3;
+        } else {
+            Vc::float_m not_empty_dst_pixels_mask = !empty_dst_pixels_mask;
+
+            dst_c1(not_empty_dst_pixels_mask) = dst_blend * (src_c1 - dst_c1) + dst_c1;
+            dst_c2(not_empty_dst_pixels_mask) = dst_blend * (src_c2 - dst_c2) + dst_c2;
+            dst_c3(not_empty_dst_pixels_mask) = dst_blend * (src_c3 - dst_c3) + dst_c3;
+
+            dst_c1(empty_dst_pixels_mask) = src_c1;
+            dst_c2(empty_dst_pixels_mask) = src_c2;
+            dst_c3(empty_dst_pixels_mask) = src_c3;
+        }
+
+        Vc::float_v fullFlowAlpha;
+
+        if (oparams.averageOpacity > opacity) {
+            Vc::float_m fullFlowAlpha_mask = average_opacity_vec > dst_alpha;
+
+            if (fullFlowAlpha_mask.isEmpty()) {
+                fullFlowAlpha = dst_alpha;
+            } else {
+                Vc::float_v reverse_blend = dst_alpha / average_opacity_vec;
+                Vc::float_v opt1 = (average_opacity_vec - src_alpha) * reverse_blend + src_alpha;
+                fullFlowAlpha(!fullFlowAlpha_mask) = dst_alpha;
+                fullFlowAlpha(fullFlowAlpha_mask) = opt1;
+            }
+        } else {
+            Vc::float_m fullFlowAlpha_mask = opacity_vec > dst_alpha;
+
+            if (fullFlowAlpha_mask.isEmpty()) {
+                fullFlowAlpha = dst_alpha;
+            } else {
+                Vc::float_v opt1 = (opacity_vec - dst_alpha) * msk_norm_alpha + dst_alpha;
+                fullFlowAlpha(!fullFlowAlpha_mask) = dst_alpha;
+                fullFlowAlpha(fullFlowAlpha_mask) = opt1;
+            }
+        }
+
+        if (oparams.flow == 1.0) {
+            dst_alpha = fullFlowAlpha;
+        } else {
+            Vc::float_v zeroFlowAlpha = src_alpha + dst_alpha -
+                dst_blend * dst_alpha;
+            dst_alpha = (fullFlowAlpha - zeroFlowAlpha) * flow_norm_vec + zeroFlowAlpha;
+        }
+
+        KoStreamedMath<_impl>::write_channels_64(dst, dst_alpha, dst_c1, dst_c2, dst_c3);
+    }
+
+    /**
+     * Composes one pixel of the source into the destination
+     */
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *s, quint8 *d, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        using namespace Arithmetic;
+        const qint32 alpha_pos = 3;
+
+        const channels_type *src = reinterpret_cast<const channels_type*>(s);
+        channels_type *dst = reinterpret_cast<channels_type*>(d);
+
+        const float uint16Rec1 = 1.0 / 65535.0;
+        const float uint16Uint8Rec = 1.0 / (65535.0 * 255.0);
+        const float uint16Max = 65535.0;
+
+        quint16 dstAlphaInt = dst[alpha_pos];
+        float dstAlphaNorm = dstAlphaInt ? dstAlphaInt * uint16Rec1 : 0.0;
+        float srcAlphaNorm;
+        float mskAlphaNorm;
+
+        opacity = oparams.premultipliedOpacity;
+
+        if (haveMask) {
+            mskAlphaNorm = float(*mask) * uint16Uint8Rec * src[alpha_pos];
+            srcAlphaNorm = mskAlphaNorm * opacity;
+        } else {
+            mskAlphaNorm = src[alpha_pos] * uint16Rec1;
+            srcAlphaNorm = mskAlphaNorm * opacity;
+        }
+
+        if (dstAlphaInt != 0) {
+            dst[0] = KoStreamedMath<_impl>::lerp_mixed_u16_float(dst[0], src[0], srcAlphaNorm);
+            dst[1] = KoStreamedMath<_impl>::lerp_mixed_u16_float(dst[1], src[1], srcAlphaNorm);
+            dst[2] = KoStreamedMath<_impl>::lerp_mixed_u16_float(dst[2], src[2], srcAlphaNorm);
+        } else {
+            const pixel_type *sp = reinterpret_cast<const pixel_type*>(src);
+            pixel_type *dp = reinterpret_cast<pixel_type*>(dst);
+            *dp = *sp;
+        }
+
+
+        float flow = oparams.flow;
+        float averageOpacity = oparams.averageOpacity;
+
+        float fullFlowAlpha;
+
+        if (averageOpacity > opacity) {
+            fullFlowAlpha = averageOpacity > dstAlphaNorm ? lerp(srcAlphaNorm, averageOpacity, dstAlphaNorm / averageOpacity) : dstAlphaNorm;
+        } else {
+            fullFlowAlpha = opacity > dstAlphaNorm ? lerp(dstAlphaNorm, opacity, mskAlphaNorm) : dstAlphaNorm;
+        }
+
+        float dstAlpha;
+
+        if (flow == 1.0) {
+            dstAlpha = fullFlowAlpha * uint16Max;
+        } else {
+            float zeroFlowAlpha = unionShapeOpacity(srcAlphaNorm, dstAlphaNorm);
+            dstAlpha = lerp(zeroFlowAlpha, fullFlowAlpha, flow) * uint16Max;
+        }
+
+        dst[alpha_pos] = KoStreamedMath<_impl>::round_float_to_u16(dstAlpha);
+    }
+};
+
+/**
+ * An optimized version of a composite op for the use in 8 byte
+ * colorspaces with 16-bit channels and alpha channel placed at
+ * the last channel of the pixel: C1_C2_C3_A.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarken64 : public KoCompositeOp
+{
+public:
+    KoOptimizedCompositeOpAlphaDarken64(const KoColorSpace* cs)
+        : KoCompositeOp(cs, COMPOSITE_ALPHA_DARKEN, i18n("Alpha darken"), KoCompositeOp::categoryMix()) {}
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        if(params.maskRowStart) {
+            KoStreamedMath<_impl>::template genericComposite64<true, true, AlphaDarkenCompositor64<quint16, quint64> >(params);
+        } else {
+            KoStreamedMath<_impl>::template genericComposite64<false, true, AlphaDarkenCompositor64<quint16, quint64> >(params);
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPALPHADARKEN64_H_
@@ -0,0 +1,497 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPBLEND128_H_
+#define KOOPTIMIZEDCOMPOSITEOPBLEND128_H_
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+
+struct BlendPixel128 {
+    float red;
+    float green;
+    float blue;
+    float alpha;
+};
+
+/**
+ * A vectorized version of KoCompositeOpGenericSC for 32-bit float
+ * colorspaces. The result of the blending function is not clamped,
+ * the same way as it is done in the original op.
+ */
+template<class BlendFunc>
+struct GenericSCCompositor128 {
+template<bool alphaLocked, bool allChannelsFlag>
+struct Compositor {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+        using namespace KoStreamedMathFunctions;
+
+        const BlendPixel128 *sp = reinterpret_cast<const BlendPixel128*>(src);
+        BlendPixel128 *dp = reinterpret_cast<BlendPixel128*>(dst);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha;
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<BlendPixel128, Vc::float_v> data(const_cast<BlendPixel128*>(sp));
+        tie(src_c1, src_c2, src_c3, src_alpha) = data[indexes];
+
+        src_alpha *= Vc::float_v(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255);
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_alpha;
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        Vc::InterleavedMemoryWrapper<BlendPixel128, Vc::float_v> dataDest(dp);
+        tie(dst_c1, dst_c2, dst_c3, dst_alpha) = dataDest[indexes];
+
+        const Vc::float_v new_alpha = src_alpha + dst_alpha - src_alpha * dst_alpha;
+        const Vc::float_v src_weight = src_alpha * (oneValue - dst_alpha);
+        const Vc::float_v dst_weight = dst_alpha * (oneValue - src_alpha);
+        const Vc::float_v blend_weight = src_alpha * dst_alpha;
+
+        /**
+         * NaN's in the transparent pixels are masked out below. The
+         * pixels with zero source alpha are kept intact to stay
+         * consistent with the scalar version.
+         */
+        const Vc::float_v new_alpha_rec = oneValue / new_alpha;
+        const Vc::float_m transparent = (new_alpha == zeroValue) || (src_alpha == zeroValue);
+
+        Vc::float_v result_c1 = composeSeparableChannel<BlendFunc>(src_c1, dst_c1, src_weight, dst_weight, blend_weight) * new_alpha_rec;
+        Vc::float_v result_c2 = composeSeparableChannel<BlendFunc>(src_c2, dst_c2, src_weight, dst_weight, blend_weight) * new_alpha_rec;
+        Vc::float_v result_c3 = composeSeparableChannel<BlendFunc>(src_c3, dst_c3, src_weight, dst_weight, blend_weight) * new_alpha_rec;
+
+        result_c1(transparent) = dst_c1;
+        result_c2(transparent) = dst_c2;
+        result_c3(transparent) = dst_c3;
+
+        dataDest[indexes] = tie(result_c1, result_c2, result_c3, new_alpha);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        using namespace KoStreamedMathFunctions;
+        const qint32 alpha_pos = 3;
+
+        const float *s = reinterpret_cast<const float*>(src);
+        float *d = reinterpret_cast<float*>(dst);
+
+        float srcAlpha = s[alpha_pos];
+        srcAlpha *= opacity;
+
+        if (haveMask) {
+            const float uint8Rec1 = 1.0 / 255;
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        const float dstAlpha = d[alpha_pos];
+
+        if (!allChannelsFlag && dstAlpha == 0.0) {
+            clearPixel<16>(dst);
+        }
+
+        if (srcAlpha == 0.0) return;
+
+        const QBitArray &channelFlags = oparams.channelFlags;
+
+        if (alphaLocked) {
+            if (dstAlpha == 0.0) return;
+
+            for (int i = 0; i < 3; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    d[i] = d[i] + (BlendFunc::apply(s[i], d[i]) - d[i]) * srcAlpha;
+                }
+            }
+        } else {
+            const float newAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha;
+
+            if (newAlpha != 0.0) {
+                const float srcWeight = srcAlpha * (1.0f - dstAlpha);
+                const float dstWeight = dstAlpha * (1.0f - srcAlpha);
+                const float blendWeight = srcAlpha * dstAlpha;
+                const float newAlphaRec = 1.0f / newAlpha;
+
+                for (int i = 0; i < 3; i++) {
+                    if (allChannelsFlag || channelFlags.at(i)) {
+                        d[i] = composeSeparableChannel<BlendFunc>(s[i], d[i], srcWeight, dstWeight, blendWeight) * newAlphaRec;
+                    }
+                }
+            }
+
+            d[alpha_pos] = newAlpha;
+        }
+    }
+};
+};
+
+/**
+ * A vectorized version of KoCompositeOpErase for 32-bit float
+ * colorspaces. The same as the original op, it ignores the channel
+ * flags.
+ */
+template<bool alphaLocked, bool allChannelsFlag>
+struct EraseCompositor128 {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const BlendPixel128 *sp = reinterpret_cast<const BlendPixel128*>(src);
+        BlendPixel128 *dp = reinterpret_cast<BlendPixel128*>(dst);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<BlendPixel128, Vc::float_v> data(const_cast<BlendPixel128*>(sp));
+
+        Vc::float_v src_alpha;
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+        tie(src_c1, src_c2, src_c3, src_alpha) = data[indexes];
+
+        src_alpha *= Vc::float_v(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255);
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_alpha;
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        Vc::InterleavedMemoryWrapper<BlendPixel128, Vc::float_v> dataDest(dp);
+        tie(dst_c1, dst_c2, dst_c3, dst_alpha) = dataDest[indexes];
+
+        dst_alpha *= oneValue - src_alpha;
+
+        dataDest[indexes] = tie(dst_c1, dst_c2, dst_c3, dst_alpha);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+        const qint32 alpha_pos = 3;
+
+        const float *s = reinterpret_cast<const float*>(src);
+        float *d = reinterpret_cast<float*>(dst);
+
+        float srcAlpha = s[alpha_pos];
+        srcAlpha *= opacity;
+
+        if (haveMask) {
+            const float uint8Rec1 = 1.0 / 255;
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (srcAlpha == 0.0) return;
+
+        d[alpha_pos] *= 1.0f - srcAlpha;
+    }
+};
+
+/**
+ * A vectorized version of KoCompositeOpCopy2 for 32-bit float
+ * colorspaces
+ */
+template<bool alphaLocked, bool allChannelsFlag>
+struct CopyCompositor128 {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const BlendPixel128 *sp = reinterpret_cast<const BlendPixel128*>(src);
+        BlendPixel128 *dp = reinterpret_cast<BlendPixel128*>(dst);
+
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v op(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1((float)1.0 / 255);
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            op *= mask_vec * uint8MaxRec1;
+        }
+
+        if ((op == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v src_alpha;
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<BlendPixel128, Vc::float_v> data(const_cast<BlendPixel128*>(sp));
+        tie(src_c1, src_c2, src_c3, src_alpha) = data[indexes];
+
+        Vc::float_v dst_alpha;
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        Vc::InterleavedMemoryWrapper<BlendPixel128, Vc::float_v> dataDest(dp);
+        tie(dst_c1, dst_c2, dst_c3, dst_alpha) = dataDest[indexes];
+
+        const Vc::float_v new_alpha = dst_alpha + (src_alpha - dst_alpha) * op;
+
+        const Vc::float_m copy_colors = (dst_alpha == zeroValue) || (op == oneValue);
+        const Vc::float_m keep_colors = (op == zeroValue) || (new_alpha == zeroValue);
+
+        // NaN's in the transparent pixels are masked out below
+        const Vc::float_v new_alpha_rec = oneValue / new_alpha;
+
+        const Vc::float_v dst_mult_c1 = dst_c1 * dst_alpha;
+        const Vc::float_v dst_mult_c2 = dst_c2 * dst_alpha;
+        const Vc::float_v dst_mult_c3 = dst_c3 * dst_alpha;
+
+        Vc::float_v result_c1 = (dst_mult_c1 + (src_c1 * src_alpha - dst_mult_c1) * op) * new_alpha_rec;
+        Vc::float_v result_c2 = (dst_mult_c2 + (src_c2 * src_alpha - dst_mult_c2) * op) * new_alpha_rec;
+        Vc::float_v result_c3 = (dst_mult_c3 + (src_c3 * src_alpha - dst_mult_c3) * op) * new_alpha_rec;
+
+        result_c1(keep_colors) = dst_c1;
+        result_c2(keep_colors) = dst_c2;
+        result_c3(keep_colors) = dst_c3;
+
+        result_c1(copy_colors) = src_c1;
+        result_c2(copy_colors) = src_c2;
+        result_c3(copy_colors) = src_c3;
+
+        dataDest[indexes] = tie(result_c1, result_c2, result_c3, new_alpha);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        const qint32 alpha_pos = 3;
+
+        const float *s = reinterpret_cast<const float*>(src);
+        float *d = reinterpret_cast<float*>(dst);
+
+        float op = opacity;
+
+        if (haveMask) {
+            const float uint8Rec1 = 1.0 / 255;
+            op *= float(*mask) * uint8Rec1;
+        }
+
+        const float srcAlpha = s[alpha_pos];
+        const float dstAlpha = d[alpha_pos];
+
+        if (!allChannelsFlag && dstAlpha == 0.0) {
+            KoStreamedMathFunctions::clearPixel<16>(dst);
+        }
+
+        if (op == 0.0) return;
+
+        const QBitArray &channelFlags = oparams.channelFlags;
+        const float newAlpha = dstAlpha + (srcAlpha - dstAlpha) * op;
+
+        if (dstAlpha == 0.0 || op == 1.0) {
+            for (int i = 0; i < 3; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    d[i] = s[i];
+                }
+            }
+        } else if (newAlpha != 0.0) {
+            const float newAlphaRec = 1.0f / newAlpha;
+
+            for (int i = 0; i < 3; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    const float dstMult = d[i] * dstAlpha;
+                    d[i] = (dstMult + (s[i] * srcAlpha - dstMult) * op) * newAlphaRec;
+                }
+            }
+        }
+
+        if (!alphaLocked) {
+            d[alpha_pos] = newAlpha;
+        }
+    }
+};
+
+/**
+ * An optimized version of the common separable blend modes, Erase and
+ * Copy for the use in 16 byte float colorspaces with alpha channel
+ * placed at the last channel of the pixel: C1_C2_C3_A.
+ *
+ * The mode is selected by \p id, see
+ * KoOptimizedCompositeOpFactory::supportsBlendOp() for the list
+ * of the supported ids.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpBlend128 : public KoCompositeOp
+{
+    typedef void (*CompositeFunc)(const KoCompositeOp::ParameterInfo&);
+
+public:
+    KoOptimizedCompositeOpBlend128(const KoColorSpace* cs, const QString &id, const QString &description, const QString &category)
+        : KoCompositeOp(cs, id, description, category),
+          m_ignoreChannelFlags(false)
+    {
+        using namespace KoStreamedMathFunctions;
+
+        if (id == COMPOSITE_MULT) {
+            initFunctions<GenericSCCompositor128<BlendMultiply<false> >::template Compositor>();
+        } else if (id == COMPOSITE_SCREEN) {
+            initFunctions<GenericSCCompositor128<BlendScreen<false> >::template Compositor>();
+        } else if (id == COMPOSITE_OVERLAY) {
+            initFunctions<GenericSCCompositor128<BlendOverlay<false> >::template Compositor>();
+        } else if (id == COMPOSITE_HARD_LIGHT) {
+            initFunctions<GenericSCCompositor128<BlendHardLight<false> >::template Compositor>();
+        } else if (id == COMPOSITE_ADD || id == COMPOSITE_LINEAR_DODGE) {
+            initFunctions<GenericSCCompositor128<BlendAddition<false> >::template Compositor>();
+        } else if (id == COMPOSITE_DARKEN) {
+            initFunctions<GenericSCCompositor128<BlendDarken<false> >::template Compositor>();
+        } else if (id == COMPOSITE_LIGHTEN) {
+            initFunctions<GenericSCCompositor128<BlendLighten<false> >::template Compositor>();
+        } else if (id == COMPOSITE_DODGE) {
+            initFunctions<GenericSCCompositor128<BlendColorDodge<false> >::template Compositor>();
+        } else if (id == COMPOSITE_BURN) {
+            initFunctions<GenericSCCompositor128<BlendColorBurn<false> >::template Compositor>();
+        } else if (id == COMPOSITE_ERASE) {
+            initFunctions<EraseCompositor128>();
+            m_ignoreChannelFlags = true;
+        } else if (id == COMPOSITE_COPY) {
+            initFunctions<CopyCompositor128>();
+        } else {
+            qFatal("KoOptimizedCompositeOpBlend128: unsupported composite op id: %s", id.toLatin1().constData());
+        }
+    }
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        const int maskIndex = params.maskRowStart ? 1 : 0;
+
+        if (m_ignoreChannelFlags ||
+            params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            m_functions[maskIndex][AllChannels](params);
+        } else {
+            const bool allChannelsFlag =
+                params.channelFlags.at(0) &&
+                params.channelFlags.at(1) &&
+                params.channelFlags.at(2);
+
+            const bool alphaLocked =
+                !params.channelFlags.at(3);
+
+            if (allChannelsFlag && alphaLocked) {
+                m_functions[maskIndex][AlphaLocked](params);
+            } else if (!allChannelsFlag && !alphaLocked) {
+                m_functions[maskIndex][SomeChannels](params);
+            } else /*if (!allChannelsFlag && alphaLocked) */{
+                m_functions[maskIndex][SomeChannelsAlphaLocked](params);
+            }
+        }
+    }
+
+private:
+    enum ChannelsMode {
+        AllChannels = 0,
+        AlphaLocked,
+        SomeChannels,
+        SomeChannelsAlphaLocked,
+        NumChannelsModes
+    };
+
+    template<template<bool alphaLocked, bool allChannelsFlag> class Compositor>
+    void initFunctions() {
+        m_functions[0][AllChannels] = &KoStreamedMath<_impl>::template genericComposite128<false, false, Compositor<false, true> >;
+        m_functions[1][AllChannels] = &KoStreamedMath<_impl>::template genericComposite128<true, false, Compositor<false, true> >;
+
+        m_functions[0][AlphaLocked] = &KoStreamedMath<_impl>::template genericComposite128_novector<false, false, Compositor<true, true> >;
+        m_functions[1][AlphaLocked] = &KoStreamedMath<_impl>::template genericComposite128_novector<true, false, Compositor<true, true> >;
+
+        m_functions[0][SomeChannels] = &KoStreamedMath<_impl>::template genericComposite128_novector<false, false, Compositor<false, false> >;
+        m_functions[1][SomeChannels] = &KoStreamedMath<_impl>::template genericComposite128_novector<true, false, Compositor<false, false> >;
+
+        m_functions[0][SomeChannelsAlphaLocked] = &KoStreamedMath<_impl>::template genericComposite128_novector<false, false, Compositor<true, false> >;
+        m_functions[1][SomeChannelsAlphaLocked] = &KoStreamedMath<_impl>::template genericComposite128_novector<true, false, Compositor<true, false> >;
+    }
+
+private:
+    CompositeFunc m_functions[2][NumChannelsModes];
+    bool m_ignoreChannelFlags;
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPBLEND128_H_
@@ -0,0 +1,486 @@
+/*
+ *  Copyright (c) 2017 Krita Developers <kimageshop@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPBLEND32_H_
+#define KOOPTIMIZEDCOMPOSITEOPBLEND32_H_
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+
+/**
+ * A vectorized version of KoCompositeOpGenericSC for 8-bit colorspaces.
+ * All the math is done in normalized floats, so the results may differ
+ * from the ones of the integer version by a rounding error.
+ */
+template<class BlendFunc>
+struct GenericSCCompositor32 {
+template<bool alphaLocked, bool allChannelsFlag>
+struct Compositor {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+        using namespace KoStreamedMathFunctions;
+
+        const Vc::float_v uint8Max((float)255.0);
+        const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<src_aligned>(src);
+        src_alpha *= Vc::float_v(opacity) * uint8MaxRec1;
+
+        if (haveMask) {
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        // The source cannot change the colors in the destination,
+        // since its fully transparent
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<true>(dst);
+        dst_alpha *= uint8MaxRec1;
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        KoStreamedMath<_impl>::template fetch_colors_32<src_aligned>(src, src_c1, src_c2, src_c3);
+        KoStreamedMath<_impl>::template fetch_colors_32<true>(dst, dst_c1, dst_c2, dst_c3);
+
+        src_c1 *= uint8MaxRec1;
+        src_c2 *= uint8MaxRec1;
+        src_c3 *= uint8MaxRec1;
+
+        dst_c1 *= uint8MaxRec1;
+        dst_c2 *= uint8MaxRec1;
+        dst_c3 *= uint8MaxRec1;
+
+        const Vc::float_v new_alpha = src_alpha + dst_alpha - src_alpha * dst_alpha;
+        const Vc::float_v src_weight = src_alpha * (oneValue - dst_alpha);
+        const Vc::float_v dst_weight = dst_alpha * (oneValue - src_alpha);
+        const Vc::float_v blend_weight = src_alpha * dst_alpha;
+
+        /**
+         * The pixels with zero new_alpha will get NaN's here, but
+         * they are replaced with the original destination values
+         * below, so it is safe. The pixels with zero source alpha
+         * are kept intact to stay consistent with the scalar version.
+         */
+        const Vc::float_v new_alpha_scale = uint8Max / new_alpha;
+        const Vc::float_m transparent = (new_alpha == zeroValue) || (src_alpha == zeroValue);
+
+        Vc::float_v result_c1 = composeSeparableChannel<BlendFunc>(src_c1, dst_c1, src_weight, dst_weight, blend_weight) * new_alpha_scale;
+        Vc::float_v result_c2 = composeSeparableChannel<BlendFunc>(src_c2, dst_c2, src_weight, dst_weight, blend_weight) * new_alpha_scale;
+        Vc::float_v result_c3 = composeSeparableChannel<BlendFunc>(src_c3, dst_c3, src_weight, dst_weight, blend_weight) * new_alpha_scale;
+
+        result_c1(transparent) = dst_c1 * uint8Max;
+        result_c2(transparent) = dst_c2 * uint8Max;
+        result_c3(transparent) = dst_c3 * uint8Max;
+
+        KoStreamedMath<_impl>::write_channels_32(dst, new_alpha * uint8Max, result_c1, result_c2, result_c3);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        using namespace KoStreamedMathFunctions;
+        const qint32 alpha_pos = 3;
+
+        const float uint8Max = 255.0;
+        const float uint8Rec1 = 1.0 / 255.0;
+
+        float srcAlpha = float(src[alpha_pos]);
+        srcAlpha *= opacity * uint8Rec1;
+
+        if (haveMask) {
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        const float dstAlpha = float(dst[alpha_pos]) * uint8Rec1;
+
+        if (!allChannelsFlag && dstAlpha == 0.0) {
+            clearPixel<4>(dst);
+        }
+
+        if (srcAlpha == 0.0) return;
+
+        const QBitArray &channelFlags = oparams.channelFlags;
+
+        if (alphaLocked) {
+            if (dstAlpha == 0.0) return;
+
+            for (int i = 0; i < 3; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    const float s = float(src[i]) * uint8Rec1;
+                    const float d = float(dst[i]) * uint8Rec1;
+                    const float result = d + (BlendFunc::apply(s, d) - d) * srcAlpha;
+
+                    dst[i] = KoStreamedMath<_impl>::round_float_to_uint(result * uint8Max);
+                }
+            }
+        } else {
+            const float newAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha;
+
+            if (newAlpha != 0.0) {
+                const float srcWeight = srcAlpha * (1.0f - dstAlpha);
+                const float dstWeight = dstAlpha * (1.0f - srcAlpha);
+                const float blendWeight = srcAlpha * dstAlpha;
+                const float newAlphaScale = uint8Max / newAlpha;
+
+                for (int i = 0; i < 3; i++) {
+                    if (allChannelsFlag || channelFlags.at(i)) {
+                        const float s = float(src[i]) * uint8Rec1;
+                        const float d = float(dst[i]) * uint8Rec1;
+                        const float result = composeSeparableChannel<BlendFunc>(s, d, srcWeight, dstWeight, blendWeight);
+
+                        dst[i] = KoStreamedMath<_impl>::round_float_to_uint(result * newAlphaScale);
+                    }
+                }
+            }
+
+            dst[alpha_pos] = KoStreamedMath<_impl>::round_float_to_uint(newAlpha * uint8Max);
+        }
+    }
+};
+};
+
+/**
+ * A vectorized version of KoCompositeOpErase for 8-bit colorspaces.
+ * The same as the original op, it ignores the channel flags.
+ */
+template<bool alphaLocked, bool allChannelsFlag>
+struct EraseCompositor32 {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+        {
+            Q_UNUSED(params);
+        }
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+        typedef typename KoStreamedMath<_impl>::int_v int_v;
+        typedef typename KoStreamedMath<_impl>::uint_v uint_v;
+
+        const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v src_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<src_aligned>(src);
+        src_alpha *= Vc::float_v(opacity) * uint8MaxRec1;
+
+        if (haveMask) {
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            src_alpha *= mask_vec * uint8MaxRec1;
+        }
+
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        uint_v dst_i;
+        dst_i.load((const quint32*)dst, Vc::Aligned);
+
+        const Vc::float_v dst_alpha = Vc::float_v(int_v(dst_i >> 24));
+        const Vc::float_v new_alpha = dst_alpha * (oneValue - src_alpha);
+
+        const uint_v colorMask(0x00FFFFFF);
+        dst_i = (dst_i & colorMask) | (uint_v(int_v(Vc::round(new_alpha))) << 24);
+        dst_i.store((quint32*)dst, Vc::Aligned);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+        const qint32 alpha_pos = 3;
+        const float uint8Rec1 = 1.0 / 255.0;
+
+        float srcAlpha = float(src[alpha_pos]);
+        srcAlpha *= opacity * uint8Rec1;
+
+        if (haveMask) {
+            srcAlpha *= float(*mask) * uint8Rec1;
+        }
+
+        if (srcAlpha == 0.0) return;
+
+        const float newAlpha = float(dst[alpha_pos]) * (1.0f - srcAlpha);
+        dst[alpha_pos] = KoStreamedMath<_impl>::round_float_to_uint(newAlpha);
+    }
+};
+
+/**
+ * A vectorized version of KoCompositeOpCopy2 for 8-bit colorspaces
+ */
+template<bool alphaLocked, bool allChannelsFlag>
+struct CopyCompositor32 {
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params)
+            : channelFlags(params.channelFlags)
+        {
+        }
+        const QBitArray &channelFlags;
+    };
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        const Vc::float_v uint8Max((float)255.0);
+        const Vc::float_v uint8MaxRec1((float)1.0 / 255.0);
+        const Vc::float_v zeroValue(Vc::Zero);
+        const Vc::float_v oneValue(Vc::One);
+
+        Vc::float_v op(opacity);
+
+        if (haveMask) {
+            Vc::float_v mask_vec = KoStreamedMath<_impl>::fetch_mask_8(mask);
+            op *= mask_vec * uint8MaxRec1;
+        }
+
+        if ((op == zeroValue).isFull()) {
+            return;
+        }
+
+        const Vc::float_v src_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<src_aligned>(src);
+        const Vc::float_v dst_alpha = KoStreamedMath<_impl>::template fetch_alpha_32<true>(dst);
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+
+        KoStreamedMath<_impl>::template fetch_colors_32<src_aligned>(src, src_c1, src_c2, src_c3);
+        KoStreamedMath<_impl>::template fetch_colors_32<true>(dst, dst_c1, dst_c2, dst_c3);
+
+        const Vc::float_v new_alpha = dst_alpha + (src_alpha - dst_alpha) * op;
+
+        const Vc::float_m copy_colors = (dst_alpha == zeroValue) || (op == oneValue);
+        const Vc::float_m keep_colors = (op == zeroValue) || (new_alpha == zeroValue);
+
+        // NaN's in the transparent pixels are masked out below
+        const Vc::float_v new_alpha_rec = oneValue / new_alpha;
+
+        const Vc::float_v dst_mult_c1 = dst_c1 * dst_alpha;
+        const Vc::float_v dst_mult_c2 = dst_c2 * dst_alpha;
+        const Vc::float_v dst_mult_c3 = dst_c3 * dst_alpha;
+
+        Vc::float_v result_c1 = (dst_mult_c1 + (src_c1 * src_alpha - dst_mult_c1) * op) * new_alpha_rec;
+        Vc::float_v result_c2 = (dst_mult_c2 + (src_c2 * src_alpha - dst_mult_c2) * op) * new_alpha_rec;
+        Vc::float_v result_c3 = (dst_mult_c3 + (src_c3 * src_alpha - dst_mult_c3) * op) * new_alpha_rec;
+
+        result_c1 = Vc::min(result_c1, uint8Max);
+        result_c2 = Vc::min(result_c2, uint8Max);
+        result_c3 = Vc::min(result_c3, uint8Max);
+
+        result_c1(keep_colors) = dst_c1;
+        result_c2(keep_colors) = dst_c2;
+        result_c3(keep_colors) = dst_c3;
+
+        result_c1(copy_colors) = src_c1;
+        result_c2(copy_colors) = src_c2;
+        result_c3(copy_colors) = src_c3;
+
+        KoStreamedMath<_impl>::write_channels_32(dst, new_alpha, result_c1, result_c2, result_c3);
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        const qint32 alpha_pos = 3;
+        const float uint8Max = 255.0;
+        const float uint8Rec1 = 1.0 / 255.0;
+
+        float op = opacity;
+
+        if (haveMask) {
+            op *= float(*mask) * uint8Rec1;
+        }
+
+        const float srcAlpha = src[alpha_pos];
+        const float dstAlpha = dst[alpha_pos];
+
+        if (!allChannelsFlag && dstAlpha == 0.0) {
+            KoStreamedMathFunctions::clearPixel<4>(dst);
+        }
+
+        if (op == 0.0) return;
+
+        const QBitArray &channelFlags = oparams.channelFlags;
+        const float newAlpha = dstAlpha + (srcAlpha - dstAlpha) * op;
+
+        if (dstAlpha == 0.0 || op == 1.0) {
+            for (int i = 0; i < 3; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    dst[i] = src[i];
+                }
+            }
+        } else if (newAlpha != 0.0) {
+            const float newAlphaRec = 1.0f / newAlpha;
+
+            for (int i = 0; i < 3; i++) {
+                if (allChannelsFlag || channelFlags.at(i)) {
+                    const float dstMult = float(dst[i]) * dstAlpha;
+                    const float result = (dstMult + (float(src[i]) * srcAlpha - dstMult) * op) * newAlphaRec;
+
+                    dst[i] = KoStreamedMath<_impl>::round_float_to_uint(qMin(result, uint8Max));
+                }
+            }
+        }
+
+        if (!alphaLocked) {
+            dst[alpha_pos] = KoStreamedMath<_impl>::round_float_to_uint(newAlpha);
+        }
+    }
+};
+
+/**
+ * An optimized version of the common separable blend modes, Erase and
+ * Copy for the use in 4 byte colorspaces with alpha channel placed at
+ * the last byte of the pixel: C1_C2_C3_A.
+ *
+ * The mode is selected by \p id, see
+ * KoOptimizedCompositeOpFactory::supportsBlendOp() for the list
+ * of the supported ids.
+ */
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpBlend32 : public KoCompositeOp
+{
+    typedef void (*CompositeFunc)(const KoCompositeOp::ParameterInfo&);
+
+public:
+    KoOptimizedCompositeOpBlend32(const KoColorSpace* cs, const QString &id, const QString &description, const QString &category)
+        : KoCompositeOp(cs, id, description, category),
+          m_ignoreChannelFlags(false)
+    {
+        using namespace KoStreamedMathFunctions;
+
+        if (id == COMPOSITE_MULT) {
+            initFunctions<GenericSCCompositor32<BlendMultiply<true> >::template Compositor>();
+        } else if (id == COMPOSITE_SCREEN) {
+            initFunctions<GenericSCCompositor32<BlendScreen<true> >::template Compositor>();
+        } else if (id == COMPOSITE_OVERLAY) {
+            initFunctions<GenericSCCompositor32<BlendOverlay<true> >::template Compositor>();
+        } else if (id == COMPOSITE_HARD_LIGHT) {
+            initFunctions<GenericSCCompositor32<BlendHardLight<true> >::template Compositor>();
+        } else if (id == COMPOSITE_ADD || id == COMPOSITE_LINEAR_DODGE) {
+            initFunctions<GenericSCCompositor32<BlendAddition<true> >::template Compositor>();
+        } else if (id == COMPOSITE_DARKEN) {
+            initFunctions<GenericSCCompositor32<BlendDarken<true> >::template Compositor>();
+        } else if (id == COMPOSITE_LIGHTEN) {
+            initFunctions<GenericSCCompositor32<BlendLighten<true> >::template Compositor>();
+        } else if (id == COMPOSITE_DODGE) {
+            initFunctions<GenericSCCompositor32<BlendColorDodge<true> >::template Compositor>();
+        } else if (id == COMPOSITE_BURN) {
+            initFunctions<GenericSCCompositor32<BlendColorBurn<true> >::template Compositor>();
+        } else if (id == COMPOSITE_ERASE) {
+            initFunctions<EraseCompositor32>();
+            m_ignoreChannelFlags = true;
+        } else if (id == COMPOSITE_COPY) {
+            initFunctions<CopyCompositor32>();
+        } else {
+            qFatal("KoOptimizedCompositeOpBlend32: unsupported composite op id: %s", id.toLatin1().constData());
+        }
+    }
+
+    using KoCompositeOp::composite;
+
+    virtual void composite(const KoCompositeOp::ParameterInfo& params) const
+    {
+        const int maskIndex = params.maskRowStart ? 1 : 0;
+
+        if (m_ignoreChannelFlags ||
+            params.channelFlags.isEmpty() ||
+            params.channelFlags == QBitArray(4, true)) {
+
+            m_functions[maskIndex][AllChannels](params);
+        } else {
+            const bool allChannelsFlag =
+                params.channelFlags.at(0) &&
+                params.channelFlags.at(1) &&
+                params.channelFlags.at(2);
+
+            const bool alphaLocked =
+                !params.channelFlags.at(3);
+
+            if (allChannelsFlag && alphaLocked) {
+                m_functions[maskIndex][AlphaLocked](params);
+            } else if (!allChannelsFlag && !alphaLocked) {
+                m_functions[maskIndex][SomeChannels](params);
+            } else /*if (!allChannelsFlag && alphaLocked) */{
+                m_functions[maskIndex][SomeChannelsAlphaLocked](params);
+            }
+        }
+    }
+
+private:
+    enum ChannelsMode {
+        AllChannels = 0,
+        AlphaLocked,
+        SomeChannels,
+        SomeChannelsAlphaLocked,
+        NumChannelsModes
+    };
+
+    template<template<bool alphaLocked, bool allChannelsFlag> class Compositor>
+    void initFunctions() {
+        m_functions[0][AllChannels] = &KoStreamedMath<_impl>::template genericComposite32<false, false, Compositor<false, true> >;
+        m_functions[1][AllChannels] = &KoStreamedMath<_impl>::template genericComposite32<true, false, Compositor<false, true> >;
+
+        m_functions[0][AlphaLocked] = &KoStreamedMath<_impl>::template genericComposite32_novector<false, false, Compositor<true, true> >;
+        m_functions[1][AlphaLocked] = &KoStreamedMath<_impl>::template genericComposite32_novector<true, false, Compositor<true, true> >;
+
+        m_functions[0][SomeChannels] = &KoStreamedMath<_impl>::template genericComposite32_novector<false, false, Compositor<false, false> >;
+        m_functions[1][SomeChannels] = &KoStreamedMath<_impl>::template genericComposite32_novector<true, false, Compositor<false, false> >;
+
+        m_functions[0][SomeChannelsAlphaLocked] = &KoStreamedMath<_impl>::template genericComposite32_novector<false, false, Compositor<true, false> >;
+        m_functions[1][SomeChannelsAlphaLocked] = &KoStreamedMath<_impl>::template genericComposite32_novector<true, false, Compositor<true, false> >;
+    }
+
+private:
+    CompositeFunc m_functions[2][NumChannelsModes];
+    bool m_ignoreChannelFlags;
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPBLEND32_H_
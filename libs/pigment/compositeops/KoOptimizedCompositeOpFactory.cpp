@@ -20,6 +20,8 @@
 #include "KoOptimizedCompositeOpFactoryPerArch.h" // vc.h must come first
 #include "KoOptimizedCompositeOpFactory.h"
 
+#include <KoCompositeOpRegistry.h>
+
 #if defined(__clang__)
 #pragma GCC diagnostic ignored "-Wundef"
 #endif
@@ -35,6 +37,16 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp32(const KoColorSpace
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32> >(cs);
 }
 
+KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64> >(cs);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp64(const KoColorSpace *cs)
+{
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64> >(cs);
+}
+
 KoCompositeOp* KoOptimizedCompositeOpFactory::createAlphaDarkenOp128(const KoColorSpace *cs)
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken128> >(cs);
@@ -44,3 +56,31 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp128(const KoColorSpace
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128> >(cs);
 }
+
+bool KoOptimizedCompositeOpFactory::supportsBlendOp(const QString &id)
+{
+    return id == COMPOSITE_MULT ||
+        id == COMPOSITE_SCREEN ||
+        id == COMPOSITE_OVERLAY ||
+        id == COMPOSITE_HARD_LIGHT ||
+        id == COMPOSITE_ADD ||
+        id == COMPOSITE_LINEAR_DODGE ||
+        id == COMPOSITE_DARKEN ||
+        id == COMPOSITE_LIGHTEN ||
+        id == COMPOSITE_DODGE ||
+        id == COMPOSITE_BURN ||
+        id == COMPOSITE_ERASE ||
+        id == COMPOSITE_COPY;
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createBlendOp32(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category)
+{
+    KoOptimizedBlendOpParams params = {cs, id, description, category};
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBlend32, KoOptimizedBlendOpParams> >(params);
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createBlendOp128(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category)
+{
+    KoOptimizedBlendOpParams params = {cs, id, description, category};
+    return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBlend128, KoOptimizedBlendOpParams> >(params);
+}
@@ -22,6 +22,7 @@
 
 #include "kritapigment_export.h"
 
+class QString;
 class KoCompositeOp;
 class KoColorSpace;
 
@@ -42,8 +43,21 @@ class KRITAPIGMENT_EXPORT KoOptimizedCompositeOpFactory
 public:
     static KoCompositeOp* createAlphaDarkenOp32(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp32(const KoColorSpace *cs);
+    static KoCompositeOp* createAlphaDarkenOp64(const KoColorSpace *cs);
+    static KoCompositeOp* createOverOp64(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOp128(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp128(const KoColorSpace *cs);
+
+    /**
+     * Returns true if there is an optimized version of the composite
+     * op with \p id that can be created with createBlendOp32() and
+     * createBlendOp128(). These are the most popular separable blend
+     * modes, Erase and Copy.
+     */
+    static bool supportsBlendOp(const QString &id);
+
+    static KoCompositeOp* createBlendOp32(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
+    static KoCompositeOp* createBlendOp128(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
 };
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORY_H */
@@ -23,6 +23,7 @@
 
 #include <compositeops/KoVcMultiArchBuildSupport.h>
 
+#include <QString>
 
 class KoCompositeOp;
 class KoColorSpace;
@@ -34,16 +35,40 @@ class KoOptimizedCompositeOpAlphaDarken32;
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpOver32;
 
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpAlphaDarken64;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpOver64;
+
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpAlphaDarken128;
 
 template<Vc::Implementation _impl>
 class KoOptimizedCompositeOpOver128;
 
-template<template<Vc::Implementation I> class CompositeOp>
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpBlend32;
+
+template<Vc::Implementation _impl>
+class KoOptimizedCompositeOpBlend128;
+
+/**
+ * The blend ops implement several composite ops at once, so they
+ * need to know which one should be created
+ */
+struct KoOptimizedBlendOpParams
+{
+    const KoColorSpace *colorSpace;
+    QString id;
+    QString description;
+    QString category;
+};
+
+template<template<Vc::Implementation I> class CompositeOp, typename Param = const KoColorSpace*>
 struct KoOptimizedCompositeOpFactoryPerArch
 {
-    typedef const KoColorSpace* ParamType;
+    typedef Param ParamType;
     typedef KoCompositeOp* ReturnType;
 
     template<Vc::Implementation _impl>
@@ -22,7 +22,7 @@
 #include "KoColorSpaceTraits.h"
 #include "KoCompositeOpAlphaDarken.h"
 #include "KoCompositeOpOver.h"
-
+#include "KoGenericBlendOpFactory.h"
 
 template<>
 template<>
@@ -40,6 +40,22 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver32>::create<Vc::S
     return new KoCompositeOpOver<KoBgrU8Traits>(param);
 }
 
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpAlphaDarken<KoBgrU16Traits>(param);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver64>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return new KoCompositeOpOver<KoBgrU16Traits>(param);
+}
+
 template<>
 template<>
 KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpAlphaDarken128>::ReturnType
@@ -55,3 +71,19 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoCompositeOpOver<KoRgbF32Traits>(param);
 }
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBlend32, KoOptimizedBlendOpParams>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBlend32, KoOptimizedBlendOpParams>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return createGenericBlendOp<KoBgrU8Traits>(param.colorSpace, param.id, param.description, param.category);
+}
+
+template<>
+template<>
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBlend128, KoOptimizedBlendOpParams>::ReturnType
+KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpBlend128, KoOptimizedBlendOpParams>::create<Vc::ScalarImpl>(ParamType param)
+{
+    return createGenericBlendOp<KoRgbF32Traits>(param.colorSpace, param.id, param.description, param.category);
+}
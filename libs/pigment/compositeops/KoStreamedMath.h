@@ -96,6 +96,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite_novector<useMask, useFlow, Compositor, 4>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64_novector(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite_novector<useMask, useFlow, Compositor, 8>(params);
+}
+
 template<bool useMask, bool useFlow, class Compositor>
     static void genericComposite128_novector(const KoCompositeOp::ParameterInfo& params)
 {
@@ -106,10 +112,18 @@ static inline quint8 round_float_to_uint(float value) {
     return quint8(value + float(0.5));
 }
 
+static inline quint16 round_float_to_u16(float value) {
+    return quint16(value + float(0.5));
+}
+
 static inline quint8 lerp_mixed_u8_float(quint8 a, quint8 b, float alpha) {
     return round_float_to_uint(qint16(b - a) * alpha + a);
 }
 
+static inline quint16 lerp_mixed_u16_float(quint16 a, quint16 b, float alpha) {
+    return round_float_to_u16(qint32(b - a) * alpha + a);
+}
+
 /**
  * Get a vector containing first Vc::float_v::size() values of mask.
  * Each source mask element is considered to be a 8-bit integer
@@ -208,6 +222,59 @@ static inline void write_channels_32(quint8 *data,
     (v1 | v3).store((quint32*)data, Vc::Aligned);
 }
 
+/**
+ * Get color and alpha values from Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The channels are returned in the
+ * order they are stored in memory, the alpha channel is expected to be
+ * the last one.
+ *
+ * There is no deinterleaving load for 16-bit channels, so every pixel
+ * is fetched as a pair of 32-bit words with a gather instruction. The
+ * gather does not depend on the alignment of the \p data.
+ */
+static inline void fetch_channels_64(const quint8 *data,
+                                     Vc::float_v &c1,
+                                     Vc::float_v &c2,
+                                     Vc::float_v &c3,
+                                     Vc::float_v &alpha) {
+    const quint32 *ptr = reinterpret_cast<const quint32*>(data);
+    const int_v lowWordIndexes = int_v::IndexesFromZero() * 2;
+
+    uint_v low(ptr, lowWordIndexes);
+    uint_v high(ptr, lowWordIndexes + 1);
+
+    const uint_v mask(0xFFFF);
+
+    c1 = Vc::float_v(int_v(low & mask));
+    c2 = Vc::float_v(int_v(low >> 16));
+    c3 = Vc::float_v(int_v(high & mask));
+    alpha = Vc::float_v(int_v(high >> 16));
+}
+
+/**
+ * Pack color and alpha values to Vc::float_v::size() pixels 64-bit each
+ * (4 channels, 16 bit per channel). The layout is the same as in
+ * fetch_channels_64().
+ */
+static inline void write_channels_64(quint8 *data,
+                                     Vc::float_v::AsArg alpha,
+                                     Vc::float_v::AsArg c1,
+                                     Vc::float_v::AsArg c2,
+                                     Vc::float_v::AsArg c3) {
+    quint32 *ptr = reinterpret_cast<quint32*>(data);
+    const int_v lowWordIndexes = int_v::IndexesFromZero() * 2;
+
+    const uint_v mask(0xFFFF);
+
+    uint_v low = (uint_v(int_v(Vc::round(c1))) & mask) |
+        (uint_v(int_v(Vc::round(c2))) << 16);
+    uint_v high = (uint_v(int_v(Vc::round(c3))) & mask) |
+        (uint_v(int_v(Vc::round(alpha))) << 16);
+
+    low.scatter(ptr, lowWordIndexes);
+    high.scatter(ptr, lowWordIndexes + 1);
+}
+
 /**
  * Composes src pixels into dst pixles. Is optimized for 32-bit-per-pixel
  * colorspaces. Uses \p Compositor strategy parameter for doing actual
@@ -375,6 +442,12 @@ template<bool useMask, bool useFlow, class Compositor>
     genericComposite<useMask, useFlow, Compositor, 4>(params);
 }
 
+template<bool useMask, bool useFlow, class Compositor>
+    static void genericComposite64(const KoCompositeOp::ParameterInfo& params)
+{
+    genericComposite<useMask, useFlow, Compositor, 8>(params);
+}
+
 template<bool useMask, bool useFlow, class Compositor>
     static void genericComposite128(const KoCompositeOp::ParameterInfo& params)
 {
@@ -395,6 +468,13 @@ ALWAYS_INLINE void clearPixel<4>(quint8* dst)
     *d = 0;
 }
 
+template<>
+ALWAYS_INLINE void clearPixel<8>(quint8* dst)
+{
+    quint64 *d = reinterpret_cast<quint64*>(dst);
+    *d = 0;
+}
+
 template<>
 ALWAYS_INLINE void clearPixel<16>(quint8* dst)
 {
@@ -414,6 +494,14 @@ ALWAYS_INLINE void copyPixel<4>(const quint8 *src, quint8* dst)
     *d = *s;
 }
 
+template<>
+ALWAYS_INLINE void copyPixel<8>(const quint8 *src, quint8* dst)
+{
+    const quint64 *s = reinterpret_cast<const quint64*>(src);
+    quint64 *d = reinterpret_cast<quint64*>(dst);
+    *d = *s;
+}
+
 template<>
 ALWAYS_INLINE void copyPixel<16>(const quint8 *src, quint8* dst)
 {
@@ -422,6 +510,163 @@ ALWAYS_INLINE void copyPixel<16>(const quint8 *src, quint8* dst)
     d[0] = s[0];
     d[1] = s[1];
 }
+
+/**
+ * The helpers below let the blending functions be written only once
+ * for both, scalar (float) and vector (Vc::float_v) arguments. Please
+ * note that in the vector version both the branches of select() are
+ * evaluated, so they must not have any side effects.
+ */
+
+ALWAYS_INLINE float select(bool condition, float a, float b)
+{
+    return condition ? a : b;
+}
+
+ALWAYS_INLINE Vc::float_v select(const Vc::float_m &condition, Vc::float_v::AsArg a, Vc::float_v::AsArg b)
+{
+    Vc::float_v result = b;
+    result(condition) = a;
+    return result;
+}
+
+ALWAYS_INLINE float minValue(float a, float b)
+{
+    return qMin(a, b);
+}
+
+ALWAYS_INLINE Vc::float_v minValue(Vc::float_v::AsArg a, Vc::float_v::AsArg b)
+{
+    return Vc::min(a, b);
+}
+
+ALWAYS_INLINE float maxValue(float a, float b)
+{
+    return qMax(a, b);
+}
+
+ALWAYS_INLINE Vc::float_v maxValue(Vc::float_v::AsArg a, Vc::float_v::AsArg b)
+{
+    return Vc::max(a, b);
+}
+
+/**
+ * Integer colorspaces clamp the result of the blending function
+ * into the [0...1] range, floating point ones keep it as it is
+ */
+template<bool clampToUnit, class T>
+ALWAYS_INLINE T clampBlendResult(const T &value)
+{
+    return clampToUnit ? maxValue(minValue(value, T(1.0f)), T(0.0f)) : value;
+}
+
+/**
+ * Vectorizable versions of the separable blending functions from
+ * KoCompositeOpFunctions.h. All the values are normalized, that is
+ * the unit value is 1.0 for all the colorspaces.
+ */
+
+template<bool clampToUnit>
+struct BlendMultiply {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        return src * dst;
+    }
+};
+
+template<bool clampToUnit>
+struct BlendScreen {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        return src + dst - src * dst;
+    }
+};
+
+template<bool clampToUnit>
+struct BlendHardLight {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        const T src2 = src + src;
+        const T src2m1 = src2 - T(1.0f);
+
+        return select(src > T(0.5f),
+                      src2m1 + dst - src2m1 * dst,
+                      clampBlendResult<clampToUnit>(src2 * dst));
+    }
+};
+
+template<bool clampToUnit>
+struct BlendOverlay {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        return BlendHardLight<clampToUnit>::apply(dst, src);
+    }
+};
+
+template<bool clampToUnit>
+struct BlendAddition {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        return clampBlendResult<clampToUnit>(src + dst);
+    }
+};
+
+template<bool clampToUnit>
+struct BlendDarken {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        return minValue(src, dst);
+    }
+};
+
+template<bool clampToUnit>
+struct BlendLighten {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        return maxValue(src, dst);
+    }
+};
+
+template<bool clampToUnit>
+struct BlendColorDodge {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        const T invSrc = T(1.0f) - src;
+
+        return select(dst == T(0.0f), T(0.0f),
+                      select(invSrc < dst, T(1.0f),
+                             clampBlendResult<clampToUnit>(dst / invSrc)));
+    }
+};
+
+template<bool clampToUnit>
+struct BlendColorBurn {
+    template<class T>
+    static ALWAYS_INLINE T apply(const T &src, const T &dst) {
+        const T invDst = T(1.0f) - dst;
+
+        return select(dst == T(1.0f), T(1.0f),
+                      select(src < invDst, T(0.0f),
+                             T(1.0f) - clampBlendResult<clampToUnit>(invDst / src)));
+    }
+};
+
+/**
+ * Composes a single color channel the same way KoCompositeOpGenericSC
+ * does, but without the final division by the new alpha value.
+ * The weights are:
+ *
+ * srcWeight = srcAlpha * (1 - dstAlpha)
+ * dstWeight = dstAlpha * (1 - srcAlpha)
+ * blendWeight = srcAlpha * dstAlpha
+ */
+template<class BlendFunc, class T>
+ALWAYS_INLINE T composeSeparableChannel(const T &src, const T &dst,
+                                        const T &srcWeight, const T &dstWeight,
+                                        const T &blendWeight)
+{
+    return src * srcWeight + dst * dstWeight + BlendFunc::apply(src, dst) * blendWeight;
+}
 }
 
 #endif /* __KOSTREAMED_MATH_H */
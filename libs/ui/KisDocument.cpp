@@ -89,6 +89,8 @@
 #include <kis_painting_assistants_decoration.h>
 #include <kis_idle_watcher.h>
 #include <kis_signal_auto_connection.h>
+#include <kis_layer_utils.h>
+#include <tiles3/kis_compressed_tiles_cache.h>
 #include <kis_debug.h>
 #include <kis_canvas_widget_base.h>
 
@@ -352,6 +354,22 @@ public:
 
     StdLockableWrapper<QMutex> savingLock;
 
+    bool isSavingSnapshot {false};
+    bool modifiedDuringSnapshotSaving {false};
+
+    /**
+     * The state of the document saved together with savingImage. It
+     * is copied in prepareLocksForSaving() in the GUI thread, because
+     * the saver may run in a background thread.
+     */
+    vKisNodeSP savingActiveNodes;
+    QList<KisPaintingAssistantSP> savingAssistants;
+    KisGridConfig savingGridConfig;
+    KisGuidesConfig savingGuidesConfig;
+    QScopedPointer<KoDocumentInfo> savingDocInfo;
+
+    QScopedPointer<KisCompressedTilesCache> autosaveTilesCache;
+
     void setImageAndInitIdleWatcher(KisImageSP _image) {
         image = _image;
 
@@ -477,6 +495,12 @@ KisDocument::~KisDocument()
     d->autoSaveTimer.disconnect(this);
     d->autoSaveTimer.stop();
 
+    /**
+     * The document cannot be closed while it is being saved, but if
+     * it is deleted anyway, the manager waits for the background
+     * export to finish, so it is deleted before anything else
+     */
+    KIS_SAFE_ASSERT_RECOVER_NOOP(!isInSaving());
     delete d->importExportManager;
 
     // Despite being QObject they needs to be deleted before the image
@@ -566,7 +590,7 @@ bool KisDocument::exportDocument(const QUrl &_url, KisPropertiesConfigurationSP
     // on successful export we need to restore modified etc. too
     // on failed export, mimetype/modified hasn't changed anyway
     if (ret) {
-        setModified(wasModified);
+        setModified(wasModified || d->modifiedDuringSnapshotSaving);
    }
 
     d->isExporting = false;
@@ -620,7 +644,7 @@ bool KisDocument::save(KisPropertiesConfigurationSP exportConfiguration)
     clearFileProgressProxy();
 
     if (ok) {
-        setModified( false );
+        setModified(d->modifiedDuringSnapshotSaving);
         emit completed();
         d->m_saveOk = true;
         d->m_duringSaveAs = false;
@@ -704,7 +728,9 @@ bool KisDocument::saveFile(const QString &filePath, KisPropertiesConfigurationSP
         setFileProgressUpdater(i18n("Saving Document"));
 
         //qDebug() << "saving to tempory file" << tempororaryFileName;
+        d->importExportManager->setBackgroundSaving(d->isSavingSnapshot);
         status = d->importExportManager->exportDocument(localFilePath(), filePath, outputMimeType, !d->isExporting , exportConfiguration);
+        d->importExportManager->setBackgroundSaving(false);
 
         ret = (status == KisImportExportFilter::OK);
         suppressErrorDialog = (fileBatchMode() || isAutosaving() || status == KisImportExportFilter::UserCancelled || status == KisImportExportFilter::BadConversionGraph);
@@ -712,13 +738,16 @@ bool KisDocument::saveFile(const QString &filePath, KisPropertiesConfigurationSP
 
         if (ret) {
 
-            if (!d->isAutosaving && !d->suppressProgress) {
-                QPointer<KoUpdater> updater = d->progressUpdater->startSubtask(1, "clear undo stack");
-                updater->setProgress(0);
-                d->undoStack->setClean();
-                updater->setProgress(100);
-            } else {
-                d->undoStack->setClean();
+            // the changes made while saving a snapshot are not in the file
+            if (!d->modifiedDuringSnapshotSaving) {
+                if (!d->isAutosaving && !d->suppressProgress) {
+                    QPointer<KoUpdater> updater = d->progressUpdater->startSubtask(1, "clear undo stack");
+                    updater->setProgress(0);
+                    d->undoStack->setClean();
+                    updater->setProgress(100);
+                } else {
+                    d->undoStack->setClean();
+                }
             }
 
             if (errorMessage().isEmpty()) {
@@ -823,11 +852,33 @@ void KisDocument::slotAutoSave()
 {
     //qDebug() << "slotAutoSave. Modified:"  << d->modified << "modifiedAfterAutosave" << d->modified << "url" << url() << localFilePath();
 
+    /**
+     * Don't try to autosave while the document is being saved in the
+     * background, the timer will fire again later
+     */
+    if (isInSaving()) return;
+
     if (!d->isAutosaving && d->modified && d->modifiedAfterAutosave) {
 
+        KisConfig cfg;
+        const bool backgroundSaving = cfg.backgroundSaving();
+
+        /**
+         * The cache keeps the compressed tiles between the autosaves,
+         * so that only the tiles changed since the previous autosave
+         * need to be compressed again
+         */
+        if (!cfg.incrementalAutosave()) {
+            d->autosaveTilesCache.reset();
+        } else if (!d->autosaveTilesCache) {
+            d->autosaveTilesCache.reset(new KisCompressedTilesCache());
+        }
+
         bool batchmode = d->importExportManager->batchMode();
         d->importExportManager->setBatchMode(true);
-        qApp->setOverrideCursor(Qt::BusyCursor);
+        if (!backgroundSaving) {
+            qApp->setOverrideCursor(Qt::BusyCursor);
+        }
         connect(this, SIGNAL(sigProgress(int)), KisPart::instance()->currentMainwindow(), SLOT(slotProgress(int)));
         emit statusBarMessage(i18n("Autosaving..."));
         d->isAutosaving = true;
@@ -838,11 +889,13 @@ void KisDocument::slotAutoSave()
         bool ret = exportDocument(QUrl::fromLocalFile(autoSaveFileName));
         d->outputMimeType = mimetype;
 
-        if (ret) {
+        if (ret && !d->modifiedDuringSnapshotSaving) {
             d->modifiedAfterAutosave = false;
             d->autoSaveTimer.stop(); // until the next change
         }
-        qApp->restoreOverrideCursor();
+        if (!backgroundSaving) {
+            qApp->restoreOverrideCursor();
+        }
         d->importExportManager->setBatchMode(batchmode);
         d->isAutosaving = false;
 
@@ -1179,6 +1232,11 @@ void KisDocument::setModified(bool mod)
         updateEditingTime(false);
     }
 
+    if (mod && d->isSavingSnapshot) {
+        // the user continues painting while a copy of the image is being saved
+        d->modifiedDuringSnapshotSaving = true;
+    }
+
     if (d->isAutosaving)   // ignore setModified calls due to autosaving
         return;
 
@@ -1372,6 +1430,15 @@ void KisDocument::endMacro()
 
 void KisDocument::slotUndoStackIndexChanged(int idx)
 {
+    /**
+     * Even undoing back to the clean state changes the image after
+     * the snapshot has been taken, so the saved file doesn't
+     * correspond to the current index of the undo stack anymore
+     */
+    if (d->isSavingSnapshot) {
+        d->modifiedDuringSnapshotSaving = true;
+    }
+
     // even if the document was already modified, call setModified to re-start autosave timer
     setModified(idx != d->undoStack->cleanIndex());
 }
@@ -1426,6 +1493,11 @@ QUrl KisDocument::url() const
 
 bool KisDocument::closeUrl(bool promptToSave)
 {
+    // the document is being written in the background
+    if (isInSaving()) {
+        return false;
+    }
+
     if (promptToSave) {
         if ( isReadWrite() && isModified()) {
             Q_FOREACH (KisView *view, KisPart::instance()->views()) {
@@ -1685,6 +1757,36 @@ KisImageSP KisDocument::savingImage() const
     return d->savingImage;
 }
 
+vKisNodeSP KisDocument::savingActiveNodes() const
+{
+    return d->savingActiveNodes;
+}
+
+QList<KisPaintingAssistantSP> KisDocument::savingAssistants() const
+{
+    return d->savingAssistants;
+}
+
+KisGridConfig KisDocument::savingGridConfig() const
+{
+    return d->savingGridConfig;
+}
+
+KisGuidesConfig KisDocument::savingGuidesConfig() const
+{
+    return d->savingGuidesConfig;
+}
+
+KoDocumentInfo* KisDocument::savingDocumentInfo() const
+{
+    return d->savingDocInfo.data();
+}
+
+KisCompressedTilesCache* KisDocument::autosaveTilesCache() const
+{
+    return d->autosaveTilesCache.data();
+}
+
 
 void KisDocument::setCurrentImage(KisImageSP image)
 {
@@ -1723,15 +1825,20 @@ bool KisDocument::isAutosaving() const
 bool KisDocument::prepareLocksForSaving()
 {
     KisImageSP copiedImage;
-    // XXX: Restore this when
-    // a) cloning works correctly and
-    // b) doesn't take ages because it needs to refresh its entire graph and finally,
-    // c) we do use the saving image to save in the background.
+
+    /**
+     * In background saving mode we save a copy of the image. The
+     * clone shares all the tile data with the original image in a
+     * copy-on-write manner, so taking it is cheap and the image is
+     * unlocked right after that. The user can continue painting
+     * while the copy is being written.
+     */
+    const bool backgroundSaving = KisConfig().backgroundSaving();
+
     {
         Private::SafeSavingLocker locker(d, this);
         if (locker.successfullyLocked()) {
-
-            copiedImage = d->image; //->clone(true);
+            copiedImage = backgroundSaving ? KisImageSP(d->image->clone(true)) : d->image;
         }
         else if (!isAutosaving()) {
             // even though it is a recovery operation, we should ensure we do not enter saving twice!
@@ -1740,8 +1847,7 @@ bool KisDocument::prepareLocksForSaving()
             if (l.owns_lock()) {
                 d->lastErrorMessage = i18n("The image was still busy while saving. Your saved image might be incomplete.");
                 d->image->lock();
-                copiedImage = d->image; //->clone(true);
-                //copiedImage->initialRefreshGraph();
+                copiedImage = backgroundSaving ? KisImageSP(d->image->clone(true)) : d->image;
                 d->image->unlock();
             }
         }
@@ -1752,6 +1858,35 @@ bool KisDocument::prepareLocksForSaving()
     // ensure we do not enter saving twice
     if (copiedImage && d->savingMutex.tryLock()) {
         d->savingImage = copiedImage;
+        d->isSavingSnapshot = copiedImage != d->image;
+        d->modifiedDuringSnapshotSaving = false;
+
+        Q_FOREACH (KisNodeSP node, activeNodes()) {
+            /**
+             * The exact copy of the image keeps the uuids of the
+             * nodes, so we can find the counterparts of the active
+             * nodes in it
+             */
+            KisNodeSP savingNode = d->isSavingSnapshot ?
+                KisLayerUtils::findNodeByUuid(copiedImage->root(), node->uuid()) : node;
+
+            if (savingNode) {
+                d->savingActiveNodes.append(savingNode);
+            }
+        }
+
+        QMap<KisPaintingAssistantHandleSP, KisPaintingAssistantHandleSP> handleMap;
+        Q_FOREACH (KisPaintingAssistantSP assistant, d->assistants) {
+            KisPaintingAssistantSP savingAssistant = assistant->clone(handleMap);
+            if (savingAssistant) {
+                d->savingAssistants.append(savingAssistant);
+            }
+        }
+
+        d->savingGridConfig = d->gridConfig;
+        d->savingGuidesConfig = d->guidesConfig;
+        d->savingDocInfo.reset(new KoDocumentInfo(*d->docInfo, this));
+
         result = true;
     } else {
         qWarning() << "Could not lock the document for saving!";
@@ -1763,7 +1898,23 @@ bool KisDocument::prepareLocksForSaving()
 
 void KisDocument::unlockAfterSaving()
 {
+    /**
+     * Saving bumps the editing cycles of the copy of the document
+     * info, pass them back to the document
+     */
+    if (d->savingDocInfo) {
+        d->docInfo->setAboutInfo("editing-cycles", d->savingDocInfo->aboutInfo("editing-cycles"));
+        d->docInfo->setAboutInfo("date", d->savingDocInfo->aboutInfo("date"));
+    }
+
+    d->savingActiveNodes.clear();
+    d->savingAssistants.clear();
+    d->savingGridConfig = KisGridConfig();
+    d->savingGuidesConfig = KisGuidesConfig();
+    d->savingDocInfo.reset();
+
     d->savingImage = 0;
+    d->isSavingSnapshot = false;
     d->savingMutex.unlock();
 }
 
@@ -59,6 +59,7 @@ class KisPaintingAssistant;
 class KisPart;
 class KisGridConfig;
 class KisGuidesConfig;
+class KisCompressedTilesCache;
 class QDomDocument;
 
 class KisPart;
@@ -545,6 +546,43 @@ public:
      */
     KisImageSP savingImage() const;
 
+    /**
+     * The active nodes of the views of the document, mapped into savingImage()
+     */
+    vKisNodeSP savingActiveNodes() const;
+
+    /**
+     * Detached copies of the assistants of the document that must be used when saving
+     */
+    QList<KisPaintingAssistantSP> savingAssistants() const;
+
+    /**
+     * The grid config of the document at the moment the saving was started
+     */
+    KisGridConfig savingGridConfig() const;
+
+    /**
+     * The guides config of the document at the moment the saving was started
+     */
+    KisGuidesConfig savingGuidesConfig() const;
+
+    /**
+     * A copy of the document info that must be used when saving. Saving
+     * updates the editing cycles in the copy, they are passed back to the
+     * document when the saving is finished.
+     *
+     * @return the copy of the document info, or 0 if saving is not in progress
+     */
+    KoDocumentInfo* savingDocumentInfo() const;
+
+    /**
+     * @brief autosaveTilesCache keeps the compressed tiles of the previous autosave,
+     * so that the next autosave compresses only the tiles changed since then.
+     *
+     * @return the cache, or 0 if incremental autosaving is disabled
+     */
+    KisCompressedTilesCache* autosaveTilesCache() const;
+
     /**
      * Adds progressproxy for file operations
      */
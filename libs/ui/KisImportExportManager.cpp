@@ -33,6 +33,7 @@
 #include <QCheckBox>
 #include <QSaveFile>
 #include <QGroupBox>
+#include <QtConcurrent>
 
 #include <klocalizedstring.h>
 #include <ksqueezedtextlabel.h>
@@ -69,6 +70,14 @@ class Q_DECL_HIDDEN KisImportExportManager::Private
 {
 public:
     bool batchMode {false};
+    bool backgroundSaving {false};
+
+    /**
+     * The export running in a background thread. The filter uses
+     * the manager and the document, so they must not be deleted
+     * until it has finished.
+     */
+    QFuture<KisImportExportFilter::ConversionStatus> backgroundSavingFuture;
     QPointer<KoProgressUpdater> progressUpdater {0};
 };
 
@@ -80,6 +89,7 @@ KisImportExportManager::KisImportExportManager(KisDocument* document)
 
 KisImportExportManager::~KisImportExportManager()
 {
+    d->backgroundSavingFuture.waitForFinished();
     delete d;
 }
 
@@ -190,6 +200,16 @@ bool KisImportExportManager::batchMode(void) const
     return d->batchMode;
 }
 
+void KisImportExportManager::setBackgroundSaving(bool value)
+{
+    d->backgroundSaving = value;
+}
+
+bool KisImportExportManager::backgroundSaving() const
+{
+    return d->backgroundSaving;
+}
+
 void KisImportExportManager::setProgresUpdater(KoProgressUpdater *updater)
 {
     d->progressUpdater = updater;
@@ -278,7 +298,10 @@ KisImportExportFilter::ConversionStatus KisImportExportManager::convert(KisImpor
             return KisImportExportFilter::UserCancelled;
         }
 
-        if (!batchMode()) {
+        if (backgroundSaving()) {
+            d->backgroundSavingFuture = QtConcurrent::run(std::bind(&KisImportExportManager::doExport, this, location, filter, exportConfiguration, alsoAsKra));
+            status = KisAsyncActionFeedback::waitForActionInBackground(d->backgroundSavingFuture);
+        } else if (!batchMode()) {
             KisAsyncActionFeedback f(i18n("Saving document..."), 0);
             status = f.runAction(std::bind(&KisImportExportManager::doExport, this, location, filter, exportConfiguration, alsoAsKra));
         } else {
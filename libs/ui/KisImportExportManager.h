@@ -117,6 +117,19 @@ public:
      */
     bool batchMode(void) const;
 
+    /**
+     * Set the filter manager to run the export filter in a background
+     * thread without blocking the user. It should be set only when the
+     * document is saved from a detached copy of the image, which cannot
+     * be changed by the user while the filter works.
+     */
+    void setBackgroundSaving(bool value);
+
+    /**
+     * Get if the export filter is run in a background thread
+     */
+    bool backgroundSaving() const;
+
     void setProgresUpdater(KoProgressUpdater *updater);
 
     static QString askForAudioFileName(const QString &defaultDir, QWidget *parent);
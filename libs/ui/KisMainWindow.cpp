@@ -877,6 +877,20 @@ bool KisMainWindow::saveDocument(KisDocument *document, bool saveas)
     std::unique_lock<StdLockableWrapper<QMutex>> l(wrapper, std::try_to_lock);
     if (!l.owns_lock()) return false;
 
+    /**
+     * The document may still be being saved in the background,
+     * e.g. by autosave, then it cannot be saved again until that
+     * has finished
+     */
+    if (document->isInSaving()) {
+        if (d->activeView) {
+            d->activeView->viewManager()->showFloatingMessage(
+                i18n("Cannot save the document while saving is in progress"),
+                KisIconUtils::loadIcon("object-locked"), 1500 /* ms */);
+        }
+        return false;
+    }
+
     // no busy wait for saving because it is dangerous!
     KisDelayedSaveDialog dlg(document->image(), KisDelayedSaveDialog::SaveDialog, 0, this);
     dlg.blockIfImageIsBusy();
@@ -17,7 +17,9 @@
  */
 #include "kis_image_pyramid.h"
 
+#include <qmath.h>
 #include <QBitArray>
+#include <QtConcurrent>
 #include <KoChannelInfo.h>
 #include <KoCompositeOp.h>
 #include <KoColorSpaceRegistry.h>
@@ -53,6 +55,10 @@
 #include <half.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define ceiledSize(sz) QSize(ceil((sz).width()), ceil((sz).height()))
 #define isOdd(x) ((x) & 0x01)
 
@@ -98,8 +104,95 @@ inline void alignRectBy2(qint32 &x, qint32 &y, qint32 &w, qint32 &h)
 }
 
 
+/**
+ * Splits @rect into bands of rows aligned to the tiles, so that the
+ * bands can be written by different threads without sharing a tile
+ */
+inline QVector<QRect> splitIntoBands(const QRect &rect)
+{
+    const qint32 bandHeight = 64;
+
+    QVector<QRect> bands;
+
+    qint32 top = rect.top();
+    while (top <= rect.bottom()) {
+        const qint32 bandIndex = qFloor(qreal(top) / bandHeight);
+        const qint32 bottom = qMin(rect.bottom(), (bandIndex + 1) * bandHeight - 1);
+
+        bands << QRect(rect.left(), top, rect.width(), bottom - top + 1);
+        top = bottom + 1;
+    }
+
+    return bands;
+}
+
+
 /************* class KisImagePyramid ********************************/
 
+struct KisImagePyramid::ConvertBandJob
+{
+    ConvertBandJob(KisImagePyramid *pyramid, bool showSingleChannelAsColor)
+        : m_pyramid(pyramid),
+          m_showSingleChannelAsColor(showSingleChannelAsColor)
+    {
+    }
+
+    inline void operator() (const QRect &band) {
+        m_pyramid->convertImageData(band, m_showSingleChannelAsColor);
+    }
+
+    KisImagePyramid *m_pyramid;
+    bool m_showSingleChannelAsColor;
+};
+
+struct KisImagePyramid::DownsampleBandJob
+{
+    DownsampleBandJob(KisPaintDevice *src, KisPaintDevice *dst,
+                      qint32 srcX, qint32 srcWidth)
+        : m_src(src),
+          m_dst(dst),
+          m_srcX(srcX),
+          m_srcWidth(srcWidth)
+    {
+    }
+
+    inline void operator() (const QRect &dstBand) {
+        const qint32 srcY = 2 * dstBand.y();
+
+        KisHLineConstIteratorSP srcIt0 = m_src->createHLineConstIteratorNG(m_srcX, srcY, m_srcWidth);
+        KisHLineConstIteratorSP srcIt1 = m_src->createHLineConstIteratorNG(m_srcX, srcY + 1, m_srcWidth);
+        KisHLineIteratorSP dstIt = m_dst->createHLineIteratorNG(dstBand.x(), dstBand.y(), dstBand.width());
+
+        int conseqPixels = 0;
+        for (int row = 0; row < dstBand.height(); ++row) {
+            do {
+                int srcItConseq = srcIt0->nConseqPixels();
+                int dstItConseq = dstIt->nConseqPixels();
+                conseqPixels = qMin(srcItConseq, dstItConseq * 2);
+
+                Q_ASSERT(!isOdd(conseqPixels));
+
+                downsamplePixels(srcIt0->oldRawData(), srcIt1->oldRawData(),
+                                 dstIt->rawData(), conseqPixels);
+
+
+                srcIt1->nextPixels(conseqPixels);
+                dstIt->nextPixels(conseqPixels / 2);
+            } while (srcIt0->nextPixels(conseqPixels));
+            srcIt0->nextRow();
+            srcIt0->nextRow();
+            srcIt1->nextRow();
+            srcIt1->nextRow();
+            dstIt->nextRow();
+        }
+    }
+
+    KisPaintDevice *m_src;
+    KisPaintDevice *m_dst;
+    qint32 m_srcX;
+    qint32 m_srcWidth;
+};
+
 KisImagePyramid::KisImagePyramid(qint32 pyramidHeight)
         : m_monitorProfile(0)
         , m_monitorColorSpace(0)
@@ -225,6 +318,33 @@ void KisImagePyramid::updateCache(const QRect &dirtyImageRect)
 }
 
 void KisImagePyramid::retrieveImageData(const QRect &rect)
+{
+    /**
+     * The channel flags and the config are read before the work is
+     * spread over the threads
+     */
+    const KoColorSpace *projectionCs = m_originalImage->projection()->colorSpace();
+    if (m_channelFlags.size() != projectionCs->channels().size()) {
+        setChannelFlags(QBitArray());
+    }
+
+    KisConfig cfg;
+    const bool showSingleChannelAsColor = cfg.showSingleChannelAsColor();
+
+    /**
+     * The pixels are converted independently, so the bands of the
+     * rect are converted in parallel
+     */
+    QVector<QRect> bands = splitIntoBands(rect);
+
+    if (bands.size() == 1) {
+        convertImageData(rect, showSingleChannelAsColor);
+    } else {
+        QtConcurrent::blockingMap(bands, ConvertBandJob(this, showSingleChannelAsColor));
+    }
+}
+
+void KisImagePyramid::convertImageData(const QRect &rect, bool showSingleChannelAsColor)
 {
     // XXX: use QThreadStorage to cache the two patches (512x512) of pixels. Note
     // that when we do that, we need to reset that cache when the projection's
@@ -277,18 +397,13 @@ void KisImagePyramid::retrieveImageData(const QRect &rect)
     }
     else {
         QList<KoChannelInfo*> channelInfo = projectionCs->channels();
-        if (m_channelFlags.size() != channelInfo.size()) {
-            setChannelFlags(QBitArray());
-        }
         if (!m_channelFlags.isEmpty() && !m_allChannelsSelected) {
             QScopedArrayPointer<quint8> dst(new quint8[projectionCs->pixelSize() * numPixels]);
 
             int channelSize = channelInfo[m_selectedChannelIndex]->size();
             int pixelSize = projectionCs->pixelSize();
 
-            KisConfig cfg;
-
-            if (m_onlyOneChannelSelected && !cfg.showSingleChannelAsColor()) {
+            if (m_onlyOneChannelSelected && !showSingleChannelAsColor) {
                 int selectedChannelPos = channelInfo[m_selectedChannelIndex]->pos();
                 for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
                     for (uint channelIndex = 0; channelIndex < projectionCs->channelCount(); ++channelIndex) {
@@ -377,32 +492,9 @@ QRect KisImagePyramid::downsampleByFactor2(const QRect& srcRect,
     qint32 dstWidth = srcWidth / 2;
     qint32 dstHeight = srcHeight / 2;
 
-    KisHLineConstIteratorSP srcIt0 = src->createHLineConstIteratorNG(srcX, srcY, srcWidth);
-    KisHLineConstIteratorSP srcIt1 = src->createHLineConstIteratorNG(srcX, srcY + 1, srcWidth);
-    KisHLineIteratorSP dstIt = dst->createHLineIteratorNG(dstX, dstY, dstWidth);
-
-    int conseqPixels = 0;
-    for (int row = 0; row < dstHeight; ++row) {
-        do {
-            int srcItConseq = srcIt0->nConseqPixels();
-            int dstItConseq = dstIt->nConseqPixels();
-            conseqPixels = qMin(srcItConseq, dstItConseq * 2);
+    QVector<QRect> dstBands = splitIntoBands(QRect(dstX, dstY, dstWidth, dstHeight));
+    QtConcurrent::blockingMap(dstBands, DownsampleBandJob(src, dst, srcX, srcWidth));
 
-            Q_ASSERT(!isOdd(conseqPixels));
-
-            downsamplePixels(srcIt0->oldRawData(), srcIt1->oldRawData(),
-                             dstIt->rawData(), conseqPixels);
-
-
-            srcIt1->nextPixels(conseqPixels);
-            dstIt->nextPixels(conseqPixels / 2);
-        } while (srcIt0->nextPixels(conseqPixels));
-        srcIt0->nextRow();
-        srcIt0->nextRow();
-        srcIt1->nextRow();
-        srcIt1->nextRow();
-        dstIt->nextRow();
-    }
     return QRect(dstX, dstY, dstWidth, dstHeight);
 }
 
@@ -411,18 +503,55 @@ void  KisImagePyramid::downsamplePixels(const quint8 *srcRow0,
                                         quint8 *dstRow,
                                         qint32 numSrcPixels)
 {
+    static const qint32 pixelSize = 4; // This is preview argb8 mode
+
+    const qint32 numDstPixels = numSrcPixels / 2;
+    qint32 i = 0;
+
+#ifdef __SSE2__
     /**
-     * FIXME (mandatory): Use SSE and friends here.
+     * Four destination pixels per iteration: the channels are
+     * unpacked into 16-bit words, summed vertically, then the
+     * neighbouring pixels are summed and the sum is divided by 4
+     * with a shift, which gives the same result as the scalar code.
      */
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= numDstPixels; i += 4) {
+        const __m128i row0a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow0));
+        const __m128i row0b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow0 + 16));
+        const __m128i row1a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow1));
+        const __m128i row1b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow1 + 16));
+
+        // vertical sums of the source pixels 0-1, 2-3, 4-5, 6-7
+        const __m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi8(row0a, zero), _mm_unpacklo_epi8(row1a, zero));
+        const __m128i sum23 = _mm_add_epi16(_mm_unpackhi_epi8(row0a, zero), _mm_unpackhi_epi8(row1a, zero));
+        const __m128i sum45 = _mm_add_epi16(_mm_unpacklo_epi8(row0b, zero), _mm_unpacklo_epi8(row1b, zero));
+        const __m128i sum67 = _mm_add_epi16(_mm_unpackhi_epi8(row0b, zero), _mm_unpackhi_epi8(row1b, zero));
+
+        // horizontal sums, each in the lower half of the register
+        const __m128i dst0 = _mm_add_epi16(sum01, _mm_srli_si128(sum01, 8));
+        const __m128i dst1 = _mm_add_epi16(sum23, _mm_srli_si128(sum23, 8));
+        const __m128i dst2 = _mm_add_epi16(sum45, _mm_srli_si128(sum45, 8));
+        const __m128i dst3 = _mm_add_epi16(sum67, _mm_srli_si128(sum67, 8));
+
+        const __m128i dst01 = _mm_srli_epi16(_mm_unpacklo_epi64(dst0, dst1), 2);
+        const __m128i dst23 = _mm_srli_epi16(_mm_unpacklo_epi64(dst2, dst3), 2);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow), _mm_packus_epi16(dst01, dst23));
+
+        dstRow += 4 * pixelSize;
+        srcRow0 += 8 * pixelSize;
+        srcRow1 += 8 * pixelSize;
+    }
+#endif
 
     qint16 b = 0;
     qint16 g = 0;
     qint16 r = 0;
     qint16 a = 0;
 
-    static const qint32 pixelSize = 4; // This is preview argb8 mode
-
-    for (qint32 i = 0; i < numSrcPixels / 2; i++) {
+    for (; i < numDstPixels; i++) {
         b = srcRow0[0] + srcRow1[0] + srcRow0[4] + srcRow1[4];
         g = srcRow0[1] + srcRow1[1] + srcRow0[5] + srcRow1[5];
         r = srcRow0[2] + srcRow1[2] + srcRow0[6] + srcRow1[6];
@@ -76,6 +76,14 @@ public:
 private:
 
     void retrieveImageData(const QRect &rect);
+
+    /**
+     * Converts @rect of the projection into the monitor color space
+     * and writes it into the original plane of the pyramid. Can be
+     * called from several threads at once for different rects.
+     */
+    void convertImageData(const QRect &rect, bool showSingleChannelAsColor);
+
     void rebuildPyramid();
     void clearPyramid();
 
@@ -92,7 +100,7 @@ private:
      * and @srcRow1 into one line @dstRow
      * Note: @numSrcPixels must be EVEN
      */
-    void downsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
+    static void downsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
                           quint8 *dstRow, qint32 numSrcPixels);
 
     /**
@@ -113,6 +121,10 @@ private Q_SLOTS:
 
     void configChanged();
 
+private:
+    struct ConvertBandJob;
+    struct DownsampleBandJob;
+
 private:
 
     QVector<KisPaintDeviceSP> m_pyramid;
@@ -19,6 +19,7 @@
 #include "kis_async_action_feedback.h"
 
 #include <QtConcurrent>
+#include <QEventLoop>
 #include <QProgressDialog>
 
 
@@ -60,3 +61,23 @@ KisImportExportFilter::ConversionStatus KisAsyncActionFeedback::runAction(std::f
 {
     return runActionImpl(func);
 }
+
+KisImportExportFilter::ConversionStatus KisAsyncActionFeedback::waitForActionInBackground(QFuture<KisImportExportFilter::ConversionStatus> result)
+{
+    QFutureWatcher<KisImportExportFilter::ConversionStatus> watcher;
+    QEventLoop loop;
+
+    /**
+     * Unlike runAction() we sleep in the event loop instead of
+     * spinning processEvents(), the action may take quite a while
+     */
+    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(result);
+
+    if (!result.isFinished()) {
+        loop.exec();
+    }
+
+    watcher.waitForFinished();
+    return watcher.result();
+}
@@ -20,6 +20,7 @@
 #define __KIS_ASYNC_ACTION_FEEDBACK_H
 
 #include <QScopedPointer>
+#include <QFuture>
 #include <functional>
 #include "KisImportExportFilter.h"
 
@@ -33,6 +34,15 @@ public:
 
     KisImportExportFilter::ConversionStatus runAction(std::function<KisImportExportFilter::ConversionStatus()> func);
 
+    /**
+     * Waits for the action running in a background thread without
+     * showing any modal feedback, so the user can continue working
+     * while the action is in progress. The GUI event loop is kept
+     * running until the action has finished, so the caller should
+     * make sure its objects are not deleted meanwhile.
+     */
+    static KisImportExportFilter::ConversionStatus waitForActionInBackground(QFuture<KisImportExportFilter::ConversionStatus> result);
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
@@ -949,6 +949,26 @@ void KisConfig::setBackupFile(bool backupFile) const
     m_cfg.writeEntry("CreateBackupFile", backupFile);
 }
 
+bool KisConfig::backgroundSaving(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("BackgroundSaving", true));
+}
+
+void KisConfig::setBackgroundSaving(bool value) const
+{
+    m_cfg.writeEntry("BackgroundSaving", value);
+}
+
+bool KisConfig::incrementalAutosave(bool defaultValue) const
+{
+    return (defaultValue ? true : m_cfg.readEntry("IncrementalAutosave", true));
+}
+
+void KisConfig::setIncrementalAutosave(bool value) const
+{
+    m_cfg.writeEntry("IncrementalAutosave", value);
+}
+
 bool KisConfig::showFilterGallery(bool defaultValue) const
 {
     return (defaultValue ? false : m_cfg.readEntry("showFilterGallery", false));
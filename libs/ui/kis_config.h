@@ -248,6 +248,12 @@ public:
     bool backupFile(bool defaultValue = false) const;
     void setBackupFile(bool backupFile) const;
 
+    bool backgroundSaving(bool defaultValue = false) const;
+    void setBackgroundSaving(bool value) const;
+
+    bool incrementalAutosave(bool defaultValue = false) const;
+    void setIncrementalAutosave(bool value) const;
+
     bool showFilterGallery(bool defaultValue = false) const;
     void setShowFilterGallery(bool showFilterGallery) const;
 
@@ -380,6 +380,34 @@ void KisPaintingAssistant::loadXml(KoStore* store, QMap<int, KisPaintingAssistan
     store->close();
 }
 
+KisPaintingAssistantSP KisPaintingAssistant::clone(QMap<KisPaintingAssistantHandleSP, KisPaintingAssistantHandleSP> &handleMap) const
+{
+    KisPaintingAssistantFactory *factory =
+        KisPaintingAssistantFactoryRegistry::instance()->get(d->id);
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(factory, KisPaintingAssistantSP());
+
+    KisPaintingAssistantSP assistant(factory->createPaintingAssistant());
+    assistant->setSnapping(d->snapping);
+    assistant->setOutline(d->outlineVisible);
+
+    auto cloneHandle = [&handleMap] (KisPaintingAssistantHandleSP handle) {
+        if (!handleMap.contains(handle)) {
+            handleMap.insert(handle, new KisPaintingAssistantHandle(*handle));
+        }
+        return handleMap.value(handle);
+    };
+
+    Q_FOREACH (KisPaintingAssistantHandleSP handle, d->handles) {
+        assistant->addHandle(cloneHandle(handle));
+    }
+
+    Q_FOREACH (KisPaintingAssistantHandleSP handle, d->sideHandles) {
+        assistant->addSideHandle(cloneHandle(handle));
+    }
+
+    return assistant;
+}
+
 void KisPaintingAssistant::saveXmlList(QDomDocument& doc, QDomElement& assistantsElement,int count)
 {
     if (d->id == "ellipse"){
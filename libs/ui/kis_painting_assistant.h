@@ -27,6 +27,7 @@
 
 #include <kritaui_export.h>
 #include <kis_shared.h>
+#include <kis_types.h>
 
 class QPainter;
 class QRect;
@@ -108,6 +109,14 @@ public:
     QByteArray saveXml( QMap<KisPaintingAssistantHandleSP, int> &handleMap);
     void loadXml(KoStore *store, QMap<int, KisPaintingAssistantHandleSP> &handleMap, QString path);
     void saveXmlList(QDomDocument& doc, QDomElement& ssistantsElement, int count);
+
+    /**
+     * Creates a detached copy of the assistant with the same type and
+     * handles, e.g. for saving it in a background thread. The handles
+     * shared between the assistants stay shared in the copies, if all
+     * of them are cloned with the same \p handleMap.
+     */
+    KisPaintingAssistantSP clone(QMap<KisPaintingAssistantHandleSP, KisPaintingAssistantHandleSP> &handleMap) const;
     void findHandleLocation();
     KisPaintingAssistantHandleSP oppHandleOne();
 
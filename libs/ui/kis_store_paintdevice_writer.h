@@ -23,8 +23,9 @@
 
 class KisStorePaintDeviceWriter : public KisPaintDeviceWriter {
 public:
-    KisStorePaintDeviceWriter(KoStore *store)
-        : m_store(store)
+    KisStorePaintDeviceWriter(KoStore *store, KisCompressedTilesCache *tilesCache = 0)
+        : m_store(store),
+          m_tilesCache(tilesCache)
     {
     }
 
@@ -40,7 +41,12 @@ public:
         return (length == len);
     }
 
+    KisCompressedTilesCache* compressedTilesCache() const override {
+        return m_tilesCache;
+    }
+
     KoStore *m_store;
+    KisCompressedTilesCache *m_tilesCache;
 
 };
 
@@ -42,7 +42,7 @@ public:
     void unsetCanvas() override;
 
 public Q_SLOTS:
-    void startUpdateCanvasProjection();
+    void startUpdateCanvasProjection(const QRect &rect);
     void sigColorSpaceChanged(const KoColorSpace* cs);
     void updateHistogram();
 
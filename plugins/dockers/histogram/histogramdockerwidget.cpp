@@ -19,7 +19,6 @@
 
 #include <QThread>
 #include <QVector>
-#include <limits>
 #include <algorithm>
 #include <QTime>
 #include <QPainter>
@@ -28,11 +27,12 @@
 #include "KoChannelInfo.h"
 #include "kis_paint_device.h"
 #include "KoColorSpace.h"
-#include "kis_iterator_ng.h"
 #include "kis_canvas2.h"
+#include "kis_parallel_histogram.h"
 
 HistogramDockerWidget::HistogramDockerWidget(QWidget *parent, const char *name, Qt::WindowFlags f)
-    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true)
+    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true),
+      m_computationRunning(false), m_updatePending(false)
 {
     setObjectName(name);
 }
@@ -47,22 +47,39 @@ void HistogramDockerWidget::setPaintDevice(KisCanvas2* canvas)
     if (canvas) {
         m_paintDevice = canvas->image()->projection();
         m_bounds = canvas->image()->bounds();
+        m_histogram.reset(new KisParallelHistogram(m_bounds));
     } else {
         m_paintDevice.clear();
         m_bounds = QRect();
         m_histogramData.clear();
+        m_histogram.reset();
     }
+
+    m_dirtyRects.clear();
 }
 
 void HistogramDockerWidget::updateHistogram()
 {
     if (!m_paintDevice.isNull()) {
+        /**
+         * The histogram object keeps the bins of the previous
+         * computation, so it should not be shared by two threads
+         */
+        if (m_computationRunning) {
+            m_updatePending = true;
+            return;
+        }
+
         KisPaintDeviceSP m_devClone = new KisPaintDevice(m_paintDevice->colorSpace());
 
         m_devClone->makeCloneFrom(m_paintDevice, m_bounds);
 
-        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, m_bounds);
+        HistogramComputationThread *workerThread = new HistogramComputationThread(m_histogram, m_devClone, m_dirtyRects);
+        m_dirtyRects.clear();
+        m_computationRunning = true;
+
         connect(workerThread, &HistogramComputationThread::resultReady, this, &HistogramDockerWidget::receiveNewHistogram);
+        connect(workerThread, &HistogramComputationThread::finished, this, &HistogramDockerWidget::slotComputationFinished);
         connect(workerThread, &HistogramComputationThread::finished, workerThread, &QObject::deleteLater);
         workerThread->start();
     } else {
@@ -77,6 +94,33 @@ void HistogramDockerWidget::receiveNewHistogram(HistVector *histogramData)
     update();
 }
 
+void HistogramDockerWidget::addDirtyRect(const QRect &rect)
+{
+    // don't let the list grow while the docker is hidden
+    const int maxDirtyRects = 64;
+
+    if (m_dirtyRects.size() >= maxDirtyRects) {
+        QRect totalRect = rect;
+        Q_FOREACH (const QRect &rc, m_dirtyRects) {
+            totalRect |= rc;
+        }
+        m_dirtyRects.clear();
+        m_dirtyRects << totalRect;
+    } else {
+        m_dirtyRects << rect;
+    }
+}
+
+void HistogramDockerWidget::slotComputationFinished()
+{
+    m_computationRunning = false;
+
+    if (m_updatePending) {
+        m_updatePending = false;
+        updateHistogram();
+    }
+}
+
 void HistogramDockerWidget::paintEvent(QPaintEvent *event)
 {
     if (!m_histogramData.empty()) {
@@ -156,40 +200,18 @@ void HistogramDockerWidget::paintEvent(QPaintEvent *event)
 
 void HistogramComputationThread::run()
 {
-    const KoColorSpace *cs = m_dev->colorSpace();
-    quint32 channelCount = m_dev->channelCount();
-    quint32 pixelSize = m_dev->pixelSize();
+    if (!m_histogram) return;
 
-    quint32 imageSize = m_bounds.width() * m_bounds.height();
-    quint32 nSkip = 1 + (imageSize >> 20); //for speed use about 1M pixels for computing histograms
+    m_histogram->update(m_dev, m_dirtyRects);
 
-    //allocate space for the histogram data
-    bins.resize((int)channelCount);
-    for (auto &bin : bins) {
-        bin.resize(std::numeric_limits<quint8>::max() + 1);
-    }
+    const int channelCount = m_histogram->channelCount();
+    if (!channelCount) return;
 
-    QRect bounds = m_dev->exactBounds();
-    if (bounds.isEmpty())
-        return;
-
-    KisSequentialConstIterator it(m_dev, m_dev->exactBounds());
-    int i;
-    quint32 toSkip = nSkip;
-
-    do {
-        i = it.nConseqPixels();
-        const quint8* pixel = it.rawDataConst();
-        for (int k = 0; k < i; ++k) {
-            if (--toSkip == 0) {
-                for (int chan = 0; chan < (int)channelCount; ++chan) {
-                    bins[chan][cs->scaleToU8(pixel, chan)]++;
-                }
-                toSkip = nSkip;
-            }
-            pixel += pixelSize;
-        }
-    } while (it.nextPixels(i));
+    bins.resize(channelCount);
+    for (int chan = 0; chan < channelCount; ++chan) {
+        const QVector<quint32> &channelBins = m_histogram->bins(chan);
+        bins[chan].assign(channelBins.constBegin(), channelBins.constEnd());
+    }
 
     emit resultReady(&bins);
 }
@@ -23,10 +23,12 @@
 #include <QWidget>
 #include <QLabel>
 #include <QThread>
+#include <QSharedPointer>
 #include "kis_types.h"
 #include <vector>
 
 class KisCanvas2;
+class KisParallelHistogram;
 
 typedef std::vector<std::vector<quint32> > HistVector; //Don't use QVector here - it's too slow for this purpose
 
@@ -35,7 +37,8 @@ class HistogramComputationThread : public QThread
 {
     Q_OBJECT
 public:
-    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds) : m_dev(_dev), m_bounds(_bounds)
+    HistogramComputationThread(QSharedPointer<KisParallelHistogram> histogram, KisPaintDeviceSP _dev, const QVector<QRect> &dirtyRects)
+        : m_histogram(histogram), m_dev(_dev), m_dirtyRects(dirtyRects)
     {}
 
     void run() override;
@@ -44,8 +47,9 @@ Q_SIGNALS:
     void resultReady(HistVector*);
 
 private:
+    QSharedPointer<KisParallelHistogram> m_histogram;
     KisPaintDeviceSP m_dev;
-    QRect m_bounds;
+    QVector<QRect> m_dirtyRects;
     HistVector bins;
 };
 
@@ -63,12 +67,21 @@ public:
 public Q_SLOTS:
     void updateHistogram();
     void receiveNewHistogram(HistVector*);
+    void addDirtyRect(const QRect &rect);
+
+private Q_SLOTS:
+    void slotComputationFinished();
 
 private:
     KisPaintDeviceSP m_paintDevice;
     HistVector m_histogramData;
     QRect m_bounds;
     bool m_smoothHistogram;
+
+    QSharedPointer<KisParallelHistogram> m_histogram;
+    QVector<QRect> m_dirtyRects;
+    bool m_computationRunning;
+    bool m_updatePending;
 };
 
 #endif // HISTOGRAMDOCKERWIDGET_H
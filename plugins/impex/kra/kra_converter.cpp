@@ -116,6 +116,12 @@ KisImageBuilder_Result KraConverter::buildFile(QIODevice *io)
         return KisImageBuilder_RESULT_FAILURE;
     }
 
+    /**
+     * All the state of the document must be taken from its saving
+     * snapshot, since we may be running in a background thread
+     */
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(m_doc->savingDocumentInfo(), KisImageBuilder_RESULT_FAILURE);
+
     bool result = false;
 
     m_kraSaver = new KisKraSaver(m_doc);
@@ -163,7 +169,7 @@ bool KraConverter::saveRootDocuments(KoStore *store)
     if (store->open("documentinfo.xml")) {
         QDomDocument doc = KisDocument::createDomDocument("document-info"
                                                           /*DTD name*/, "document-info" /*tag name*/, "1.1");
-        doc = m_doc->documentInfo()->save(doc);
+        doc = m_doc->savingDocumentInfo()->save(doc);
         KoStoreDevice dev(store);
         QByteArray s = doc.toByteArray(); // this is already Utf8!
         success = dev.write(s.data(), s.size());
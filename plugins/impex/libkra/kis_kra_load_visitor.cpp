@@ -24,6 +24,7 @@
 #include <QRect>
 #include <QBuffer>
 #include <QByteArray>
+#include <QtConcurrent>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoColorProfile.h>
@@ -90,7 +91,8 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
                                      int syntaxVersion) :
         KisNodeVisitor(),
         m_layerFilenames(layerFilenames),
-        m_keyframeFilenames(keyframeFilenames)
+        m_keyframeFilenames(keyframeFilenames),
+        m_pendingPixelDataSize(0)
 {
     m_external = false;
     m_image = image;
@@ -408,6 +410,10 @@ QStringList KisKraLoadVisitor::warningMessages() const
 
 struct SimpleDevicePolicy
 {
+    int frameId() const {
+        return -1;
+    }
+
     bool read(KisPaintDeviceSP dev, QIODevice *stream) {
         return dev->read(stream);
     }
@@ -422,6 +428,10 @@ struct FramedDevicePolicy
     FramedDevicePolicy(int frameId)
         :  m_frameId(frameId) {}
 
+    int frameId() const {
+        return m_frameId;
+    }
+
     bool read(KisPaintDeviceSP dev, QIODevice *stream) {
         return dev->framesInterface()->readFrame(stream, m_frameId);
     }
@@ -471,18 +481,24 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
 template<class DevicePolicy>
 bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy)
 {
+    PendingPixelData pending;
+    pending.device = device;
+    pending.frameId = policy.frameId();
+    pending.location = location;
+    pending.success = false;
+
     if (m_store->open(location)) {
-        if (!policy.read(device, m_store->device())) {
-            m_warningMessages << i18n("Could not read pixel data: %1.", location);
-            device->disconnect();
-            m_store->close();
-            return true;
-        }
+        pending.data = m_store->read(m_store->size());
         m_store->close();
     } else {
         m_warningMessages << i18n("Could not load pixel data: %1.", location);
         return true;
     }
+    /**
+     * The default pixel is set right away, before the profile of the
+     * device is loaded, otherwise setting it would convert it into
+     * the loaded profile. Reading the pixel data doesn't change it.
+     */
     if (m_store->open(location + ".defaultpixel")) {
         int pixelSize = device->colorSpace()->pixelSize();
         if (m_store->size() == pixelSize) {
@@ -493,9 +509,62 @@ bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QStr
         m_store->close();
     }
 
+    m_pendingPixelDataSize += pending.data.size();
+    m_pendingPixelData.append(pending);
+
+    /**
+     * Don't keep too much of the raw data in memory
+     */
+    const qint64 maxPendingPixelDataSize = 256 * 1024 * 1024;
+    if (m_pendingPixelDataSize > maxPendingPixelDataSize) {
+        loadPendingPixelData();
+    }
+
     return true;
 }
 
+template<class DevicePolicy>
+bool decodePixelData(KisPaintDeviceSP device, QByteArray &data, DevicePolicy policy)
+{
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    return policy.read(device, &buffer);
+}
+
+struct KisKraLoadVisitor::DecodePixelData
+{
+    inline void operator() (PendingPixelData &pending) {
+        if (pending.frameId < 0) {
+            pending.success = decodePixelData(pending.device, pending.data,
+                                              SimpleDevicePolicy());
+        } else {
+            pending.success = decodePixelData(pending.device, pending.data,
+                                              FramedDevicePolicy(pending.frameId));
+        }
+
+        pending.data.clear();
+    }
+};
+
+void KisKraLoadVisitor::loadPendingPixelData()
+{
+    /**
+     * The devices (and the frames of a device) have independent
+     * data managers, so they can be decoded concurrently
+     */
+    QtConcurrent::blockingMap(m_pendingPixelData, DecodePixelData());
+
+    Q_FOREACH (const PendingPixelData &pending, m_pendingPixelData) {
+        if (!pending.success) {
+            m_warningMessages << i18n("Could not read pixel data: %1.", pending.location);
+            pending.device->disconnect();
+        }
+    }
+
+    m_pendingPixelData.clear();
+    m_pendingPixelDataSize = 0;
+}
 
 bool KisKraLoadVisitor::loadProfile(KisPaintDeviceSP device, const QString& location)
 {
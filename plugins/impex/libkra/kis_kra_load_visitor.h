@@ -22,6 +22,7 @@
 
 #include <QRect>
 #include <QStringList>
+#include <QVector>
 
 // kritaimage
 #include "kis_types.h"
@@ -65,7 +66,28 @@ public:
     QStringList errorMessages() const;
     QStringList warningMessages() const;
 
+    /**
+     * The visitor only reads the pixel data of the devices from the
+     * store, the data is decoded into the devices in parallel later.
+     * This method decodes all the pending data, it should be called
+     * after the visitor has walked through the node tree.
+     */
+    void loadPendingPixelData();
+
 private:
+    /**
+     * The raw data of a device (or a frame of it) read from the store,
+     * waiting for being decoded in a worker thread
+     */
+    struct PendingPixelData {
+        KisPaintDeviceSP device;
+        int frameId; // -1 for non-animated devices
+        QString location;
+        QByteArray data;
+        bool success;
+    };
+
+    struct DecodePixelData;
 
     bool loadPaintDevice(KisPaintDeviceSP device, const QString& location);
 
@@ -92,6 +114,9 @@ private:
     int m_syntaxVersion;
     QStringList m_errorMessages;
     QStringList m_warningMessages;
+
+    QVector<PendingPixelData> m_pendingPixelData;
+    qint64 m_pendingPixelDataSize;
 };
 
 #endif // KIS_KRA_LOAD_VISITOR_H_
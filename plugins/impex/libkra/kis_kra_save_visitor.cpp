@@ -67,13 +67,14 @@
 
 using namespace KRA;
 
-KisKraSaveVisitor::KisKraSaveVisitor(KoStore *store, const QString & name, QMap<const KisNode*, QString> nodeFileNames)
+KisKraSaveVisitor::KisKraSaveVisitor(KoStore *store, const QString & name, QMap<const KisNode*, QString> nodeFileNames,
+                                     KisCompressedTilesCache *tilesCache)
     : KisNodeVisitor()
     , m_store(store)
     , m_external(false)
     , m_name(name)
     , m_nodeFileNames(nodeFileNames)
-    , m_writer(new KisStorePaintDeviceWriter(store))
+    , m_writer(new KisStorePaintDeviceWriter(store, tilesCache))
 {
 }
 
@@ -29,12 +29,14 @@
 #include "kritalibkra_export.h"
 
 class KisPaintDeviceWriter;
+class KisCompressedTilesCache;
 class KoStore;
 
 class KRITALIBKRA_EXPORT KisKraSaveVisitor : public KisNodeVisitor
 {
 public:
-    KisKraSaveVisitor(KoStore *store, const QString & name, QMap<const KisNode*, QString> nodeFileNames);
+    KisKraSaveVisitor(KoStore *store, const QString & name, QMap<const KisNode*, QString> nodeFileNames,
+                      KisCompressedTilesCache *tilesCache = 0);
     ~KisKraSaveVisitor() override;
     using KisNodeVisitor::visit;
 
@@ -50,6 +50,7 @@
 #include "kis_png_converter.h"
 #include "kis_keyframe_channel.h"
 #include <kis_time_range.h>
+#include <tiles3/kis_compressed_tiles_cache.h>
 #include "KisDocument.h"
 #include <string>
 #include "kis_dom_utils.h"
@@ -78,7 +79,7 @@ KisKraSaver::KisKraSaver(KisDocument* document)
 {
     m_d->doc = document;
 
-    m_d->imageName = m_d->doc->documentInfo()->aboutInfo("title");
+    m_d->imageName = m_d->doc->savingDocumentInfo()->aboutInfo("title");
     if (m_d->imageName.isEmpty()) {
         m_d->imageName = i18n("Unnamed");
     }
@@ -99,7 +100,7 @@ QDomElement KisKraSaver::saveXML(QDomDocument& doc,  KisImageSP image)
     imageElement.setAttribute(WIDTH, KisDomUtils::toString(image->width()));
     imageElement.setAttribute(HEIGHT, KisDomUtils::toString(image->height()));
     imageElement.setAttribute(COLORSPACE_NAME, image->colorSpace()->id());
-    imageElement.setAttribute(DESCRIPTION, m_d->doc->documentInfo()->aboutInfo("comment"));
+    imageElement.setAttribute(DESCRIPTION, m_d->doc->savingDocumentInfo()->aboutInfo("comment"));
     // XXX: Save profile as blob inside the image, instead of the product name.
     if (image->profile() && image->profile()-> valid()) {
         imageElement.setAttribute(PROFILE, image->profile()->name());
@@ -115,7 +116,7 @@ QDomElement KisKraSaver::saveXML(QDomDocument& doc,  KisImageSP image)
 
     quint32 count = 1; // We don't save the root layer, but it does count
     KisSaveXmlVisitor visitor(doc, imageElement, count, m_d->doc->url().toLocalFile(), true);
-    visitor.setSelectedNodes(m_d->doc->activeNodes());
+    visitor.setSelectedNodes(m_d->doc->savingActiveNodes());
 
     image->rootLayer()->accept(visitor);
     m_d->errorMessages.append(visitor.errorMessages());
@@ -187,14 +188,27 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
 {
     QString location;
 
+    /**
+     * Autosaves reuse the compressed tiles of the previous autosave
+     * for all the tiles that have not been changed since then
+     */
+    KisCompressedTilesCache *tilesCache = autosave ? m_d->doc->autosaveTilesCache() : 0;
+    if (tilesCache) {
+        tilesCache->beginSaving();
+    }
+
     // Save the layers data
-    KisKraSaveVisitor visitor(store, m_d->imageName, m_d->nodeFileNames);
+    KisKraSaveVisitor visitor(store, m_d->imageName, m_d->nodeFileNames, tilesCache);
 
     if (external)
         visitor.setExternalUri(uri);
 
     image->rootLayer()->accept(visitor);
 
+    if (tilesCache) {
+        tilesCache->endSaving();
+    }
+
     m_d->errorMessages.append(visitor.errorMessages());
     if (!m_d->errorMessages.isEmpty()) {
         return false;
@@ -328,7 +342,7 @@ bool KisKraSaver::saveAssistants(KoStore* store, QString uri, bool external)
     QString location;
     QMap<QString, int> assistantcounters;
     QByteArray data;
-    QList<KisPaintingAssistantSP> assistants =  m_d->doc->assistants();
+    QList<KisPaintingAssistantSP> assistants = m_d->doc->savingAssistants();
     QMap<KisPaintingAssistantHandleSP, int> handlemap;
     if (!assistants.isEmpty()) {
         Q_FOREACH (KisPaintingAssistantSP assist, assistants){
@@ -352,7 +366,7 @@ bool KisKraSaver::saveAssistants(KoStore* store, QString uri, bool external)
 bool KisKraSaver::saveAssistantsList(QDomDocument& doc, QDomElement& element)
 {
     int count_ellipse = 0, count_perspective = 0, count_ruler = 0, count_vanishingpoint = 0,count_infiniteruler = 0, count_parallelruler = 0, count_concentricellipse = 0, count_fisheyepoint = 0, count_spline = 0;
-    QList<KisPaintingAssistantSP> assistants =  m_d->doc->assistants();
+    QList<KisPaintingAssistantSP> assistants = m_d->doc->savingAssistants();
     if (!assistants.isEmpty()) {
         QDomElement assistantsElement = doc.createElement("assistants");
         Q_FOREACH (KisPaintingAssistantSP assist, assistants){
@@ -400,7 +414,7 @@ bool KisKraSaver::saveAssistantsList(QDomDocument& doc, QDomElement& element)
 
 bool KisKraSaver::saveGrid(QDomDocument& doc, QDomElement& element)
 {
-    KisGridConfig config = m_d->doc->gridConfig();
+    KisGridConfig config = m_d->doc->savingGridConfig();
 
     if (!config.isDefault()) {
         QDomElement gridElement = config.saveDynamicDataToXml(doc, "grid");
@@ -412,7 +426,7 @@ bool KisKraSaver::saveGrid(QDomDocument& doc, QDomElement& element)
 
 bool KisKraSaver::saveGuides(QDomDocument& doc, QDomElement& element)
 {
-    KisGuidesConfig guides = m_d->doc->guidesConfig();
+    KisGuidesConfig guides = m_d->doc->savingGuidesConfig();
 
     if (guides.hasGuides()) {
         QDomElement guidesElement = guides.saveToXml(doc, "guides");
@@ -424,7 +438,7 @@ bool KisKraSaver::saveGuides(QDomDocument& doc, QDomElement& element)
 
 bool KisKraSaver::saveAudio(QDomDocument& doc, QDomElement& element)
 {
-    const KisImageAnimationInterface *interface = m_d->doc->image()->animationInterface();
+    const KisImageAnimationInterface *interface = m_d->doc->savingImage()->animationInterface();
     QString fileName = interface->audioChannelFileName();
     if (fileName.isEmpty()) return true;
 
@@ -28,6 +28,8 @@
 
 #include "KisDocument.h"
 #include "kis_image.h"
+#include "kis_paint_layer.h"
+#include "kis_undo_stores.h"
 #include "testutil.h"
 #include "KisPart.h"
 
@@ -168,5 +170,47 @@ void KisKraLoaderTest::testLoadAnimated()
     QCOMPARE(dev->defaultPixel(), red);
 }
 
+void KisKraLoaderTest::testLoadManyLayers()
+{
+    /**
+     * The pixel data of the layers is decoded in parallel, so check
+     * that every layer gets its own data back
+     */
+    const int numLayers = 100;
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+    QRect imageRect(0,0,512,512);
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(new KisSurrogateUndoStore(), imageRect.width(), imageRect.height(), cs, "test image");
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("paint%1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(QRect(i * 5, i * 3, 64 + i, 64), KoColor(Qt::black, cs));
+        layer->paintDevice()->setDefaultPixel(KoColor(QColor(i, 0, 0, 0), cs));
+        image->addNode(layer);
+    }
+
+    doc->setCurrentImage(image);
+    doc->exportDocument(QUrl::fromLocalFile("roundtrip_many_layers.kra"));
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+
+    QBENCHMARK_ONCE {
+        QVERIFY(doc2->loadNativeFormat("roundtrip_many_layers.kra"));
+    }
+
+    KisImageSP image2 = doc2->image();
+    QCOMPARE(image2->root()->childCount(), quint32(numLayers));
+
+    for (int i = 0; i < numLayers; i++) {
+        KisNodeSP node = TestUtil::findNode(image2->root(), QString("paint%1").arg(i));
+        QVERIFY(node);
+
+        KisPaintDeviceSP dev = node->paintDevice();
+        QCOMPARE(dev->nonDefaultPixelArea(), QRect(i * 5, i * 3, 64 + i, 64));
+        QCOMPARE(dev->defaultPixel(), KoColor(QColor(i, 0, 0, 0), cs));
+    }
+}
 
 QTEST_MAIN(KisKraLoaderTest)
@@ -32,6 +32,8 @@ private Q_SLOTS:
     void testObligeSingleChildNonTranspPixel();
 
     void testLoadAnimated();
+
+    void testLoadManyLayers();
 };
 
 #endif
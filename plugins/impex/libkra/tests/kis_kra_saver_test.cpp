@@ -21,6 +21,8 @@
 #include <QTest>
 
 #include <QBitArray>
+#include <QDir>
+#include <QFile>
 
 #include <KisDocument.h>
 #include <KoDocumentInfo.h>
@@ -56,6 +58,9 @@
 #include <generator/kis_generator_registry.h>
 
 #include <KoResourcePaths.h>
+#include "kis_config.h"
+#include <tiles3/kis_compressed_tiles_cache.h>
+#include "kis_guides_config.h"
 
 void KisKraSaverTest::initTestCase()
 {
@@ -135,6 +140,36 @@ void KisKraSaverTest::testSaveEmpty()
     delete doc;
 }
 
+void KisKraSaverTest::testSaveManyLayers()
+{
+    /**
+     * The pixel data of the layers is compressed in parallel,
+     * measure the time of the whole save
+     */
+    const int numLayers = 100;
+
+    QRect imageRect(0,0,512,512);
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(new KisSurrogateUndoStore(), imageRect.width(), imageRect.height(), cs, "test image");
+
+    for (int i = 0; i < numLayers; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("paint%1").arg(i), OPACITY_OPAQUE_U8);
+        layer->paintDevice()->fill(QRect(i * 5, i * 3, 64 + i, 64), KoColor(Qt::black, cs));
+        image->addNode(layer);
+    }
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(image);
+
+    QBENCHMARK_ONCE {
+        QVERIFY(doc->exportDocument(QUrl::fromLocalFile("save_many_layers.kra")));
+    }
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(doc2->loadNativeFormat("save_many_layers.kra"));
+    QCOMPARE(doc2->image()->root()->childCount(), quint32(numLayers));
+}
+
 #include <filter/kis_filter_configuration.h>
 #include "generator/kis_generator_registry.h"
 #include <generator/kis_generator.h>
@@ -546,4 +581,123 @@ void KisKraSaverTest::testRoundTripShapeSelection()
     QVERIFY(chk.testPassed());
 }
 
+void KisKraSaverTest::testIncrementalAutosave()
+{
+    KisConfig cfg;
+    const bool oldIncrementalAutosave = cfg.incrementalAutosave();
+    cfg.setIncrementalAutosave(true);
+
+    TestUtil::MaskParent p;
+    const KoColorSpace *cs = p.layer->colorSpace();
+    p.layer->paintDevice()->fill(QRect(0, 0, 256, 256), KoColor(Qt::red, cs));
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(p.image);
+    doc->setLocalFilePath(QDir::current().absoluteFilePath("incremental_autosave_test.kra"));
+
+    const QString autosaveFileName =
+        QDir::current().absoluteFilePath(".incremental_autosave_test.kra-autosave.kra");
+
+    doc->setModified(true);
+    QMetaObject::invokeMethod(doc.data(), "slotAutoSave");
+
+    QVERIFY(QFile::exists(autosaveFileName));
+    QVERIFY(doc->autosaveTilesCache());
+    QVERIFY(doc->autosaveTilesCache()->size() > 0);
+    QCOMPARE(doc->autosaveTilesCache()->numFetchedTiles(), 0);
+    QCOMPARE(doc->autosaveTilesCache()->numAddedTiles(), 16);
+
+    // change one of the saved tiles and add 9 new ones
+    p.layer->paintDevice()->fill(QRect(0, 0, 10, 10), KoColor(Qt::blue, cs));
+    p.layer->paintDevice()->fill(QRect(300, 300, 100, 100), KoColor(Qt::blue, cs));
+
+    doc->setModified(true);
+    QMetaObject::invokeMethod(doc.data(), "slotAutoSave");
+
+    // the second autosave takes the unchanged tiles from the cache
+    QCOMPARE(doc->autosaveTilesCache()->numFetchedTiles(), 15);
+    QCOMPARE(doc->autosaveTilesCache()->numAddedTiles(), 10);
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(doc2->loadNativeFormat(autosaveFileName));
+
+    KisNodeSP node = TestUtil::findNode(doc2->image()->root(), p.layer->name());
+    QVERIFY(node);
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, p.layer->paintDevice(), node->paintDevice()));
+
+    QFile::remove(autosaveFileName);
+    cfg.setIncrementalAutosave(oldIncrementalAutosave);
+}
+
+void KisKraSaverTest::testRoundTripProfiledDefaultPixel()
+{
+    const KoColorSpace *linearCs = KoColorSpaceRegistry::instance()->rgb16("scRGB (linear)");
+    if (!linearCs) {
+        QSKIP("The linear RGB profile is not available");
+    }
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 100, 100, cs, "profiled default pixel test");
+
+    KisPaintLayerSP layer = new KisPaintLayer(image, "profiled", OPACITY_OPAQUE_U8, linearCs);
+    layer->paintDevice()->setDefaultPixel(KoColor(QColor(200, 100, 50), linearCs));
+    layer->paintDevice()->fill(QRect(10, 10, 20, 20), KoColor(Qt::blue, linearCs));
+    image->addNode(layer, image->root());
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(image);
+    QVERIFY(doc->exportDocument(QUrl::fromLocalFile("roundtrip_profiled_default_pixel.kra")));
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(doc2->loadNativeFormat("roundtrip_profiled_default_pixel.kra"));
+
+    KisNodeSP node = TestUtil::findNode(doc2->image()->root(), "profiled");
+    QVERIFY(node);
+
+    // the default pixel is loaded bit-exact, not converted into the embedded profile
+    QVERIFY(*node->paintDevice()->colorSpace()->profile() == *linearCs->profile());
+    QCOMPARE(node->paintDevice()->defaultPixel(), layer->paintDevice()->defaultPixel());
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, layer->paintDevice(), node->paintDevice()));
+}
+
+void KisKraSaverTest::testBackgroundSavingDocumentState()
+{
+    KisConfig cfg;
+    const bool oldBackgroundSaving = cfg.backgroundSaving();
+    cfg.setBackgroundSaving(true);
+
+    TestUtil::MaskParent p;
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    doc->setCurrentImage(p.image);
+    doc->documentInfo()->setAboutInfo("title", "background saving test");
+
+    KisGuidesConfig guides;
+    guides.addGuideLine(Qt::Horizontal, 10.0);
+    guides.addGuideLine(Qt::Vertical, 20.0);
+    doc->setGuidesConfig(guides);
+
+    const int editingCycles = doc->documentInfo()->aboutInfo("editing-cycles").toInt();
+
+    QVERIFY(doc->exportDocument(QUrl::fromLocalFile("background_saving_state_test.kra")));
+
+    // the saving state is released and the editing cycles are passed back
+    QVERIFY(!doc->savingImage());
+    QVERIFY(!doc->savingDocumentInfo());
+    QCOMPARE(doc->documentInfo()->aboutInfo("editing-cycles").toInt(), editingCycles + 1);
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(doc2->loadNativeFormat("background_saving_state_test.kra"));
+
+    QCOMPARE(doc2->documentInfo()->aboutInfo("title"), QString("background saving test"));
+    QCOMPARE(doc2->guidesConfig().horizontalGuideLines(), guides.horizontalGuideLines());
+    QCOMPARE(doc2->guidesConfig().verticalGuideLines(), guides.verticalGuideLines());
+
+    cfg.setBackgroundSaving(oldBackgroundSaving);
+}
+
 QTEST_MAIN(KisKraSaverTest)
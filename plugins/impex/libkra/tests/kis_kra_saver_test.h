@@ -34,6 +34,7 @@ private Q_SLOTS:
     void testRoundTrip();
 
     void testSaveEmpty();
+    void testSaveManyLayers();
     void testRoundTripFillLayerColor();
     void testRoundTripFillLayerPattern();
 
@@ -46,6 +47,12 @@ private Q_SLOTS:
     void testRoundTripShapeLayer();
     void testRoundTripShapeSelection();
 
+    void testIncrementalAutosave();
+
+    void testRoundTripProfiledDefaultPixel();
+
+    void testBackgroundSavingDocumentState();
+
 };
 
 #endif
@@ -184,7 +184,7 @@ private:
 
 
 VideoSaver::VideoSaver(KisDocument *doc, const QString &ffmpegPath, bool batchMode)
-    : m_image(doc->image())
+    : m_image(doc->savingImage())
     , m_doc(doc)
     , m_batchMode(batchMode)
     , m_ffmpegPath(ffmpegPath)
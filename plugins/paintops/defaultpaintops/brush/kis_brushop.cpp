@@ -24,6 +24,7 @@
 #include "kis_brushop.h"
 
 #include <QRect>
+#include <QThreadPool>
 
 #include <kis_image.h>
 #include <kis_vec.h>
@@ -41,10 +42,13 @@
 #include <kis_pressure_sharpness_option.h>
 #include <kis_fixed_paint_device.h>
 #include <kis_lod_transform.h>
+#include <kis_assert.h>
 
 
 KisBrushOp::KisBrushOp(const KisPaintOpSettingsSP settings, KisPainter *painter, KisNodeSP node, KisImageSP image)
     : KisBrushBasedPaintOp(settings, painter)
+    , m_queueDabs(false)
+    , m_maxQueuedDabs(QThreadPool::globalInstance()->maxThreadCount())
     , m_opacityOption(node)
     , m_hsvTransformation(0)
 {
@@ -132,10 +136,10 @@ KisSpacingInformation KisBrushOp::paintAt(const KisPaintInformation& info)
                               brush->maskWidth(shape, 0, 0, info),
                               brush->maskHeight(shape, 0, 0, info));
 
-    quint8 origOpacity = painter()->opacity();
-
     m_opacityOption.setFlow(m_flowOption.apply(info));
-    m_opacityOption.apply(painter(), info);
+    const quint8 dabOpacity = m_opacityOption.calculateOpacity(info);
+    const quint8 dabFlow = quint8(m_opacityOption.getFlow() * 255.0);
+
     m_colorSource->selectColor(m_mixOption.apply(info), info);
     m_darkenOption.apply(m_colorSource, info);
 
@@ -146,6 +150,34 @@ KisSpacingInformation KisBrushOp::paintAt(const KisPaintInformation& info)
         m_colorSource->applyColorTransformation(m_hsvTransformation);
     }
 
+    if (m_queueDabs && m_dabCache->canQueueDabs(m_colorSource)) {
+        m_dabCache->queueDab(device->compositionSourceColorSpace(),
+                             m_colorSource,
+                             cursorPos,
+                             shape,
+                             info,
+                             m_softnessOption.apply(info));
+
+        QueuedDabOpacity opacity;
+        opacity.opacity = dabOpacity;
+        opacity.flow = dabFlow;
+        m_queuedDabOpacities.append(opacity);
+
+        if (m_dabCache->numQueuedDabs() >= m_maxQueuedDabs) {
+            paintQueuedDabs();
+        }
+
+        return effectiveSpacing(scale, rotation, &m_airbrushOption, &m_spacingOption, &m_rateOption,
+                                info);
+    }
+
+    // the dabs queued before must be painted first
+    paintQueuedDabs();
+
+    quint8 origOpacity = painter()->opacity();
+    painter()->setOpacityUpdateAverage(dabOpacity);
+    painter()->setFlow(dabFlow);
+
     QRect dabRect;
     KisFixedPaintDeviceSP dab = m_dabCache->fetchDab(device->compositionSourceColorSpace(),
                                 m_colorSource,
@@ -191,7 +223,57 @@ void KisBrushOp::paintLine(const KisPaintInformation& pi1, const KisPaintInforma
     //fixes Bug 338011
     painter()->renderMirrorMask(rc, m_lineCacheDevice);
     }
+    else if (m_queueDabs || m_maxQueuedDabs <= 1) {
+        KisPaintOp::paintLine(pi1, pi2, currentDistance);
+    }
     else {
+        /**
+         * The masks of the dabs of the line are generated concurrently
+         * in batches, but they are composited strictly in the order
+         * of the stroke, so the result is the same as if the dabs were
+         * painted one by one.
+         */
+        m_queueDabs = true;
         KisPaintOp::paintLine(pi1, pi2, currentDistance);
+        m_queueDabs = false;
+
+        paintQueuedDabs();
     }
 }
+
+void KisBrushOp::paintQueuedDabs()
+{
+    if (!m_dabCache->numQueuedDabs()) return;
+
+    QVector<KisFixedPaintDeviceSP> dabs;
+    QVector<QRect> dabRects;
+    m_dabCache->fetchQueuedDabs(&dabs, &dabRects);
+
+    KIS_ASSERT_RECOVER(dabs.size() == m_queuedDabOpacities.size()) {
+        m_queuedDabOpacities.clear();
+        return;
+    }
+
+    quint8 origOpacity = painter()->opacity();
+
+    for (int i = 0; i < dabs.size(); i++) {
+        const KisFixedPaintDeviceSP dab = dabs[i];
+        const QRect &dabRect = dabRects[i];
+
+        // sanity check for the size calculation code
+        if (dab->bounds().size() != dabRect.size()) {
+            warnKrita << "KisBrushOp: dab bounds is not dab rect. See bug 327156" << dab->bounds().size() << dabRect.size();
+        }
+
+        painter()->setOpacityUpdateAverage(m_queuedDabOpacities[i].opacity);
+        painter()->setFlow(m_queuedDabOpacities[i].flow);
+
+        painter()->bltFixed(dabRect.topLeft(), dab, dab->bounds());
+
+        // the same dab may be used several times in the batch
+        painter()->renderMirrorMaskSafe(dabRect, dab, true);
+        painter()->setOpacity(origOpacity);
+    }
+
+    m_queuedDabOpacities.clear();
+}
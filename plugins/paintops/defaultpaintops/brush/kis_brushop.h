@@ -57,6 +57,24 @@ public:
     void paintLine(const KisPaintInformation &pi1, const KisPaintInformation &pi2, KisDistanceInformation *currentDistance) override;
 
 private:
+    void paintQueuedDabs();
+
+private:
+    /**
+     * Opacity and flow of a dab waiting in the queue of the dab
+     * cache. They are applied to the painter only when the dab is
+     * composited, because the painter averages the opacity over the
+     * sequence of dabs.
+     */
+    struct QueuedDabOpacity {
+        quint8 opacity;
+        quint8 flow;
+    };
+
+    bool m_queueDabs;
+    int m_maxQueuedDabs;
+    QVector<QueuedDabOpacity> m_queuedDabOpacities;
+
     KisColorSource *m_colorSource;
     KisAirbrushOption m_airbrushOption;
     KisPressureSizeOption m_sizeOption;
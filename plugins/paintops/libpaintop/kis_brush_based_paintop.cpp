@@ -181,3 +181,13 @@ bool KisBrushBasedPaintOp::canPaint() const
 {
     return m_brush != 0;
 }
+
+qreal KisBrushBasedPaintOp::dabCacheHitRate() const
+{
+    return m_dabCache->cacheHitRate();
+}
+
+qint64 KisBrushBasedPaintOp::dabGenerationTime() const
+{
+    return m_dabCache->dabGenerationTime();
+}
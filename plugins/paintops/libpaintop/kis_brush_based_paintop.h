@@ -81,6 +81,9 @@ public:
     ///Reimplemented, false if brush is 0
     bool canPaint() const override;
 
+    qreal dabCacheHitRate() const override;
+    qint64 dabGenerationTime() const override;
+
 #ifdef HAVE_THREADED_TEXT_RENDERING_WORKAROUND
     typedef int needs_preinitialization;
     static void preinitializeOpStatically(KisPaintOpSettingsSP settings);
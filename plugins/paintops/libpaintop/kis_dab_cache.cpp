@@ -22,15 +22,26 @@
 #include "kis_color_source.h"
 #include "kis_paint_device.h"
 #include "kis_brush.h"
+#include "kis_auto_brush.h"
 #include <kis_pressure_mirror_option.h>
 #include <kis_pressure_sharpness_option.h>
 #include <kis_texture_option.h>
 #include <kis_precision_option.h>
 #include <kis_fixed_paint_device.h>
 #include <brushengine/kis_paintop.h>
+#include <kis_assert.h>
+#include <kis_debug.h>
+#include <KoColorSpace.h>
 
 #include <kundo2command.h>
 
+#include <cmath>
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QtConcurrentMap>
+
 struct PrecisionValues {
     qreal angle;
     qreal sizeFrac;
@@ -47,6 +58,67 @@ static const PrecisionValues precisionLevels[] = {
     {eps,         0, eps,  eps}
 };
 
+/**
+ * The key of a dab in the cache. All the parameters are quantized
+ * with the steps defined by the precision level, so the dabs falling
+ * into the same bucket are considered equal.
+ */
+struct DabCacheKey {
+    KoColor color;
+    int angle;
+    int width;
+    int height;
+    int subPixelX;
+    int subPixelY;
+    int softnessFactor;
+    int index;
+    bool horizontalMirror;
+    bool verticalMirror;
+
+    bool operator==(const DabCacheKey &rhs) const {
+        return angle == rhs.angle &&
+               width == rhs.width &&
+               height == rhs.height &&
+               subPixelX == rhs.subPixelX &&
+               subPixelY == rhs.subPixelY &&
+               softnessFactor == rhs.softnessFactor &&
+               index == rhs.index &&
+               horizontalMirror == rhs.horizontalMirror &&
+               verticalMirror == rhs.verticalMirror &&
+               color == rhs.color;
+    }
+};
+
+inline uint qHash(const DabCacheKey &key, uint seed = 0)
+{
+    uint hash = qHashBits(key.color.data(), key.color.colorSpace()->pixelSize(), seed);
+
+    hash = 31 * hash + uint(key.angle);
+    hash = 31 * hash + uint(key.width);
+    hash = 31 * hash + uint(key.height);
+    hash = 31 * hash + uint(key.subPixelX);
+    hash = 31 * hash + uint(key.subPixelY);
+    hash = 31 * hash + uint(key.softnessFactor);
+    hash = 31 * hash + uint(key.index);
+    hash = 31 * hash + uint(key.horizontalMirror) + 2 * uint(key.verticalMirror);
+
+    return hash;
+}
+
+inline int quantize(qreal value, qreal step)
+{
+    return qRound(value / step);
+}
+
+/**
+ * The sizes are compared relatively, so they are quantized in the
+ * logarithmic scale
+ */
+inline int quantizeSize(int size, qreal sizeFrac)
+{
+    return sizeFrac > 0 ? qRound(std::log(qMax(size, 1)) / std::log1p(sizeFrac)) : size;
+}
+
 struct KisDabCache::SavedDabParameters {
     KoColor color;
     qreal angle;
@@ -72,8 +144,81 @@ struct KisDabCache::SavedDabParameters {
                mirrorProperties.horizontalMirror == rhs.mirrorProperties.horizontalMirror &&
                mirrorProperties.verticalMirror == rhs.mirrorProperties.verticalMirror;
     }
+
+    DabCacheKey key(int precisionLevel) const {
+        const PrecisionValues &prec = precisionLevels[precisionLevel];
+
+        DabCacheKey key;
+        key.color = color;
+        key.angle = quantize(angle, prec.angle);
+        key.width = quantizeSize(width, prec.sizeFrac);
+        key.height = quantizeSize(height, prec.sizeFrac);
+        key.subPixelX = quantize(subPixelX, prec.subPixel);
+        key.subPixelY = quantize(subPixelY, prec.subPixel);
+        key.softnessFactor = quantize(softnessFactor, prec.softnessFactor);
+        key.index = index;
+        key.horizontalMirror = mirrorProperties.horizontalMirror;
+        key.verticalMirror = mirrorProperties.verticalMirror;
+        return key;
+    }
+};
+
+struct KisDabCache::CachedDab {
+    CachedDab(KisFixedPaintDeviceSP _dab, const SavedDabParameters &_params)
+        : dab(_dab), params(_params) {}
+
+    KisFixedPaintDeviceSP dab;
+    SavedDabParameters params;
+};
+
+struct KisDabCache::QueuedDab {
+    const KoColorSpace *cs;
+    KoColor color;
+    KisDabShape shape;
+    KisPaintInformation info;
+    QRect dabRect;
+    QPointF subPixel;
+    qreal softnessFactor;
+    MirrorProperties mirrorProperties;
+
+    /**
+     * The parameters of the dab that will actually be painted, they
+     * may differ from the requested ones within the precision level
+     */
+    SavedDabParameters params;
+
+    /**
+     * The index of the queued dab whose mask is reused by this one,
+     * -1 if the mask is taken from the cache or generated
+     */
+    int sourceIndex;
+
+    /**
+     * The mask of the dab is missing in the cache and will be
+     * generated
+     */
+    bool isPending;
+
+    KisFixedPaintDeviceSP dab;
 };
 
+struct KisDabCache::QueuedDabGenerator {
+    QueuedDabGenerator(KisDabCache *cache)
+        : m_cache(cache) {}
+
+    inline void operator() (QueuedDab *queuedDab) {
+        m_cache->generateQueuedDab(queuedDab);
+    }
+
+    KisDabCache *m_cache;
+};
+
+/**
+ * The maximum amount of memory occupied by the dabs stored in the
+ * cache of a single paintop
+ */
+static const int maxCachedDabsMemory = 16 * 1024 * 1024;
+
 struct KisDabCache::Private {
 
     Private(KisBrushSP brush)
@@ -83,10 +228,29 @@ struct KisDabCache::Private {
           textureOption(0),
           precisionOption(0),
           subPixelPrecisionDisabled(false),
-          cachedDabParameters(new SavedDabParameters)
+          cachedDabs(maxCachedDabsMemory),
+          cachedDabsColorSpace(0),
+          cacheHits(0),
+          cacheMisses(0),
+          dabGenerationTime(0)
     {}
+
+    /**
+     * The dab returned by the last fetch. It may be shared with the
+     * cache, so it must never be written into.
+     */
     KisFixedPaintDeviceSP dab;
-    KisFixedPaintDeviceSP dabOriginal;
+
+    /**
+     * The device the cached dabs are copied into when they need
+     * postprocessing
+     */
+    KisFixedPaintDeviceSP postprocessedDab;
+
+    /**
+     * The device for the dabs that cannot be cached
+     */
+    KisFixedPaintDeviceSP uncachedDab;
 
     KisBrushSP brush;
     KisPaintDeviceSP colorSourceDevice;
@@ -97,7 +261,34 @@ struct KisDabCache::Private {
     KisPrecisionOption *precisionOption;
     bool subPixelPrecisionDisabled;
 
-    SavedDabParameters *cachedDabParameters;
+    /**
+     * The last cached dab used. It is checked first, since the
+     * consequent dabs of a stroke are usually very similar.
+     */
+    KisFixedPaintDeviceSP lastCachedDab;
+    SavedDabParameters lastCachedDabParameters;
+
+    QCache<DabCacheKey, CachedDab> cachedDabs;
+    const KoColorSpace *cachedDabsColorSpace;
+
+    int cacheHits;
+    int cacheMisses;
+    qint64 dabGenerationTime;
+
+    QVector<QueuedDab> queuedDabs;
+
+    /**
+     * The queued dabs that are going to be generated, used for
+     * finding the duplicates within a batch
+     */
+    QHash<DabCacheKey, int> pendingDabs;
+
+    /**
+     * The brush changes its state while generating the mask, so
+     * every worker thread needs a brush of its own
+     */
+    QVector<KisBrushSP> brushClones;
+    QMutex brushClonesLock;
 };
 
 
@@ -109,7 +300,6 @@ KisDabCache::KisDabCache(KisBrushSP brush)
 
 KisDabCache::~KisDabCache()
 {
-    delete m_d->cachedDabParameters;
     delete m_d;
 }
 
@@ -138,6 +328,17 @@ void KisDabCache::disableSubpixelPrecision()
     m_d->subPixelPrecisionDisabled = true;
 }
 
+qreal KisDabCache::cacheHitRate() const
+{
+    const int numDabs = m_d->cacheHits + m_d->cacheMisses;
+    return numDabs ? qreal(m_d->cacheHits) / numDabs : 0.0;
+}
+
+qint64 KisDabCache::dabGenerationTime() const
+{
+    return m_d->dabGenerationTime;
+}
+
 inline KisDabCache::SavedDabParameters
 KisDabCache::getDabParameters(const KoColor& color,
                               KisDabShape const& shape,
@@ -224,28 +425,77 @@ QRect KisDabCache::correctDabRectWhenFetchedFromCache(const QRect &dabRect,
                  realDabSize.width() , realDabSize.height());
 }
 
-inline
-KisFixedPaintDeviceSP KisDabCache::tryFetchFromCache(const SavedDabParameters &params,
-        const KisPaintInformation& info,
-        QRect *dstDabRect)
+inline int KisDabCache::precisionLevel() const
 {
-    int precisionLevel = m_d->precisionOption ? m_d->precisionOption->precisionLevel() - 1 : 3;
+    return m_d->precisionOption ? m_d->precisionOption->precisionLevel() - 1 : 3;
+}
 
-    if (!params.compare(*m_d->cachedDabParameters, precisionLevel)) {
+inline
+KisFixedPaintDeviceSP KisDabCache::findCachedDab(const KoColorSpace *cs,
+        const SavedDabParameters &params)
+{
+    if (!m_d->cachedDabsColorSpace || *m_d->cachedDabsColorSpace != *cs) {
+        m_d->cachedDabs.clear();
+        m_d->lastCachedDab = 0;
+        m_d->cachedDabsColorSpace = cs;
         return 0;
     }
 
-    if (needSeparateOriginal()) {
-        *m_d->dab = *m_d->dabOriginal;
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
-        postProcessDab(m_d->dab, dstDabRect->topLeft(), info);
+    const int level = precisionLevel();
+
+    if (m_d->lastCachedDab &&
+        params.compare(m_d->lastCachedDabParameters, level)) {
+
+        return m_d->lastCachedDab;
     }
-    else {
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
+
+    CachedDab *cachedDab = m_d->cachedDabs.object(params.key(level));
+    if (!cachedDab) return 0;
+
+    m_d->lastCachedDab = cachedDab->dab;
+    m_d->lastCachedDabParameters = cachedDab->params;
+
+    return cachedDab->dab;
+}
+
+inline
+void KisDabCache::addCachedDab(KisFixedPaintDeviceSP dab,
+                               const SavedDabParameters &params)
+{
+    const QRect bounds = dab->bounds();
+    const int cost = bounds.width() * bounds.height() * dab->pixelSize();
+
+    m_d->cachedDabs.insert(params.key(precisionLevel()),
+                           new CachedDab(dab, params),
+                           cost);
+
+    m_d->lastCachedDab = dab;
+    m_d->lastCachedDabParameters = params;
+}
+
+inline
+KisFixedPaintDeviceSP KisDabCache::postProcessCachedDab(KisFixedPaintDeviceSP dab,
+        const KisPaintInformation& info,
+        QRect *dstDabRect)
+{
+    *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, dab->bounds().size());
+
+    /**
+     * The cached dabs are shared, so the postprocessing happens in
+     * a copy of the dab
+     */
+    if (needSeparateOriginal()) {
+        if (!m_d->postprocessedDab || *m_d->postprocessedDab->colorSpace() != *dab->colorSpace()) {
+            m_d->postprocessedDab = new KisFixedPaintDevice(dab->colorSpace());
+        }
+
+        *m_d->postprocessedDab = *dab;
+        postProcessDab(m_d->postprocessedDab, dstDabRect->topLeft(), info);
+        dab = m_d->postprocessedDab;
     }
 
-    m_d->brush->notifyCachedDabPainted(info);
-    return m_d->dab;
+    m_d->dab = dab;
+    return dab;
 }
 
 qreal positiveFraction(qreal x) {
@@ -338,40 +588,64 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
     shape = KisDabShape(shape.scale(), shape.ratio(), position.realAngle);
     *dstDabRect = position.rect;
 
-    bool cachingIsPossible = !colorSource || colorSource->isUniformColor();
-    KoColor paintColor = colorSource && colorSource->isUniformColor() ?
-                         colorSource->uniformColor() : color;
+    const bool isImageBrush =
+        m_d->brush->brushType() == IMAGE ||
+        m_d->brush->brushType() == PIPE_IMAGE;
 
-    SavedDabParameters newParams = getDabParameters(paintColor,
-                                   shape, info,
-                                   position.subPixel.x(),
-                                   position.subPixel.y(),
-                                   softnessFactor,
-                                   mirrorProperties);
+    bool cachingIsPossible =
+        !isImageBrush &&
+        (!colorSource || colorSource->isUniformColor());
 
-    if (!m_d->dab || *m_d->dab->colorSpace() != *cs) {
-        m_d->dab = new KisFixedPaintDevice(cs);
-    }
-    else if (cachingIsPossible) {
-        KisFixedPaintDeviceSP cachedDab =
-            tryFetchFromCache(newParams, info, dstDabRect);
+    if (cachingIsPossible) {
+        KoColor paintColor = colorSource ? colorSource->uniformColor() : color;
 
-        if (cachedDab) return cachedDab;
-    }
+        SavedDabParameters newParams = getDabParameters(paintColor,
+                                       shape, info,
+                                       position.subPixel.x(),
+                                       position.subPixel.y(),
+                                       softnessFactor,
+                                       mirrorProperties);
 
-    if (m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE) {
-        m_d->dab = m_d->brush->paintDevice(cs, shape, info,
-                                           position.subPixel.x(),
-                                           position.subPixel.y());
-    }
-    else if (cachingIsPossible) {
-        *m_d->cachedDabParameters = newParams;
-        m_d->brush->mask(m_d->dab, paintColor, shape,
+        KisFixedPaintDeviceSP cachedDab = findCachedDab(cs, newParams);
+
+        if (cachedDab) {
+            m_d->cacheHits++;
+            m_d->brush->notifyCachedDabPainted(info);
+            return postProcessCachedDab(cachedDab, info, dstDabRect);
+        }
+
+        m_d->cacheMisses++;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+        m_d->brush->mask(dab, paintColor, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
+
+        if (!mirrorProperties.isEmpty()) {
+            dab->mirror(mirrorProperties.horizontalMirror,
+                        mirrorProperties.verticalMirror);
+        }
+
+        m_d->dabGenerationTime += timer.nsecsElapsed();
+
+        addCachedDab(dab, newParams);
+        return postProcessCachedDab(dab, info, dstDabRect);
+    }
+
+    if (isImageBrush) {
+        m_d->uncachedDab = m_d->brush->paintDevice(cs, shape, info,
+                                                   position.subPixel.x(),
+                                                   position.subPixel.y());
     }
     else {
+        if (!m_d->uncachedDab || *m_d->uncachedDab->colorSpace() != *cs) {
+            m_d->uncachedDab = new KisFixedPaintDevice(cs);
+        }
+
         if (!m_d->colorSourceDevice || *cs != *m_d->colorSourceDevice->colorSpace()) {
             m_d->colorSourceDevice = new KisPaintDevice(cs);
         }
@@ -383,27 +657,20 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
         colorSource->colorize(m_d->colorSourceDevice, maskRect, info.pos().toPoint());
         delete m_d->colorSourceDevice->convertTo(cs);
 
-        m_d->brush->mask(m_d->dab, m_d->colorSourceDevice, shape,
+        m_d->brush->mask(m_d->uncachedDab, m_d->colorSourceDevice, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
     }
 
     if (!mirrorProperties.isEmpty()) {
-        m_d->dab->mirror(mirrorProperties.horizontalMirror,
-                         mirrorProperties.verticalMirror);
-    }
-
-    if (needSeparateOriginal()) {
-        if (!m_d->dabOriginal || *cs != *m_d->dabOriginal->colorSpace()) {
-            m_d->dabOriginal = new KisFixedPaintDevice(cs);
-        }
-
-        *m_d->dabOriginal = *m_d->dab;
+        m_d->uncachedDab->mirror(mirrorProperties.horizontalMirror,
+                                 mirrorProperties.verticalMirror);
     }
 
-    postProcessDab(m_d->dab, position.rect.topLeft(), info);
+    postProcessDab(m_d->uncachedDab, position.rect.topLeft(), info);
 
+    m_d->dab = m_d->uncachedDab;
     return m_d->dab;
 }
 
@@ -419,3 +686,183 @@ void KisDabCache::postProcessDab(KisFixedPaintDeviceSP dab,
         m_d->textureOption->apply(dab, dabTopLeft, info);
     }
 }
+
+bool KisDabCache::canQueueDabs(const KisColorSource *colorSource)
+{
+    return m_d->brush->brushType() == MASK &&
+        dynamic_cast<KisAutoBrush*>(m_d->brush.data()) &&
+        !needSeparateOriginal() &&
+        colorSource && colorSource->isUniformColor();
+}
+
+void KisDabCache::queueDab(const KoColorSpace *cs,
+                           const KisColorSource *colorSource,
+                           const QPointF &cursorPoint,
+                           KisDabShape const& shape,
+                           const KisPaintInformation& info,
+                           qreal softnessFactor)
+{
+    KIS_ASSERT_RECOVER_RETURN(canQueueDabs(colorSource));
+
+    QueuedDab queuedDab;
+
+    if (m_d->mirrorOption) {
+        queuedDab.mirrorProperties = m_d->mirrorOption->apply(info);
+    }
+
+    DabPosition position = calculateDabRect(cursorPoint,
+                                            shape,
+                                            info,
+                                            queuedDab.mirrorProperties);
+
+    queuedDab.cs = cs;
+    queuedDab.color = colorSource->uniformColor();
+    queuedDab.shape = KisDabShape(shape.scale(), shape.ratio(), position.realAngle);
+    queuedDab.info = info;
+    queuedDab.dabRect = position.rect;
+    queuedDab.subPixel = position.subPixel;
+    queuedDab.softnessFactor = softnessFactor;
+    queuedDab.sourceIndex = -1;
+    queuedDab.isPending = false;
+
+    SavedDabParameters newParams = getDabParameters(queuedDab.color,
+                                   queuedDab.shape, info,
+                                   position.subPixel.x(),
+                                   position.subPixel.y(),
+                                   softnessFactor,
+                                   queuedDab.mirrorProperties);
+
+    const int level = precisionLevel();
+
+    /**
+     * First check if the mask of some dab waiting in the queue can
+     * be reused, then look into the cache
+     */
+    int sourceIndex = -1;
+
+    if (!m_d->queuedDabs.isEmpty()) {
+        const QueuedDab &lastDab = m_d->queuedDabs.last();
+        const int lastSourceIndex =
+            lastDab.sourceIndex >= 0 ? lastDab.sourceIndex : m_d->queuedDabs.size() - 1;
+
+        if (newParams.compare(m_d->queuedDabs[lastSourceIndex].params, level)) {
+            sourceIndex = lastSourceIndex;
+        }
+    }
+
+    if (sourceIndex < 0) {
+        sourceIndex = m_d->pendingDabs.value(newParams.key(level), -1);
+    }
+
+    if (sourceIndex >= 0) {
+        const QueuedDab &sourceDab = m_d->queuedDabs[sourceIndex];
+
+        queuedDab.params = sourceDab.params;
+        queuedDab.dab = sourceDab.dab;
+        queuedDab.sourceIndex = sourceDab.dab ? -1 : sourceIndex;
+        m_d->cacheHits++;
+    } else {
+        KisFixedPaintDeviceSP cachedDab = findCachedDab(cs, newParams);
+
+        if (cachedDab) {
+            queuedDab.params = m_d->lastCachedDabParameters;
+            queuedDab.dab = cachedDab;
+            m_d->cacheHits++;
+        } else {
+            queuedDab.params = newParams;
+            queuedDab.isPending = true;
+            m_d->pendingDabs.insert(newParams.key(level), m_d->queuedDabs.size());
+            m_d->cacheMisses++;
+        }
+    }
+
+    m_d->queuedDabs.append(queuedDab);
+}
+
+int KisDabCache::numQueuedDabs() const
+{
+    return m_d->queuedDabs.size();
+}
+
+void KisDabCache::fetchQueuedDabs(QVector<KisFixedPaintDeviceSP> *dabs,
+                                  QVector<QRect> *dabRects)
+{
+    QVector<QueuedDab*> jobs;
+
+    for (auto it = m_d->queuedDabs.begin(); it != m_d->queuedDabs.end(); ++it) {
+        if (it->isPending) {
+            jobs.append(&(*it));
+        }
+    }
+
+    if (jobs.size() > 1) {
+        QueuedDabGenerator generator(this);
+        QtConcurrent::blockingMap(jobs, generator);
+    } else if (!jobs.isEmpty()) {
+        generateQueuedDab(jobs.first());
+    }
+
+    Q_FOREACH (QueuedDab *queuedDab, jobs) {
+        addCachedDab(queuedDab->dab, queuedDab->params);
+    }
+
+    for (auto it = m_d->queuedDabs.begin(); it != m_d->queuedDabs.end(); ++it) {
+        if (it->sourceIndex >= 0) {
+            it->dab = m_d->queuedDabs[it->sourceIndex].dab;
+        }
+
+        if (!it->isPending) {
+            m_d->brush->notifyCachedDabPainted(it->info);
+        }
+
+        dabs->append(it->dab);
+        dabRects->append(correctDabRectWhenFetchedFromCache(it->dabRect,
+                                                            it->dab->bounds().size()));
+    }
+
+    if (!m_d->queuedDabs.isEmpty()) {
+        const QueuedDab &lastDab = m_d->queuedDabs.last();
+
+        m_d->dab = lastDab.dab;
+        m_d->lastCachedDab = lastDab.dab;
+        m_d->lastCachedDabParameters = lastDab.params;
+    }
+
+    m_d->queuedDabs.clear();
+    m_d->pendingDabs.clear();
+}
+
+void KisDabCache::generateQueuedDab(QueuedDab *queuedDab)
+{
+    KisBrushSP brush;
+
+    {
+        QMutexLocker l(&m_d->brushClonesLock);
+        brush = !m_d->brushClones.isEmpty() ?
+            m_d->brushClones.takeLast() :
+            KisBrushSP(m_d->brush->clone());
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    queuedDab->dab = new KisFixedPaintDevice(queuedDab->cs);
+
+    brush->mask(queuedDab->dab, queuedDab->color, queuedDab->shape,
+                queuedDab->info,
+                queuedDab->subPixel.x(), queuedDab->subPixel.y(),
+                queuedDab->softnessFactor);
+
+    if (!queuedDab->mirrorProperties.isEmpty()) {
+        queuedDab->dab->mirror(queuedDab->mirrorProperties.horizontalMirror,
+                               queuedDab->mirrorProperties.verticalMirror);
+    }
+
+    const qint64 dabTime = timer.nsecsElapsed();
+
+    {
+        QMutexLocker l(&m_d->brushClonesLock);
+        m_d->brushClones.append(brush);
+        m_d->dabGenerationTime += dabTime;
+    }
+}
@@ -48,6 +48,13 @@ struct MirrorProperties;
  *  level.
  *
  *  The texturing and mirroring problems are solved.
+ *
+ *  The cache keeps not only the last dab, but a number of recently used
+ *  ones, so the strokes with rotation or pressure jitter can reuse the
+ *  masks generated before. The dabs are looked up by their parameters
+ *  quantized with the steps defined by the precision level. The memory
+ *  occupied by the cached dabs is limited, the least recently used dabs
+ *  are dropped first.
  */
 class PAINTOP_EXPORT KisDabCache
 {
@@ -70,6 +77,17 @@ public:
 
     bool needSeparateOriginal();
 
+    /**
+     * The share of the dabs fetched without generating a new mask
+     */
+    qreal cacheHitRate() const;
+
+    /**
+     * Total time spent on generating the masks of the dabs, in
+     * nanoseconds
+     */
+    qint64 dabGenerationTime() const;
+
     KisFixedPaintDeviceSP fetchDab(const KoColorSpace *cs,
                                    const KisColorSource *colorSource,
                                    const QPointF &cursorPoint,
@@ -86,11 +104,49 @@ public:
                                    qreal softnessFactor,
                                    QRect *dstDabRect);
 
+    /**
+     * Returns true if the dabs painted with \p colorSource can be
+     * generated in a batch with queueDab()/fetchQueuedDabs(). Only
+     * the auto brush dabs of a uniform color without any
+     * postprocessing can be generated concurrently.
+     */
+    bool canQueueDabs(const KisColorSource *colorSource);
+
+    /**
+     * Adds a dab to the batch of dabs to be generated. The position of
+     * the dab and its cache parameters are calculated right away, so
+     * the dabs should be queued in the order of the stroke.
+     */
+    void queueDab(const KoColorSpace *cs,
+                  const KisColorSource *colorSource,
+                  const QPointF &cursorPoint,
+                  KisDabShape const&,
+                  const KisPaintInformation& info,
+                  qreal softnessFactor);
+
+    int numQueuedDabs() const;
+
+    /**
+     * Generates all the queued dabs in the global thread pool and
+     * returns them in the order they were queued. Each of the worker
+     * threads uses its own clone of the brush, since the brush
+     * changes its state while generating a mask. The dabs that match
+     * the previous dab within the precision level are not generated
+     * at all, the previous dab is reused instead, just like in
+     * fetchDab().
+     */
+    void fetchQueuedDabs(QVector<KisFixedPaintDeviceSP> *dabs,
+                         QVector<QRect> *dabRects);
 
 private:
     struct SavedDabParameters;
     struct DabPosition;
+    struct CachedDab;
+    struct QueuedDab;
+    struct QueuedDabGenerator;
 private:
+    inline int precisionLevel() const;
+
     inline SavedDabParameters getDabParameters(const KoColor& color,
             KisDabShape const&,
             const KisPaintInformation& info,
@@ -107,7 +163,13 @@ private:
     QRect correctDabRectWhenFetchedFromCache(const QRect &dabRect,
             const QSize &realDabSize);
 
-    inline KisFixedPaintDeviceSP tryFetchFromCache(const SavedDabParameters &params,
+    inline KisFixedPaintDeviceSP findCachedDab(const KoColorSpace *cs,
+            const SavedDabParameters &params);
+
+    inline void addCachedDab(KisFixedPaintDeviceSP dab,
+                             const SavedDabParameters &params);
+
+    inline KisFixedPaintDeviceSP postProcessCachedDab(KisFixedPaintDeviceSP dab,
             const KisPaintInformation& info,
             QRect *dstDabRect);
 
@@ -124,6 +186,8 @@ private:
                         const QPoint &dabTopLeft,
                         const KisPaintInformation& info);
 
+    void generateQueuedDab(QueuedDab *queuedDab);
+
 private:
 
     struct Private;
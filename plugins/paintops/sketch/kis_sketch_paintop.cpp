@@ -98,6 +98,16 @@ KisSketchPaintOp::~KisSketchPaintOp()
     delete m_dabCache;
 }
 
+qreal KisSketchPaintOp::dabCacheHitRate() const
+{
+    return m_dabCache->cacheHitRate();
+}
+
+qint64 KisSketchPaintOp::dabGenerationTime() const
+{
+    return m_dabCache->dabGenerationTime();
+}
+
 void KisSketchPaintOp::drawConnection(const QPointF& start, const QPointF& end, double lineWidth)
 {
     if (lineWidth == 1.0) {
@@ -49,6 +49,9 @@ public:
     void paintLine(const KisPaintInformation &pi1, const KisPaintInformation &pi2, KisDistanceInformation *currentDistance) override;
     KisSpacingInformation paintAt(const KisPaintInformation& info) override;
 
+    qreal dabCacheHitRate() const override;
+    qint64 dabGenerationTime() const override;
+
 private:
     // pixel buffer
     KisPaintDeviceSP m_dab;